@@ -0,0 +1,61 @@
+/*
+    Name:        example/backlog_bench.cpp
+    Purpose:     Benchmarks irc::backlog appends under a global memory budget
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <irc/backlog.hpp>
+
+int main( int argc, char **argv )
+{
+    const std::size_t channels = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 2000,
+                      appends  = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 1000000;
+
+    // A budget too small for every channel, so the coldest ones are dropped
+    irc::backlog_options opts;
+    opts.budget = 16 * 1024 * 1024;
+    irc::backlog log( opts );
+
+    std::vector<std::string> names, texts;
+    for( std::size_t i = 0; i < channels; ++i )
+        names.push_back( "#chan" + std::to_string( i ) );
+    for( std::size_t i = 0; i < 64; ++i )
+        texts.push_back( "message number " + std::to_string( i ) + " of the benchmark" +
+                         std::string( i * 3, 'x' ) );
+
+    std::size_t over = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( std::size_t i = 0; i < appends; ++i )
+    {
+        // Some channels are much busier than the others
+        std::size_t channel = i % 4 ? i % 32 : i * 7 % names.size();
+        log.append( names[channel], "nick", texts[i % texts.size()] );
+        over += log.memory() > opts.budget;
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(
+                         std::chrono::steady_clock::now() - start ).count() / appends;
+
+    std::cout << appends << " appends, " << elapsed << " ns/append, "
+              << log.channels() << " channels, " << log.memory() << " bytes, "
+              << log.stats().evicted_lines << " lines and "
+              << log.stats().evicted_channels << " channels evicted\n";
+
+    // The memory accounting must come back to nothing with the channels
+    for( const std::string &name : names )
+        log.erase( name );
+
+    if( over || log.memory() || log.channels() )
+    {
+        std::cerr << "Accounting error: " << over << " appends over budget, "
+                  << log.memory() << " bytes left in " << log.channels() << " channels\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+    Name:        example/coroutine.cpp
+    Purpose:     IRC client C++20 coroutine example
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <iostream>
+#include <irc/client.hpp>
+
+#if defined(BOOST_ASIO_HAS_CO_AWAIT)
+
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+using boost::asio::use_awaitable;
+
+boost::asio::awaitable<void> session( irc::client::ptr c, std::string host,
+                                      std::string port, std::string nick,
+                                      std::string channel )
+{
+    co_await c->async_connect( host, port, nick, use_awaitable );
+    std::cout << "################### Registered ###################\n";
+
+    co_await c->async_join( channel, use_awaitable );
+    std::cout << "################### Joined " << channel << " ###################\n";
+
+    for( ;; )
+    {
+        irc::message msg = co_await c->async_next_message(
+            []( const irc::message &m ) { return m.command() == "PRIVMSG"; },
+            use_awaitable );
+
+        std::cout << "<" << c->nickname_from( msg.sender() ) << "> "
+                  << msg.param(1) << '\n';
+    }
+}
+
+int main( int argc, char **argv )
+{
+    if( argc != 5 )
+    {
+        std::cerr << "Usage: irc_coroutine <host> <port> <nickname> <channel>\n";
+        return 1;
+    }
+
+    irc::io_service  io_service;
+    irc::client::ptr c = irc::client::create( io_service );
+
+    boost::asio::co_spawn( io_service,
+        session( c, argv[1], argv[2], argv[3], argv[4] ),
+        []( std::exception_ptr e )
+        {
+            try
+            {
+                if( e )
+                    std::rethrow_exception( e );
+            }
+            catch( std::exception &ex )
+            {
+                std::cerr << "Exception: " << ex.what() << '\n';
+            }
+        } );
+
+    io_service.run();
+    return 0;
+}
+
+#else
+
+int main()
+{
+    std::cerr << "This example requires C++20 coroutines\n";
+    return 1;
+}
+
+#endif
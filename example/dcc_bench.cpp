@@ -0,0 +1,181 @@
+/*
+    Name:        example/dcc_bench.cpp
+    Purpose:     Benchmarks DCC SEND over loopback, full and resumed transfers
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <irc/dcc.hpp>
+
+namespace {
+
+const char *source = "dcc_bench.src",
+           *target = "dcc_bench.copy";
+
+struct outcome
+{
+    boost::system::error_code sent,
+                              received;
+    irc::dcc_progress         progress;
+    double                    seconds;
+};
+
+bool same_files( const char *lhs, const char *rhs )
+{
+    std::ifstream a( lhs, std::ios::binary ), b( rhs, std::ios::binary );
+    std::vector<char> x( 1 << 16 ), y( 1 << 16 );
+    while( a && b )
+    {
+        a.read( x.data(), static_cast<std::streamsize>( x.size() ) );
+        b.read( y.data(), static_cast<std::streamsize>( y.size() ) );
+        if( a.gcount() != b.gcount() ||
+            !std::equal( x.begin(), x.begin() + a.gcount(), y.begin() ) )
+            return false;
+    }
+    return !a && !b;
+}
+
+// Sends the source to the target, resuming it when it is partial
+outcome transfer( irc::dcc_manager::ptr manager, boost::asio::io_service &io,
+                  std::uint64_t rate_limit )
+{
+    outcome result;
+    irc::dcc_options opts;
+    opts.rate_limit = rate_limit;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    irc::dcc_sender::ptr sender = manager->send( source,
+        boost::asio::ip::address_v4::loopback(),
+        [&result]( const boost::system::error_code &ec, const irc::dcc_progress & )
+        {
+            result.sent = ec;
+        }, opts );
+
+    // What the DCC SEND offer would carry
+    irc::dcc_request offer;
+    offer.type     = "SEND";
+    offer.filename = sender->filename();
+    offer.address  = "127.0.0.1";
+    offer.port     = sender->port();
+    offer.position = sender->progress().size;
+
+    irc::dcc_receiver::ptr receiver = manager->receive( offer, target,
+        [&result]( const boost::system::error_code &ec, const irc::dcc_progress &progress )
+        {
+            result.received = ec;
+            result.progress = progress;
+        });
+
+    // The DCC RESUME and ACCEPT exchange, without the IRC server in between
+    if( receiver && receiver->resume_position() )
+    {
+        manager->resume( offer.port, receiver->resume_position() );
+        manager->accept( offer.port, receiver->resume_position() );
+    }
+
+    io.run();
+    io.restart();
+    result.seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start ).count();
+    return result;
+}
+
+// A copy already there is not received again
+boost::system::error_code receive_existing( irc::dcc_manager::ptr manager,
+                                            boost::asio::io_service &io,
+                                            std::uint64_t size, bool &started )
+{
+    irc::dcc_request offer;
+    offer.type     = "SEND";
+    offer.filename = source;
+    offer.address  = "127.0.0.1";
+    offer.port     = 1;
+    offer.position = size;
+
+    boost::system::error_code result = boost::asio::error::would_block;
+    started = !!manager->receive( offer, target,
+        [&result]( const boost::system::error_code &ec, const irc::dcc_progress & )
+        {
+            result = ec;
+        });
+
+    io.run();
+    io.restart();
+    return result;
+}
+
+} // namespace
+
+int main( int argc, char **argv )
+{
+    // Above 4096 MiB the receiver's 32 bit acknowledgements wrap around
+    const std::uint64_t size = ( argc > 1 ? std::strtoull( argv[1], nullptr, 10 ) : 64 ) << 20,
+                        rate = argc > 2 ? std::strtoull( argv[2], nullptr, 10 ) << 20
+                                        : size / 2;
+    {
+        std::ofstream out( source, std::ios::binary | std::ios::trunc );
+        std::mt19937 random;
+        std::vector<std::uint32_t> block( 1 << 14 );
+        for( std::uint64_t written = 0; written < size; written += block.size() * 4 )
+        {
+            for( std::uint32_t &word : block )
+                word = random();
+            out.write( reinterpret_cast<const char *>( block.data() ),
+                       static_cast<std::streamsize>( std::min<std::uint64_t>(
+                           block.size() * 4, size - written ) ) );
+        }
+    }
+    std::remove( target );
+
+    boost::asio::io_service io;
+    irc::dcc_manager::ptr manager = irc::dcc_manager::create( io );
+    bool ok = true;
+
+    outcome full = transfer( manager, io, 0 );
+    std::cout << "full:    " << full.received.message() << ", " << size / full.seconds / 1e6
+              << " MB/s\n";
+    ok = !full.sent && !full.received && same_files( source, target ) &&
+         full.progress.transferred == size;
+
+    // Resumed from an odd position, under a rate limit
+    const std::uint64_t position = size / 3 + 1;
+    if( ::truncate( target, static_cast<off_t>( position ) ) != 0 )
+        return 1;
+
+    outcome resumed = transfer( manager, io, rate );
+    std::cout << "resumed: " << resumed.received.message() << " from " << position << ", "
+              << resumed.progress.rate / 1e6 << " MB/s under a "
+              << rate / 1e6 << " MB/s limit\n";
+    ok = ok && !resumed.sent && !resumed.received && same_files( source, target ) &&
+         resumed.progress.offset == position &&
+         resumed.progress.transferred == size - position &&
+         resumed.progress.rate < rate * 1.5;
+
+    bool started[2];
+    boost::system::error_code complete = receive_existing( manager, io, size, started[0] ),
+                              larger   = receive_existing( manager, io, size - 1, started[1] );
+    std::cout << "complete: " << complete.message() << ", larger: " << larger.message() << '\n';
+    ok = ok && !complete && larger == boost::asio::error::invalid_argument &&
+         !started[0] && !started[1];
+
+    const irc::dcc_stats &stats = manager->stats();
+    std::cout << stats.completed << " completed, " << stats.failed << " failed, "
+              << stats.bytes_sent << " bytes sent, " << stats.bytes_received << " received\n";
+
+    std::remove( source );
+    std::remove( target );
+    return ok && !stats.failed && !stats.active ? 0 : 1;
+}
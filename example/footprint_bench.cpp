@@ -0,0 +1,119 @@
+/*
+    Name:        example/footprint_bench.cpp
+    Purpose:     Measures the memory of idle registered irc::client connections
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <irc/client.hpp>
+
+namespace {
+
+// The server runs in a child process, so only the clients are measured
+void serve( unsigned short port, std::size_t clients, int ready )
+{
+    boost::asio::io_service io;
+    boost::asio::ip::tcp::acceptor acceptor( io, boost::asio::ip::tcp::endpoint(
+                                             boost::asio::ip::address_v4::loopback(), port ) );
+    char byte = 1;
+    if( ::write( ready, &byte, 1 ) != 1 )
+        return;
+
+    const std::string welcome = ":irc.example.net 001 bench :Welcome\r\n"
+                                ":irc.example.net 005 bench CHANTYPES=# PREFIX=(ov)@+ "
+                                "CASEMAPPING=rfc1459 :are supported by this server\r\n"
+                                ":irc.example.net 376 bench :End of MOTD\r\n";
+    std::vector<boost::asio::ip::tcp::socket> sockets;
+    sockets.reserve( clients );
+    for( std::size_t i = 0; i < clients; ++i )
+    {
+        sockets.emplace_back( io );
+        acceptor.accept( sockets.back() );
+        boost::asio::write( sockets.back(), boost::asio::buffer( welcome ) );
+    }
+    // Keep the connections open until the parent is done
+    ::read( ready, &byte, 1 );
+}
+
+std::size_t heap_used()
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+} // namespace
+
+int main( int argc, char **argv )
+{
+    const std::size_t clients = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 1000,
+                      budget  = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 4096;
+    const unsigned short port = 16690;
+
+    rlimit limit = { clients + 64, clients + 64 };
+    setrlimit( RLIMIT_NOFILE, &limit );
+
+    int pipes[2];
+    if( ::pipe( pipes ) != 0 )
+        return 1;
+
+    pid_t child = fork();
+    if( child == 0 )
+    {
+        serve( port, clients, pipes[1] );
+        _exit( 0 );
+    }
+
+    char byte;
+    if( ::read( pipes[0], &byte, 1 ) != 1 )
+        return 1;
+
+    boost::asio::io_service io;
+    std::vector<irc::client::ptr> list;
+    list.reserve( clients );
+
+    // A first client warms up the io_service and the library statics
+    irc::client::ptr warm = irc::client::create( io );
+    warm->connect( "127.0.0.1", std::to_string( port ), "bench" );
+    io.run_for( std::chrono::milliseconds( 200 ) );
+    io.restart();
+
+    std::size_t before = heap_used();
+    for( std::size_t i = 0; i < clients; ++i )
+    {
+        list.push_back( irc::client::create( io ) );
+        list.back()->connect( "127.0.0.1", std::to_string( port ), "bench" );
+    }
+    // Registered and idle: the welcome burst is read and handled
+    io.run_for( std::chrono::seconds( 2 ) );
+    std::size_t after = heap_used();
+
+    std::size_t per_client = ( after - before ) / clients;
+    std::cout << clients << " idle clients\n"
+              << "sizeof(irc::client): " << sizeof(irc::client) << " bytes\n"
+              << "heap per client:     " << per_client << " bytes, including the object\n"
+              << "budget:              " << budget << " bytes\n";
+
+    for( irc::client::ptr &c : list )
+        c->disconnect();
+    warm->disconnect();
+    io.restart();
+    io.run_for( std::chrono::milliseconds( 200 ) );
+
+    ::close( pipes[0] );
+    ::close( pipes[1] );
+    kill( child, SIGTERM );
+    waitpid( child, nullptr, 0 );
+
+    return per_client <= budget ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+/*
+    Name:        example/logger_bench.cpp
+    Purpose:     Benchmarks irc::logger with several threads logging at once
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <irc/logger.hpp>
+
+namespace {
+
+// Every thread logs its share as fast as it can, the file is removed after
+bool run( irc::overflow_policy policy, std::size_t threads, std::size_t records )
+{
+    const std::string path = "logger_bench.log";
+    std::remove( path.c_str() );
+
+    irc::logger::options opts;
+    opts.overflow = policy;
+    irc::logger::ptr log = irc::logger::create( path, opts );
+
+    std::vector<std::thread> producers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( std::size_t t = 0; t < threads; ++t )
+        producers.emplace_back( [&log, t, records]
+        {
+            const std::string sender = "nick" + std::to_string( t );
+            for( std::size_t i = 0; i < records; ++i )
+                log->log( sender, "#chan", "message number " + std::to_string( i ) +
+                                           " of the benchmark" );
+        });
+
+    for( std::thread &producer : producers )
+        producer.join();
+
+    double queued = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start ).count();
+    log->stop();
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start ).count();
+
+    const std::size_t total = threads * records;
+    std::cout << ( policy == irc::overflow_policy::block ? "block: " : "drop:  " )
+              << total / queued / 1e6 << " M records/s queued, "
+              << log->written() / elapsed / 1e6 << " M records/s written, "
+              << log->written() << " written, " << log->dropped() << " dropped, "
+              << log->rotations() << " rotations\n";
+
+    std::remove( path.c_str() );
+    for( unsigned i = 1; i <= opts.max_files; ++i )
+        std::remove( ( path + "." + std::to_string( i ) ).c_str() );
+
+    if( log->error() )
+        std::cerr << "File error: " << log->error().message() << '\n';
+
+    // Nothing is lost: every record is either written or counted as dropped
+    return log->written() + log->dropped() == total &&
+           ( policy == irc::overflow_policy::drop || !log->dropped() );
+}
+
+} // namespace
+
+int main( int argc, char **argv )
+{
+    const std::size_t threads = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 4,
+                      records = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 250000;
+
+    bool ok = run( irc::overflow_policy::drop,  threads, records );
+    ok = run( irc::overflow_policy::block, threads, records ) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+/*
+    Name:        example/mask_bench.cpp
+    Purpose:     Benchmarks irc::mask_set against testing each mask in turn
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <irc/maskset.hpp>
+
+int main( int argc, char **argv )
+{
+    const std::size_t masks   = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 10000,
+                      lookups = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 100000;
+
+    // A ban list: mostly hosts and domains, some nicknames and idents
+    std::vector<std::string> list;
+    for( std::size_t i = 0; i < masks; ++i )
+    {
+        std::string n = std::to_string( i );
+        switch( i % 10 )
+        {
+            case 0:  list.push_back( "Spam" + n + "*!*@*" );              break;
+            case 1:  list.push_back( "*!~bot" + n + "@*" );               break;
+            case 2:
+            case 3:  list.push_back( "*!*@*.Dyn" + n + ".Example.NET" );  break;
+            case 4:  list.push_back( "*!*@10.0." + n + ".*" );            break;
+            default: list.push_back( "*!*@host-" + n + ".isp.example.com" );
+        }
+    }
+
+    std::vector<std::string> names;
+    for( std::size_t i = 0; i < 1000; ++i )
+    {
+        std::string n = std::to_string( i * 7 % ( masks ? masks : 1 ) );
+        switch( i % 4 )
+        {
+            case 0:  names.push_back( "someone!~user@host-" + n + ".isp.example.com" ); break;
+            case 1:  names.push_back( "other!ident@a.b.dyn" + n + ".example.net" );     break;
+            case 2:  names.push_back( "SPAM" + n + "x!u@clean.example.org" );           break;
+            default: names.push_back( "nobody!nobody@unlisted.example.org" );
+        }
+    }
+
+    irc::mask_set set;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( const std::string &mask : list )
+        set.add( mask );
+
+    double build = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start ).count();
+
+    std::size_t indexed = 0;
+    start = std::chrono::steady_clock::now();
+    for( std::size_t i = 0; i < lookups; ++i )
+        indexed += set.matches( names[i % names.size()] ).size();
+
+    double compiled = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start ).count() / lookups;
+
+    // Every mask in turn, normalized and folded beforehand as the set does,
+    // the name folded once per lookup into a reused buffer
+    for( std::string &mask : list )
+    {
+        mask = irc::normalize_mask( mask );
+        for( char &ch : mask )
+            ch = irc::fold_case( ch, irc::casemapping::rfc1459 );
+    }
+
+    std::size_t naive_lookups = lookups / 100 ? lookups / 100 : 1,
+                naive_hits    = 0,
+                check_hits    = 0;
+    std::string folded;
+    start = std::chrono::steady_clock::now();
+    for( std::size_t i = 0; i < naive_lookups; ++i )
+    {
+        folded.assign( names[i % names.size()] );
+        for( char &ch : folded )
+            ch = irc::fold_case( ch, irc::casemapping::rfc1459 );
+
+        for( const std::string &mask : list )
+            naive_hits += irc::detail::glob_match( mask, folded );
+    }
+
+    double naive = std::chrono::duration<double, std::nano>(
+                       std::chrono::steady_clock::now() - start ).count() / naive_lookups;
+
+    for( std::size_t i = 0; i < naive_lookups; ++i )
+        check_hits += set.matches( names[i % names.size()] ).size();
+
+    std::cout << masks << " masks, " << set.residual() << " residual, built in "
+              << build << " ms\n"
+              << "mask_set: " << compiled << " ns/lookup, " << indexed << " matches\n"
+              << "naive:    " << naive << " ns/lookup\n"
+              << "speedup:  " << naive / compiled << "x\n";
+
+    if( naive_hits != check_hits )
+    {
+        std::cerr << "Mismatch: " << naive_hits << " naive matches, "
+                  << check_hits << " indexed\n";
+        return 1;
+    }
+    return 0;
+}
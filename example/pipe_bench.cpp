@@ -0,0 +1,65 @@
+/*
+    Name:        example/pipe_bench.cpp
+    Purpose:     Benchmarks a whole irc::client over an in-process pipe
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+#include <irc/client.hpp>
+
+int main( int argc, char **argv )
+{
+    const std::size_t rounds = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 2000,
+                      lines  = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 100;
+
+    // The same bytes in the same chunks each run, without any socket
+    std::string chunk;
+    for( std::size_t i = 0; i < lines; ++i )
+        chunk += ":nick!user@host.example.com PRIVMSG #chan :message number " +
+                 std::to_string( i ) + " of the chunk\r\n";
+
+    boost::asio::io_service io;
+    irc::memory_pipe::ptr   pipe = irc::memory_pipe::create( io );
+    irc::client::ptr        c    = irc::client::create( io, irc::pipe_transport( pipe ) );
+
+    std::size_t received = 0,
+                written  = 0;
+    c->on_channel_msg( [&]( const std::string &, const std::string &, const std::string & )
+    {
+        ++received;
+    });
+    c->connect( "pipe", "", "bench" );
+    pipe->write( ":irc.example.net 001 bench :Welcome\r\n" );
+    io.poll();
+
+    std::string from_client;
+    pipe->read( from_client );
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( std::size_t round = 0; round < rounds; ++round )
+    {
+        pipe->write( chunk );
+        written += chunk.size();
+        io.restart();
+        io.poll();
+    }
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start ).count();
+
+    std::cout << "client registration:\n" << from_client
+              << received << " messages, " << written << " bytes in "
+              << elapsed * 1000 << " ms\n"
+              << received / elapsed / 1e6 << " M messages/s, "
+              << elapsed * 1e9 / received << " ns/message\n";
+
+    c->disconnect();
+    io.restart();
+    io.poll();
+    return received == rounds * lines ? 0 : 1;
+}
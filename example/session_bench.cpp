@@ -0,0 +1,98 @@
+/*
+    Name:        example/session_bench.cpp
+    Purpose:     Benchmarks irc::session in memory, without any socket
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <irc/session.hpp>
+
+// Counts the heap allocations, to show none happens per line
+static std::atomic<std::size_t> allocations( 0 );
+
+void *operator new( std::size_t size )
+{
+    ++allocations;
+    if( void *p = std::malloc( size ? size : 1 ) )
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete( void *p ) noexcept { std::free( p ); }
+void operator delete( void *p, std::size_t ) noexcept { std::free( p ); }
+
+int main( int argc, char **argv )
+{
+    const std::size_t rounds = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 20000,
+                      chunk  = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 1460;
+
+    // A busy channel, as a server sends it
+    const std::string stream =
+        ":nick1!~user@host-1.isp.example.com PRIVMSG #chan :hello there, how is it going?\r\n"
+        "@time=2026-10-18T10:00:00.000Z;msgid=abc :nick2!u@b.example.net PRIVMSG #chan :fine\r\n"
+        ":nick3!ident@10.0.0.3 JOIN #chan\r\n"
+        ":irc.example.net 353 me = #chan :@op +voice nick1 nick2 nick3 nick4 nick5\r\n"
+        ":nick4!x@y NOTICE #chan :a somewhat longer notice to make the line sizes vary a bit\r\n"
+        ":nick5!x@y MODE #chan +o nick1\r\n"
+        "PING :irc.example.net\r\n";
+
+    irc::session session;
+    irc::session::clock::time_point now = irc::session::clock::now();
+    session.identity( "me", "user", "real" );
+    session.start( now );
+
+    std::string       flight;
+    std::size_t       messages = 0,
+                      bytes    = 0,
+                      offset   = 0,
+                      warmed   = 0;
+    irc::message_view msg;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for( std::size_t round = 0; round < rounds; ++round )
+    {
+        // Once the output and its write buffer took turns, nothing is allocated
+        if( round == 2 )
+            warmed = allocations.load();
+
+        for( std::size_t left = stream.size(); left; )
+        {
+            std::size_t size;
+            char *data = session.prepare( 0, size );
+            size = std::min( { size, left, chunk } );
+            std::memcpy( data, stream.data() + offset, size );
+            session.commit( size, now );
+
+            offset = ( offset + size ) % stream.size();
+            left  -= size;
+            bytes += size;
+
+            while( session.next( msg ) != irc::session_event::none )
+                ++messages;
+        }
+
+        // The PONGs are written out
+        session.take_output( flight );
+    }
+
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start ).count();
+
+    std::cout << messages << " messages, " << bytes << " bytes in "
+              << elapsed * 1000 << " ms\n"
+              << messages / elapsed / 1e6 << " M messages/s, "
+              << bytes / elapsed / 1e6 << " MB/s, "
+              << elapsed * 1e9 / messages << " ns/message\n"
+              << "allocations after two rounds: " << allocations.load() - warmed << '\n';
+    return 0;
+}
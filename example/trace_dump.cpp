@@ -0,0 +1,43 @@
+/*
+    Name:        example/trace_dump.cpp
+    Purpose:     Decodes a saved irc::trace_ring into text or Chrome trace JSON
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <irc/trace.hpp>
+
+int main( int argc, char **argv )
+{
+    bool chrome = argc == 3 && std::string( argv[1] ) == "--chrome";
+    if( argc != 2 && !chrome )
+    {
+        std::cerr << "Usage: trace_dump [--chrome] <trace file>\n";
+        return 1;
+    }
+
+    std::ifstream in( argv[argc - 1], std::ios::binary );
+    if( !in )
+    {
+        std::cerr << "Cannot open " << argv[argc - 1] << '\n';
+        return 1;
+    }
+
+    std::vector<irc::trace_record> records = irc::trace_ring::load( in );
+    if( records.empty() )
+    {
+        std::cerr << "No trace records found\n";
+        return 1;
+    }
+
+    if( chrome )
+        irc::trace_ring::dump_chrome( std::cout, records );
+    else
+        irc::trace_ring::dump_text( std::cout, records );
+
+    return 0;
+}
@@ -0,0 +1,141 @@
+/*
+    Name:        example/uring_bench.cpp
+    Purpose:     Compares the reactor and io_uring with many busy connections
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <irc/client.hpp>
+
+#ifndef IRC_CLIENT_HAS_IO_URING
+    #error "Build with -DIRC_CLIENT_HAS_IO_URING"
+#endif
+
+namespace {
+
+// The server runs in a child process and floods every client with channel messages
+void serve( unsigned short port, std::size_t clients, std::size_t lines, int ready )
+{
+    boost::asio::io_service io;
+    boost::asio::ip::tcp::acceptor acceptor( io, boost::asio::ip::tcp::endpoint(
+                                             boost::asio::ip::address_v4::loopback(), port ) );
+    char byte = 1;
+    if( ::write( ready, &byte, 1 ) != 1 )
+        return;
+
+    std::string flood = ":irc.example.net 001 bench :Welcome\r\n";
+    for( std::size_t i = 0; i < lines; ++i )
+        flood += ":nick!user@host.example.com PRIVMSG #chan :message number " +
+                 std::to_string( i ) + " of the flood\r\n";
+
+    std::vector<boost::asio::ip::tcp::socket> sockets;
+    sockets.reserve( clients );
+    for( std::size_t i = 0; i < clients; ++i )
+    {
+        sockets.emplace_back( io );
+        acceptor.accept( sockets.back() );
+    }
+    for( boost::asio::ip::tcp::socket &socket : sockets )
+        boost::asio::async_write( socket, boost::asio::buffer( flood ),
+                                  []( const boost::system::error_code &, std::size_t ) {} );
+    io.run();
+
+    // Keep the connections open until the parent is done
+    pause();
+}
+
+double cpu_seconds()
+{
+    rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+           ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) / 1e6;
+}
+
+void run( bool uring, unsigned short port, std::size_t clients, std::size_t lines )
+{
+    int pipes[2];
+    if( ::pipe( pipes ) != 0 )
+        return;
+
+    pid_t child = fork();
+    if( child == 0 )
+    {
+        serve( port, clients, lines, pipes[1] );
+        _exit( 0 );
+    }
+
+    char byte;
+    if( ::read( pipes[0], &byte, 1 ) != 1 )
+        return;
+
+    boost::asio::io_service    io;
+    irc::uring_service::ptr    service;
+    std::vector<irc::client::ptr> list;
+    std::size_t received = 0,
+                expected = clients * lines;
+
+    if( uring )
+        service = irc::uring_service::create( io );
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    double cpu = cpu_seconds();
+    for( std::size_t i = 0; i < clients; ++i )
+    {
+        irc::client::ptr c = irc::client::create( io );
+        c->uring( service );
+        c->on_channel_msg( [&]( const std::string &, const std::string &, const std::string & )
+        {
+            if( ++received == expected )
+                for( irc::client::ptr &each : list )
+                    each->disconnect();
+        });
+        c->connect( "127.0.0.1", std::to_string( port ), "bench" );
+        list.push_back( c );
+    }
+    io.run_for( std::chrono::seconds( 60 ) );
+
+    double elapsed = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start ).count();
+    cpu = cpu_seconds() - cpu;
+
+    std::cout << ( uring ? "io_uring: " : "reactor:  " )
+              << received << " messages in " << elapsed * 1000 << " ms, "
+              << received / elapsed / 1e6 << " M messages/s, "
+              << cpu * 1e9 / received << " CPU ns/message";
+    if( service )
+        std::cout << ", " << service->stats().enters << " io_uring_enter for "
+                  << service->stats().completions << " completions";
+    std::cout << '\n';
+
+    ::close( pipes[0] );
+    ::close( pipes[1] );
+    kill( child, SIGTERM );
+    waitpid( child, nullptr, 0 );
+}
+
+} // namespace
+
+int main( int argc, char **argv )
+{
+    const std::size_t clients = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 500,
+                      lines   = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 2000;
+
+    rlimit limit = { clients + 64, clients + 64 };
+    setrlimit( RLIMIT_NOFILE, &limit );
+
+    run( false, 16691, clients, lines );
+    run( true,  16692, clients, lines );
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+    Name:        irc/backlog.hpp
+    Purpose:     Bounded per channel message backlog
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_BACKLOG_HPP
+#define IRC_BACKLOG_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include "irc/isupport.hpp"
+
+namespace irc {
+
+/** Backlog limits. */
+struct backlog_options
+{
+    backlog_options()
+    :   max_lines(200),
+        max_bytes(32768),
+        budget(64 * 1024 * 1024)
+    {}
+
+    std::size_t max_lines; /**< Lines kept per channel. */
+    std::size_t max_bytes; /**< Senders and texts bytes kept per channel. */
+    std::size_t budget;    /**< Memory of all the channels, the least recently
+                                active channels are dropped beyond it. */
+};
+
+/** A backlog line, the views are valid until the next append(). */
+struct backlog_line
+{
+    std::chrono::system_clock::time_point time;   /**< When the line was received. */
+    boost::string_view                    sender; /**< The sender nickname. */
+    boost::string_view                    text;   /**< The message text. */
+};
+
+/** Backlog counters. */
+struct backlog_stats
+{
+    backlog_stats()
+    :   appended(0),
+        evicted_lines(0),
+        evicted_channels(0)
+    {}
+
+    std::uint64_t appended,         /**< Lines appended. */
+                  evicted_lines,    /**< Lines dropped by the per channel limits. */
+                  evicted_channels; /**< Channels dropped by the memory budget. */
+};
+/**
+    @class backlog
+
+    Keeps the last lines of each channel within per channel limits and a
+    global memory budget.
+
+    Each channel owns a slab, a ring of bytes where every line stores its
+    sender and text contiguously, and a ring of fixed size line headers
+    with the timestamp and the slab offsets. A line never wraps around the
+    slab end, so it is read as views without copying. Slabs start small
+    and grow up to max_bytes. When the budget is exceeded, whole channels
+    are dropped, the least recently active first.
+
+    Not thread safe, a client's backlog is read from its handlers.
+*/
+class backlog : private boost::noncopyable
+{
+public:
+    typedef std::chrono::system_clock clock;
+/**
+    Constructor.
+    @param opts    The limits.
+    @param mapping The channel names case mapping rules.
+*/
+    explicit backlog( const backlog_options &opts = backlog_options(),
+                      casemapping mapping = casemapping::rfc1459 );
+/**
+    Appends a line to a channel backlog, dropping the oldest lines beyond
+    the channel limits. A text longer than max_bytes is truncated.
+    @param channel The channel name.
+    @param sender  The sender nickname.
+    @param text    The message text.
+    @param time    When the line was received.
+*/
+    void append( boost::string_view channel, boost::string_view sender,
+                 boost::string_view text, clock::time_point time = clock::now() );
+/**
+    Calls a function for the lines of a channel, oldest first.
+    @param channel The channel name.
+    @param func    The function, as void(const backlog_line &).
+    @param last    The number of newest lines to visit, 0 for all of them.
+    @return The number of lines visited.
+*/
+    template< typename Func >
+    std::size_t for_each( boost::string_view channel, Func func, std::size_t last = 0 ) const;
+/**
+    Returns the number of lines of a channel.
+    @param channel The channel name.
+    @return The number of lines kept.
+*/
+    std::size_t lines( boost::string_view channel ) const;
+/**
+    Drops the backlog of a channel.
+    @param channel The channel name.
+*/
+    void erase( boost::string_view channel );
+/** Drops all the backlogs. */
+    void clear();
+/**
+    Changes the case mapping of the channel names.
+    @param mapping The new case mapping rules.
+*/
+    void mapping( casemapping mapping );
+/** @return The number of channels with a backlog. */
+    std::size_t channels() const { return m_channels.size(); }
+/** @return The memory used by the backlogs, in bytes. */
+    std::size_t memory() const { return m_memory; }
+/** @return The limits. */
+    const backlog_options &options() const { return m_options; }
+/** @return The counters. */
+    const backlog_stats &stats() const { return m_stats; }
+
+private:
+    struct header
+    {
+        clock::time_point time;
+        std::uint32_t     offset;
+        std::uint16_t     sender,  // Lengths, the text follows the sender
+                          text;
+    };
+
+    struct ring
+    {
+        std::string         name;
+        std::vector<char>   slab;
+        std::vector<header> headers; // Circular, max_lines at most
+        std::size_t         first,   // Oldest header
+                            count,
+                            bytes,   // Used in slab
+                            write;   // Next slab offset
+    };
+
+    typedef std::list<ring>                                    lru_list; // Most recent first
+    typedef std::unordered_map<std::string, lru_list::iterator> index_map;
+
+    std::string key( boost::string_view channel ) const;
+    const ring *find( boost::string_view channel ) const;
+    void pop( ring &r );
+    // Reallocates the slab and the headers, the lines moved to their start
+    void reshape( ring &r, std::size_t slab, std::size_t headers );
+    void drop( lru_list::iterator it );
+    static std::size_t footprint( const ring &r );
+
+    backlog_options m_options;
+    backlog_stats   m_stats;
+    casemapping     m_mapping;
+    lru_list        m_lru;
+    index_map       m_channels;
+    std::size_t     m_memory;
+};
+
+template< typename Func >
+std::size_t backlog::for_each( boost::string_view channel, Func func, std::size_t last ) const
+{
+    const ring *r = find( channel );
+    if( !r )
+        return 0;
+
+    std::size_t skip = last && last < r->count ? r->count - last : 0;
+    for( std::size_t i = skip; i < r->count; ++i )
+    {
+        const header &h    = r->headers[ ( r->first + i ) % r->headers.size() ];
+        const char   *data = r->slab.data() + h.offset;
+        backlog_line line  = { h.time, boost::string_view( data, h.sender ),
+                               boost::string_view( data + h.sender, h.text ) };
+        func( line );
+    }
+    return r->count - skip;
+}
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/backlog.ipp"
+#endif
+
+#endif // IRC_BACKLOG_HPP
@@ -9,17 +9,47 @@
 #ifndef IRC_CLIENT_HPP
 #define IRC_CLIENT_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <limits>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/format.hpp>
 #include <boost/system/error_code.hpp>
 
+#include "irc/backlog.hpp"
+#include "irc/ctcp.hpp"
+#include "irc/dcc.hpp"
+#include "irc/delivery.hpp"
 #include "irc/error.hpp"
+#include "irc/event_bus.hpp"
+#include "irc/flow.hpp"
+#include "irc/hostmask.hpp"
+#include "irc/isupport.hpp"
+#include "irc/message.hpp"
 #include "irc/numeric.hpp"
+#include "irc/packer.hpp"
+#include "irc/registration.hpp"
+#include "irc/reply.hpp"
+#include "irc/session.hpp"
+#include "irc/trace.hpp"
+#include "irc/transport.hpp"
+#include "irc/trigger.hpp"
+#include "irc/worker_pool.hpp"
+#ifdef IRC_CLIENT_HAS_IO_URING
+    #include "irc/uring.hpp"
+#endif
+#include "irc/detail/buffer_pool.hpp"
+#include "irc/detail/request.hpp"
+#include "irc/detail/waiter.hpp"
+#include "irc/detail/write_op.hpp"
 
 namespace ph = std::placeholders;
 
@@ -32,31 +62,79 @@ typedef boost::asio::ip::tcp::resolver resolver;
 typedef boost::asio::ip::tcp::socket   socket;
 typedef boost::asio::streambuf         streambuf;
 
-const int max_params = 15; /**< RFC 2812: maximum parameters allowed */
+/** Message events with many subscribers, see client::subscribe(). */
+enum class message_event : std::uint8_t
+{
+    channel_msg    = 0, /**< Keyed by channel. */
+    private_msg    = 1, /**< Keyed by sender nickname. */
+    channel_notice = 2, /**< Keyed by channel. */
+    private_notice = 3, /**< Keyed by sender nickname. */
+    invite         = 4  /**< Keyed by sender nickname. */
+};
 /**
     @class client
 
     IRC Client class.
+
+    The protocol itself, line framing, registration, PINGs and keepalive,
+    is an irc::session: the client reads and writes its bytes on a socket,
+    arms its deadline and hands its messages to the handlers.
+
+    An idle registered connection costs about 3.6 KB, object included,
+    as measured by example/footprint_bench.cpp on Linux x86-64: handlers,
+    ISUPPORT snapshots and the read and write buffers are shared or pooled,
+    the DCC manager, the triggers and the prefix cache are allocated when
+    first used.
 */
 class client: public std::enable_shared_from_this< client >
-            , public boost::asio::coroutine
             , boost::noncopyable
 {
 public:
 /** Shared client pointer */
     typedef std::shared_ptr< client > ptr;
+/**
+    Message events subscribers, called with the sender nickname, the target
+    and the text, as the signal handlers of the same events.
+*/
+    typedef event_bus< void(const std::string &,
+                            const std::string &,
+                            const std::string &) > message_bus;
+/** CTCP request handler, called with the sender nickname, the target and the arguments. */
+    typedef std::function<void(const std::string &,
+                               const std::string &,
+                               const std::string &)> ctcp_handler;
+/**
+    Trigger handler, called with the sender nickname, the target, the message
+    and the offset of the trigger literal in the message.
+*/
+    typedef std::function<void(const std::string &,
+                               const std::string &,
+                               const std::string &,
+                               std::size_t)> trigger_handler;
 /**
     Static constructor.
     @param io_service Reference to the ASIO io_service controller.
     @return Shared pointer to a new client object.
 */
     static ptr create( io_service &io_service );
+/**
+    Static constructor, for another transport than TCP:
+    @code
+    irc::client::ptr c = irc::client::create( io, irc::unix_transport( io ) );
+    c->connect( "/run/bouncer/irc.sock", "", "nick" );
+    @endcode
+    @param io_service Reference to the ASIO io_service controller.
+    @param transport  The transport of the connections, see irc::transport.
+    @return Shared pointer to a new client object.
+*/
+    static ptr create( io_service &io_service, transport transport );
 
 /** Destructor. */
     ~client();
 /**
     Connects to an irc server via IPV4.
-    @param hostname Server hostname to connect to.
+    @param hostname Server hostname to connect to, the socket path with a
+                    unix_transport, unused with a pipe_transport.
     @param port     Server port to connect to.
     @param nickname Nick name for the client connection.
     @param username User name for the client connection.
@@ -69,6 +147,270 @@ public:
                   const std::string &username = "nobody",
                   const std::string &realname = "noname",
                   const std::string &srv_pwrd = std::string() );
+/**
+    Connects to an irc server and registers, asynchronously.
+    Completes when the server welcomes the client (RPL_WELCOME) or refuses
+    the registration, the error is then in the irc::reply_category().
+    Any asio completion token can be used, boost::asio::use_awaitable
+    included where C++20 coroutines are available:
+    @code
+    co_await c->async_connect( "irc.example.net", "6667", "nick", use_awaitable );
+    @endcode
+    @param hostname Server hostname to connect to.
+    @param port     Server port to connect to.
+    @param nickname Nick name for the client connection.
+    @param token    The completion token, the signature is void(system_error_code).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code) )
+    async_connect( const std::string &hostname,
+                   const std::string &port,
+                   const std::string &nickname,
+                   CompletionToken &&token )
+    {
+        return async_connect( hostname, port, nickname, "nobody", "noname",
+                              std::string(), std::forward<CompletionToken>( token ) );
+    }
+/**
+    Connects to an irc server and registers, asynchronously.
+    @param hostname Server hostname to connect to.
+    @param port     Server port to connect to.
+    @param nickname Nick name for the client connection.
+    @param username User name for the client connection.
+    @param realname Real name for the client connection.
+    @param srv_pwrd Password to login to a server that requires a key.
+    @param token    The completion token, the signature is void(system_error_code).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code) )
+    async_connect( const std::string &hostname,
+                   const std::string &port,
+                   const std::string &nickname,
+                   const std::string &username,
+                   const std::string &realname,
+                   const std::string &srv_pwrd,
+                   CompletionToken &&token )
+    {
+        static const int failures[] = { 431, 432, 433, 436, 437, 464, 465 };
+        detail::reply_matcher matcher = { reply_code::RPL_WELCOME,
+                                          failures, sizeof(failures) / sizeof(int),
+                                          std::string(), true, casemapping::rfc1459 };
+        m_session.identity( nickname, username, realname );
+
+        return boost::asio::async_initiate< CompletionToken, void(system_error_code) >(
+            initiate_wait(), token, shared_from_this(), std::move( matcher ),
+            connect_request( hostname, port, srv_pwrd ) );
+    }
+/**
+    Waits for the next incoming message accepted by a filter.
+    Messages are only matched while the operation is pending,
+    the existing callbacks are still called for every message.
+    @code
+    irc::message msg = co_await c->async_next_message(
+        []( const irc::message &m ) { return m.command() == "PRIVMSG"; }, use_awaitable );
+    @endcode
+    @param filter A bool(const message &) function object.
+    @param token  The completion token, the signature is void(system_error_code, message).
+*/
+    template< typename Filter, typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code, message) )
+    async_next_message( Filter filter, CompletionToken &&token )
+    {
+        detail::message_matcher< Filter > matcher = { std::move( filter ) };
+
+        return boost::asio::async_initiate< CompletionToken,
+                                            void(system_error_code, message) >(
+            initiate_wait(), token, shared_from_this(), std::move( matcher ),
+            std::string() );
+    }
+/**
+    Waits for the next incoming message.
+    @param token The completion token, the signature is void(system_error_code, message).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code, message) )
+    async_next_message( CompletionToken &&token )
+    {
+        return async_next_message( detail::any_message(),
+                                   std::forward<CompletionToken>( token ) );
+    }
+/**
+    Joins a channel and waits for the end of its names list (RPL_ENDOFNAMES).
+    A refused join completes with an error in the irc::reply_category().
+    @param channel The channel to join.
+    @param token   The completion token, the signature is void(system_error_code).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code) )
+    async_join( const std::string &channel, CompletionToken &&token )
+    {
+        static const int failures[] = { 403, 405, 471, 473, 474, 475, 476, 477 };
+        detail::reply_matcher matcher = { reply_code::RPL_ENDOFNAMES,
+                                          failures, sizeof(failures) / sizeof(int),
+                                          channel, false, m_isupport->casemap() };
+
+        return boost::asio::async_initiate< CompletionToken, void(system_error_code) >(
+            initiate_wait(), token, shared_from_this(), std::move( matcher ),
+            "JOIN " + channel );
+    }
+/**
+    Requests a channel's user list and collects the RPL_NAMREPLY run.
+    Requests are pipelined: any number can be pending, the server answers
+    them in order and each one is completed by its own end of reply.
+    A request not answered within request_timeout() completes with
+    boost::asio::error::timed_out.
+    @param channel The channel where users are in.
+    @param token   The completion token, the signature is
+                   void(system_error_code, names_reply).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code, names_reply) )
+    async_names( const std::string &channel, CompletionToken &&token )
+    {
+        detail::names_matcher matcher;
+        matcher.reply.channel = channel;
+        matcher.mapping       = m_isupport->casemap();
+
+        return boost::asio::async_initiate< CompletionToken,
+                                            void(system_error_code, names_reply) >(
+            initiate_wait(), token, shared_from_this(), std::move( matcher ),
+            "NAMES " + channel );
+    }
+/**
+    Requests an user's details and collects the WHOIS replies up to RPL_ENDOFWHOIS.
+    An unknown nickname completes with ERR_NOSUCHNICK in the irc::reply_category().
+    @param nickname The user to look up.
+    @param token    The completion token, the signature is
+                    void(system_error_code, whois_reply).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code, whois_reply) )
+    async_whois( const std::string &nickname, CompletionToken &&token )
+    {
+        detail::whois_matcher matcher;
+        matcher.reply.nickname = nickname;
+        matcher.mapping        = m_isupport->casemap();
+
+        return boost::asio::async_initiate< CompletionToken,
+                                            void(system_error_code, whois_reply) >(
+            initiate_wait(), token, shared_from_this(), std::move( matcher ),
+            "WHOIS " + nickname );
+    }
+/**
+    Requests a list of channel details and collects the RPL_LIST run.
+    @param channels A comma separated list of channels from which to list details.
+                    If empty, all server's channels will be listed.
+    @param token    The completion token, the signature is
+                    void(system_error_code, list_reply).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code, list_reply) )
+    async_list( const std::string &channels, CompletionToken &&token )
+    {
+        return boost::asio::async_initiate< CompletionToken,
+                                            void(system_error_code, list_reply) >(
+            initiate_wait(), token, shared_from_this(), detail::list_matcher(),
+            channels.empty() ? std::string("LIST") : "LIST " + channels );
+    }
+/**
+    Requests a channel's modes (RPL_CHANNELMODEIS and RPL_CREATIONTIME).
+    RPL_CREATIONTIME is optional: without it the reply completes with the
+    next line received, or at the request deadline, created being 0.
+    @param channel The channel to query.
+    @param token   The completion token, the signature is
+                   void(system_error_code, mode_reply).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code, mode_reply) )
+    async_mode( const std::string &channel, CompletionToken &&token )
+    {
+        detail::mode_matcher matcher;
+        matcher.reply.channel = channel;
+        matcher.mapping       = m_isupport->casemap();
+
+        return boost::asio::async_initiate< CompletionToken,
+                                            void(system_error_code, mode_reply) >(
+            initiate_wait(), token, shared_from_this(), std::move( matcher ),
+            "MODE " + channel );
+    }
+/**
+    Sets the deadline of the requests issued from now on.
+    @param timeout Time allowed to the server to answer a request, 30 seconds by default.
+*/
+    void request_timeout( std::chrono::milliseconds timeout ) { m_request_timeout = timeout; }
+/**
+    Sets how the next connections register. PASS, CAP LS 302 and CAP REQ
+    when capabilities or SASL are asked for, NICK and USER are sent in one
+    write once connected, without waiting for the server. SASL PLAIN
+    starts when the server acknowledges it and a nickname in use is
+    replaced by the alternates before any handler or async_connect() sees
+    the error.
+    @param opts The registration options.
+*/
+    void registration( const registration_options &opts ) { m_session.registration( opts ); }
+/** @return The registration options. */
+    const registration_options &registration() const { return m_session.registration(); }
+/** @return The timings of the last registration, the connect to RPL_WELCOME latency included. */
+    const registration_stats &last_registration() const { return m_session.stats(); }
+/**
+    Tells if a capability was acknowledged by the server.
+    @param name The capability name.
+    @return @true if enabled on this connection.
+*/
+    bool capability( boost::string_view name ) const { return m_session.capability( name ); }
+/** @return The nickname, the one accepted by the server once registered. */
+    const std::string &nickname() const { return m_session.nickname(); }
+/**
+    Sets the keepalive of the next connections: a PING is sent when the
+    server is silent for interval, and the client disconnects when it
+    stays silent timeout more. Disabled by default.
+    @param interval The idle time before a PING, zero to disable.
+    @param timeout  The time allowed to answer, interval if zero.
+*/
+    void keepalive( std::chrono::milliseconds interval,
+                    std::chrono::milliseconds timeout = std::chrono::milliseconds::zero() )
+    {
+        m_session.keepalive( interval, timeout );
+    }
+/** @return The protocol state of the connection, to be read from the client's thread. */
+    const session &protocol() const { return m_session; }
+/**
+    Returns the features advertised by the server with RPL_ISUPPORT (005).
+    The table is never modified once published: each RPL_ISUPPORT reply,
+    usually sent during the registration only, replaces it as a whole,
+    so a snapshot can be kept and read without locks.
+    Before the server sends it, it holds the RFC 2812 defaults.
+    @return The current features table.
+*/
+    isupport::ptr server_support() const { return m_isupport; }
+/**
+    Keeps the last messages and notices of each channel, within limits.
+    Calling it again replaces the backlog, dropping its lines.
+    @param opts The per channel limits and the global memory budget.
+*/
+    void keep_backlog( const backlog_options &opts = backlog_options() )
+    {
+        m_backlog.reset( new backlog( opts, m_isupport->casemap() ) );
+    }
+/** Stops keeping the channels backlog, dropping its lines. */
+    void drop_backlog() { m_backlog.reset(); }
+/**
+    Returns the channels backlog, to be read from handlers.
+    @return The backlog, nullptr unless keep_backlog() was called.
+*/
+    const backlog *channel_backlog() const { return m_backlog.get(); }
+/**
+    Returns the prefix of the message being handled, split in nickname,
+    username and hostname. Handlers read it instead of parsing the sender
+    again; the views are valid until the handler returns.
+    @return The sender of the current message, empty if none.
+*/
+    const hostmask_view &current_sender() const { return m_sender; }
+/**
+    Returns the cache of parsed message prefixes, for its statistics.
+    @return The prefix cache.
+*/
+    const hostmask_cache &prefix_cache() const { return m_hostmasks; }
 /**
     Returns the connection state. 
     @return @true if connected, @false otherwise.
@@ -83,6 +425,31 @@ public:
     @param cmd_str The cmd_str string to send.
 */
     void send_raw( const std::string &cmd_str );
+/**
+    Sends a raw line and completes once it is written to the transport,
+    with the time elapsed since the call: producers can bound the lines in
+    flight and measure the send latency. A line dropped with a lost
+    connection completes with the error of the connection.
+    @code
+    std::future<std::chrono::steady_clock::duration> written =
+        c->async_send_raw( "PRIVMSG #chan :hello", boost::asio::use_future );
+    @endcode
+    @param cmd_str The line to send.
+    @param token   The completion token, the signature is
+                   void(system_error_code, std::chrono::steady_clock::duration).
+*/
+    template< typename CompletionToken >
+    BOOST_ASIO_INITFN_RESULT_TYPE( CompletionToken, void(system_error_code,
+                                                         std::chrono::steady_clock::duration) )
+    async_send_raw( const std::string &cmd_str, CompletionToken &&token )
+    {
+        return boost::asio::async_initiate< CompletionToken,
+                                            void(system_error_code,
+                                                 std::chrono::steady_clock::duration) >(
+            initiate_send(), token, shared_from_this(), cmd_str );
+    }
+/** @return The counters of the lines sent. Call it from the client's thread. */
+    const delivery_stats &delivery() const { return m_delivery; }
 /**
     An user action, the typical /me cmd_str.
     @param destination A channel or nickname target to send the action message.
@@ -112,6 +479,14 @@ public:
     @param channel The channel to join.
 */
     void join( const std::string &channel );
+/**
+    Joins many channels, packed into the fewest JOIN lines allowed by
+    the server, queued together.
+    @param channels The channels to join.
+    @param keys     The channel keys, by index, empty or missing if none.
+*/
+    void join_all( const std::vector<std::string> &channels,
+                   const std::vector<std::string> &keys = std::vector<std::string>() );
 /**
     Kick someone from a channel.
     @param nickname The user to kick off.
@@ -126,6 +501,112 @@ public:
                     If not specified, all server's channels will be listed.
 */
     void list( const std::string &channels = std::string() );
+/**
+    Streams the channel list, one callback per RPL_LIST entry, without
+    buffering it. The user count filters are sent to the server as ELIST
+    conditions when its ISUPPORT advertises them, and are always applied
+    locally as well.
+    Returning @false from on_entry stops handling the received lines until
+    resume() is called. As with flow_control(), up to max_buffer bytes are
+    still read so that PINGs are answered, then the server is slowed down
+    by TCP.
+    While a stream is active it consumes the RPL_LIST replies, a second
+    stream completes at once with boost::asio::error::in_progress.
+    @param filter   The channels and user count filters.
+    @param on_entry Called for every entry, returns @false to pause.
+    @param on_end   Called once at RPL_LISTEND or on disconnection.
+*/
+    void list_stream( const list_filter &filter,
+                      std::function<bool(const list_entry_view &)> on_entry,
+                      std::function<void(const system_error_code &)> on_end );
+/**
+    Resumes handling the received lines after a paused list_stream().
+*/
+    void resume();
+/**
+    Returns the reading state.
+    @return @true if a list_stream() is paused, @false otherwise.
+*/
+    bool paused() const { return m_read_paused; }
+/**
+    Enables read side flow control, for handlers which hand their work to
+    a slower stage. They hold() credit units for the work handed over and
+    the consumer release()s them once done. When high_water units are held,
+    the client stops handling the received lines until they drop back to
+    low_water. Meanwhile up to max_buffer bytes are still read, so PINGs
+    are answered and the connection is kept alive.
+    Call it from the client's thread.
+    @param opts The watermarks, a high_water of 0 disables flow control.
+*/
+    void flow_control( const flow_options &opts );
+/**
+    Takes credit units, called by a handler handing work downstream.
+    Reading pauses after the current line once high_water units are held.
+    Thread safe.
+    @param units The number of units taken.
+*/
+    void hold( std::size_t units = 1 ) { m_held.fetch_add( units ); }
+/**
+    Gives credit units back, called by the consumer of the work.
+    Reading resumes once low_water units or less are held.
+    Thread safe.
+    @param units The number of units given back, at most the held ones.
+*/
+    void release( std::size_t units = 1 );
+/** @return The credit units held. */
+    std::size_t held() const { return m_held.load(); }
+/** @return @true if the lines are not handled because of flow control. */
+    bool flow_paused() const { return m_flow_paused.load(); }
+/** @return The flow control counters. Call it from the client's thread. */
+    flow_stats flow() const;
+/**
+    Runs the message handlers on a worker pool rather than on the client's
+    thread, so a slow handler does not delay the PONG replies.
+    The channel messages, notices and triggers are ordered per channel,
+    the private ones, the actions and the invitations per sender, with
+    the names folded by the server case mapping. The other handlers still
+    run on the client's thread, and current_sender() is not valid from
+    the pool. Handlers may send commands, as privmsg(), join() or
+    send_raw(), which queue their lines to the client's thread; the other
+    functions, disconnect() included, are called from the client's thread.
+    Call it from the client's thread.
+    @param pool The worker pool, nullptr to run the handlers inline again.
+*/
+    void offload( worker_pool::ptr pool ) { m_workers = pool; }
+/** @return The worker pool running the message handlers, nullptr if none. */
+    const worker_pool::ptr &workers() const { return m_workers; }
+#ifdef IRC_CLIENT_HAS_IO_URING
+/**
+    Reads and writes the next connections through an io_uring shared with
+    other clients, instead of the io_service reactor. Resolving, connecting
+    and the timers stay on the io_service, which must be the service's one.
+    TLS and pipe transports keep using the reactor. Call it from the
+    client's thread.
+    @param service The uring service, nullptr to use the reactor again.
+*/
+    void uring( uring_service::ptr service ) { m_uring = service; }
+/** @return The uring service of the next connections, nullptr if none. */
+    const uring_service::ptr &uring() const { return m_uring; }
+#endif
+/**
+    Adds a subscriber to a message event, called after its signal handler.
+    Unlike the signals, any number of subscribers can listen to an event,
+    and a keyed subscriber is only called for its channel or nickname.
+    Call it from the client's thread, subscribers included.
+    @param event The event.
+    @param func  The subscriber.
+    @param key   The channel or the sender nickname, empty for all of them.
+    @return The subscription identifier, message_bus::npos if func is empty.
+*/
+    message_bus::id_type subscribe( message_event event, message_bus::handler_type func,
+                                    const std::string &key = std::string() );
+/**
+    Removes a subscriber, even while its event is being dispatched.
+    @param event The event it was subscribed to.
+    @param id    The subscription identifier.
+    @return @true if removed, @false if id is unknown.
+*/
+    bool unsubscribe( message_event event, message_bus::id_type id );
 /**
     Requests the channel's user list.
     @param channel The channel where users are in.
@@ -134,26 +615,54 @@ public:
 /**
     Returns a nickname string from a hostmask.
     @param hostmask The hostmask to convert from.
-    @return A nickname string.
+    @return A nickname string, empty for a server name.
 */
-    std::string nickname_from( const std::string &hostmask ) const;
+    std::string nickname_from( boost::string_view hostmask ) const;
 /**
     Sends a notice message to an user or channel.
     @param destination The user or channel where to send the message.
     @param message     The message to send as notice.
 */
     void notice( const std::string &destination, const std::string &message );
+/**
+    Sends a notice message to many users or channels, packed into the
+    fewest lines allowed by the server's TARGMAX, queued together.
+    @param destinations The users or channels where to send the message.
+    @param message      The message to send as notice.
+*/
+    void notice_all( const std::vector<std::string> &destinations, const std::string &message );
 /**
     Leaves a specified channel.
     @param channel The channel to leave.
 */
     void part( const std::string &channel );
+/**
+    Leaves many channels, packed into the fewest PART lines, queued together.
+    @param channels The channels to leave.
+    @param reason   The part reason (optional).
+*/
+    void part_all( const std::vector<std::string> &channels,
+                   const std::string &reason = std::string() );
 /**
     Sends a message to an user or channel.
     @param destination The user or channel where to send the message.
     @param message     The message to send.
 */
     void privmsg( const std::string &destination, const std::string &message );
+/**
+    Sends a message to many users or channels, packed into the fewest
+    lines allowed by the server's TARGMAX, queued together.
+    @param destinations The users or channels where to send the message.
+    @param message      The message to send.
+*/
+    void privmsg_all( const std::vector<std::string> &destinations, const std::string &message );
+/**
+    Changes channel modes, packed into the fewest MODE lines allowed by
+    the server's MODES, queued together.
+    @param channel The channel.
+    @param changes The mode changes, in order.
+*/
+    void set_modes( const std::string &channel, const std::vector<mode_change> &changes );
 /**
     Quits the client connection.
     @param reason The quit reason (optional).
@@ -171,6 +680,20 @@ public:
     @return The irc client version.
 */
     std::string version() const;
+/**
+    Enables or disables the binary trace of this client.
+    The ring is allocated the first time tracing is enabled and kept
+    until the client is destroyed, building with IRC_DEBUG enables it
+    at construction.
+    @param enable   @true to record trace events, @false to stop.
+    @param capacity Number of trace records, used on first allocation only.
+*/
+    void tracing( bool enable, std::size_t capacity = 4096 );
+/**
+    Returns the trace ring, to be saved or dumped after an incident.
+    @return The trace ring, nullptr if tracing was never enabled.
+*/
+    const trace_ring *trace() const { return m_trace.load( std::memory_order_acquire ); }
 /**
     Signal fired when a message was sent to a channel.
     @param func The function to call back.
@@ -179,7 +702,7 @@ public:
                                             const std::string &,
                                             const std::string &)> func )
     {
-        m_on_chanmsg = func;
+        handlers().on_chanmsg = func;
     }
 /**
     Signal fired when the connection was enstablished.
@@ -187,7 +710,7 @@ public:
 */
     void on_connected( std::function<void()> func )
     {
-        m_on_connected = func;
+        handlers().on_connected = func;
     }
 /**
     Signal fired when disconnected from the server.
@@ -195,7 +718,27 @@ public:
 */
     void on_disconnected( std::function<void()> func )
     {
-        m_on_disconnected = func;
+        handlers().on_disconnected = func;
+    }
+/**
+    Shares the signal handlers of another client instead of holding a copy,
+    for the many connections of a bouncer or a bot set up alike.
+    Setting a handler afterwards gives this client its own copy.
+    @param other The client whose handlers are used.
+*/
+    void share_handlers( const client &other )
+    {
+        m_handlers = other.m_handlers;
+    }
+/**
+    Signal fired for every line received, unknown commands included, before
+    any other handler. The message is parsed once and its views point into
+    the received line, they are only valid during the call.
+    @param func The function to call back.
+*/
+    void on_message( std::function<void(const message_view &)> func )
+    {
+        handlers().on_message = func;
     }
 /**
     Signal fired when a numeric reply is sent from the IRC server.
@@ -203,315 +746,1401 @@ public:
 */
     void on_numeric_reply( std::function<void(reply_code)> func )
     {
-        m_on_numeric = func;
+        handlers().on_numeric = func;
+    }
+/**
+    Registers the handler of a CTCP request, replacing the previous one.
+    PING, TIME, VERSION and CLIENTINFO are answered by default, ACTION and
+    DCC requests are passed to their own signals.
+    Requests that are answered are subject to the ctcp_limit() rates.
+    @param command The CTCP command, case insensitive.
+    @param func    The handler, an empty function unregisters the command.
+    @param replies @true if the handler replies, so it must be rate limited.
+*/
+    void on_ctcp( const std::string &command, ctcp_handler func, bool replies = true );
+/**
+    Registers a trigger on the channel and private messages.
+    All the triggers are found scanning each message once, the handlers of
+    the triggers found are called after the message signal.
+    @param literal The text to find.
+    @param func    The handler.
+    @param opts    Where the literal must appear and an optional regex to match.
+    @return The trigger identifier, trigger_set::npos if not valid.
+*/
+    trigger_set::id_type on_trigger( const std::string &literal, trigger_handler func,
+                                     const trigger_options &opts = trigger_options() );
+/**
+    Unregisters a trigger, it can be called from a trigger handler.
+    @param id The trigger identifier.
+*/
+    void remove_trigger( trigger_set::id_type id );
+/**
+    Sets the CTCP replies rate limits, global and per source host.
+    @param limits The new rate limits.
+*/
+    void ctcp_limit( const ctcp_limits &limits ) { m_ctcp_limiter.limits( limits ); }
+/**
+    Returns the counters of answered and suppressed CTCP requests.
+    @return The CTCP requests counters.
+*/
+    const ctcp_stats &ctcp_statistics() const { return m_ctcp_limiter.stats(); }
+/**
+    Offers a file to an user with DCC SEND and waits for the transfer.
+    The receiver may ask to resume it with DCC RESUME before connecting,
+    this is accepted automatically.
+    @param nickname The user to send the file to.
+    @param path     The file to send.
+    @param func     The completion handler.
+    @param opts     The transfer settings.
+    @return The transfer, nullptr if it could not start.
+*/
+    dcc_sender::ptr dcc_send( const std::string &nickname, const std::string &path,
+                              dcc_transfer::handler func,
+                              const dcc_options &opts = dcc_options() );
+/**
+    Accepts a DCC SEND offer received through on_dcc_send().
+    A partial copy of the file at path is resumed, unless disabled in opts:
+    the sender is asked with DCC RESUME and the transfer connects when it
+    answers with DCC ACCEPT. A copy already complete needs no transfer,
+    see dcc_manager::receive().
+    @param nickname The user offering the file.
+    @param offer    The offer.
+    @param path     The file to write.
+    @param func     The completion handler.
+    @param opts     The transfer settings.
+    @return The transfer, nullptr if none was started.
+*/
+    dcc_receiver::ptr dcc_receive( const std::string &nickname, const dcc_request &offer,
+                                   const std::string &path, dcc_transfer::handler func,
+                                   const dcc_options &opts = dcc_options() );
+/**
+    Signal fired when an user offers a file with DCC SEND.
+    @param func The function to call back with the nickname and the offer.
+*/
+    void on_dcc_send( std::function<void(const std::string &, const dcc_request &)> func )
+    {
+        handlers().on_dcc_send = func;
+    }
+/**
+    Sets the address advertised in DCC offers and listened on,
+    by default the local address of the server connection.
+    Useful behind NAT, where the public address must be advertised.
+    @param address The IPv4 or IPv6 address.
+*/
+    void dcc_address( const std::string &address ) { m_dcc_address = address; }
+/**
+    Returns the DCC transfers manager, for aggregate limits and statistics.
+    @return The DCC transfers manager.
+*/
+    dcc_manager &dcc()
+    {
+        if( !m_dcc )
+            m_dcc = dcc_manager::create( m_service );
+
+        return *m_dcc;
     }
 
 private:
-    explicit client( io_service &io_service )
-    :   m_service(io_service),
-        m_socket(io_service),
-        m_connected(false),
-        m_lasterror(error_code::success)
+    struct connect_request
     {
-        m_buf_read.prepare(512);
-        m_buf_write.prepare(512);
-    }
+        connect_request( const std::string &h, const std::string &p, const std::string &k )
+        :   hostname(h), port(p), key(k)
+        {}
 
-    client() = delete;
+        std::string hostname,
+                    port,
+                    key;
+    };
 
-    void loop( const system_error_code &ec, size_t /*bytes*/ )
+    struct initiate_wait
     {
-        if( !ec ) { BOOST_ASIO_CORO_REENTER( this ) { for( ;; )
-        {
-        BOOST_ASIO_CORO_YIELD
+        template< typename Handler, typename Matcher >
+        void operator()( Handler &&handler, client::ptr self, Matcher matcher,
+                         const std::string &command ) const
         {
-            async_write( m_socket, m_buf_write,
-                         std::bind( &client::loop, shared_from_this(),
-                                     ph::_1, ph::_2 ) );
+            self->start_wait( std::forward<Handler>( handler ), std::move( matcher ) );
+            if( !command.empty() )
+                self->send_raw( command );
         }
-        BOOST_ASIO_CORO_YIELD
+
+        template< typename Handler, typename Matcher >
+        void operator()( Handler &&handler, client::ptr self, Matcher matcher,
+                         const connect_request &request ) const
         {
-            async_read_until( m_socket, m_buf_read, "\r\n",
-                              std::bind( &client::loop, shared_from_this(),
-                                          ph::_1, ph::_2 ) );
+            self->start_wait( std::forward<Handler>( handler ), std::move( matcher ) );
+            self->connect( request.hostname, request.port, self->m_session.nickname(),
+                           self->m_session.username(), self->m_session.realname(), request.key );
         }
-        BOOST_ASIO_CORO_YIELD
+    };
+
+    struct initiate_send
+    {
+        template< typename Handler >
+        void operator()( Handler &&handler, client::ptr self, const std::string &line ) const
         {
-            m_service.post( std::bind( &client::handle_read, shared_from_this() ) );
+            typedef typename std::decay<Handler>::type handler_type;
+            typedef detail::write_op< handler_type, io_service::executor_type > op_type;
+
+            handler_type h( std::forward<Handler>( handler ) );
+            detail::write_waiter *waiter = op_type::create( h, self->m_service.get_executor() );
+
+            self->m_lasterror = error_code::success;
+            self->m_service.dispatch( std::bind( &client::queue_line, self, line, waiter ) );
         }
-        }}}
-    }
+    };
 
-    void handle_connect( const system_error_code &ec )
+    template< typename Handler, typename Matcher >
+    void start_wait( Handler &&handler, Matcher matcher )
     {
-        if( !ec && !m_connected )
-        {
-            if( m_on_connected )
-                m_on_connected();
+        typedef typename std::decay<Handler>::type handler_type;
+        typedef detail::waiter_op< Matcher, handler_type,
+                                   io_service::executor_type > op_type;
 
-            std::ostream out( &m_buf_write );
-            std::string
-            nick = boost::str( boost::format("NICK %1%\r\n") % m_nickname ),
-            user = boost::str( boost::format
-                ("USER %1% unknown unknown :%2%\r\n") % m_username % m_realname );
+        handler_type h( std::forward<Handler>( handler ) );
+        detail::message_waiter *waiter =
+            op_type::create( std::move( matcher ), h, m_service.get_executor() );
 
-            out << nick << user;
+        // Correlated requests expire, plain waits last until disconnection
+        if( waiter->exclusive )
+            waiter->deadline = detail::message_waiter::clock::now() + m_request_timeout;
 
-            m_service.post( std::bind( &client::loop,
-                                           shared_from_this(), ec, 0 ) );
-        }
+        m_service.dispatch( std::bind( &client::add_waiter, shared_from_this(), waiter ) );
     }
 
-    void handle_read()
+    void add_waiter( detail::message_waiter *waiter )
     {
-        m_connected = true;
-        std::istream in( &m_buf_read );
-        std::string  line;
-        std::getline( in, line );
-        if( line.empty() )
-        {
-            m_service.post( std::bind( &client::loop, shared_from_this(),
-                                           system_error_code(), 0 ) );
+        *m_waiters_tail = waiter;
+        m_waiters_tail  = &waiter->next;
+        arm_timer( waiter->deadline );
+    }
+
+    // One timer for the request deadlines and the keepalive one
+    void arm_timer( detail::message_waiter::clock::time_point expiry )
+    {
+        if( expiry >= m_timer_expiry )
             return;
-        }
 
-        // Remove carriage return
-        line.pop_back();
+        m_timer_expiry = expiry;
+        m_timer.expires_at( m_timer_expiry );
+        m_timer.async_wait( std::bind( &client::handle_timer,
+                                       shared_from_this(), ph::_1 ) );
+    }
 
-#ifdef IRC_DEBUG
-        std::cout << line << '\n';
-#endif
-        // Extract prefix
-        std::string sender;
-        std::size_t found = line.find_first_of(' ');
-        if( line.find(':') != std::string::npos && found != std::string::npos )
+    // After waiters left or the session stopped: the pending wait holds the
+    // client, so it is cancelled when no deadline is left
+    void retime()
+    {
+        detail::message_waiter::clock::time_point expiry = m_session.deadline();
+        for( detail::message_waiter *waiter = m_waiters; waiter; waiter = waiter->next )
+            expiry = std::min( expiry, waiter->deadline );
+
+        if( expiry != detail::message_waiter::clock::time_point::max() )
         {
-            line.replace( 0, 1, "" );
-            sender = line.substr( 0, found - 1 );
-            line.replace( 0, found, "" );
+            arm_timer( expiry );
+            return;
         }
+        if( m_timer_expiry == detail::message_waiter::clock::time_point::max() )
+            return;
 
-        // Extract command
-        std::string cmd_str;
-        int cmd_num = 0;
-        found = line.find(' ');
-        if( found != std::string::npos )
-        {
-            cmd_str = line.substr( 0, found );
+        m_timer_expiry = expiry;
+        system_error_code ignored;
+        m_timer.cancel( ignored );
+    }
+
+    void handle_timer( const system_error_code &ec )
+    {
+        if( ec == boost::asio::error::operation_aborted )
+            return;
 
-            bool is_numeric = std::find_if( cmd_str.begin(), cmd_str.end(),
-                [](char ch) { return !std::isdigit(ch); }) == cmd_str.end();
+        detail::message_waiter::clock::time_point now = detail::message_waiter::clock::now();
+        detail::message_waiter  *expired = nullptr,
+                               **last    = &expired,
+                               **link    = &m_waiters;
 
-            if( is_numeric )
+        m_timer_expiry = detail::message_waiter::clock::time_point::max();
+        while( *link )
+        {
+            detail::message_waiter *waiter = *link;
+            if( waiter->deadline <= now )
             {
-                cmd_num = std::atoi( cmd_str.c_str() );
-                reply_code rplcode = static_cast<reply_code>( cmd_num );
-                if( m_on_numeric )
-                    m_on_numeric( rplcode );
-#ifdef IRC_DEBUG
-                std::cout << "# command:" << cmd_num << '\n';
-#endif
+                *link        = waiter->next;
+                waiter->next = nullptr;
+                *last        = waiter;
+                last         = &waiter->next;
+                continue;
             }
-#ifdef IRC_DEBUG
-            else { std::cout << "# command:" << cmd_str << '\n'; }
-#endif
-            line.replace( 0, found + 1, "" );
-        }
+            if( waiter->deadline < m_timer_expiry )
+                m_timer_expiry = waiter->deadline;
 
-        // Extract recipient
-        std::string recipient;
-        found = line.find_first_of(' ');
-        if( found != std::string::npos )
-        {
-            recipient = line.substr( 0, found );
-            line.replace( 0, found, "" );
+            link = &waiter->next;
         }
+        m_waiters_tail = link;
 
-        // Extract last param
-        std::string last_param;
-        found = line.find(" :");
-        if( found != std::string::npos )
+        // The keepalive deadline moves with the input, it is only looked at here
+        m_session.tick( now );
+        m_timer_expiry = std::min( m_timer_expiry, m_session.deadline() );
+        if( m_timer_expiry != detail::message_waiter::clock::time_point::max() )
         {
-            last_param = line.substr( found + 2, line.size() );
-            line.replace( found, line.size(), "" );
+            m_timer.expires_at( m_timer_expiry );
+            m_timer.async_wait( std::bind( &client::handle_timer,
+                                           shared_from_this(), ph::_1 ) );
         }
 
-        // Split line to params
-        std::vector<std::string> params;
-        if( !line.empty() )
-            boost::split( params, line, boost::is_any_of("\t ") );
-
-        if( !last_param.empty() )
-            params.push_back(last_param);
-
-        // Extract params
-        std::string content;
-        if( params.size() )
+        if( m_session.timed_out() )
         {
-            content = params[0];
-            for( size_t i = 1; i < params.size(); ++i )
-                content += " " + params[i];
+            handle_read( boost::asio::error::timed_out, 0 );
+            close_socket();
         }
+        else
+            start_write();
 
-        // Handle ping TODO: Swap recipient with sender for ERROR JOIN...
-        if( cmd_str == "PING" && !recipient.empty() )
+        while( expired )
         {
-            std::swap( recipient, sender );
-            if( sender.find(':') != std::string::npos )
-                sender.replace( 0, 1, "" );
-
-            m_service.dispatch( std::bind( &client::pong,
-                                               shared_from_this(), sender ) );
+            detail::message_waiter *waiter = expired;
+            expired = waiter->next;
+            waiter->complete( boost::asio::error::timed_out, message() );
         }
-        else if( cmd_str == "PRIVMSG" && !content.empty() )
-        {
-            std::string sender_nick = nickname_from( sender );
-            if( content.find(':') != std::string::npos )
-                content.replace( 0, 1, "" );
-
-            std::size_t msg_len = content.size();
-
-            // CTCP requests starts/ends with 0x01
-            if( content[0] == 0x01 && content[msg_len - 1] == 0x01 )
-            {
-                msg_len -= 2;
-                std::string ctcp_str = content.substr( 1, msg_len );
+    }
 
-                if( ctcp_str.find("ACTION") != std::string::npos )
-                {
-                    if( m_on_action )
-                        m_on_action(ctcp_str);
-                }
-                else if( ctcp_str.find("DCC") != std::string::npos )
-                {
-                    if( m_on_dcc_req )
-                        m_on_dcc_req(ctcp_str);
-                }
-                else if( ctcp_str.find("FINGER") != std::string::npos )
-                {
-                    
-                }
-                else if( ctcp_str.find("PING") != std::string::npos )
-                {
-                    if( !sender_nick.empty() )
-                        ctcp_reply( sender_nick, ctcp_str );
-                }
-                else if( ctcp_str.find("TIME") != std::string::npos )
-                {
-                    //
-                }
-                else if( ctcp_str.find("VERSION") != std::string::npos )
-                {
-                    if( m_on_version )
-                    {
-                        m_on_version();
-                    }
-                    else
-                    {
-                        if( !sender_nick.empty() )
-                            ctcp_reply( sender_nick, version() );
-                    }
-                }
-            }
-            else if( recipient.find(m_nickname) != std::string::npos )
-            {
-                if( m_on_privmsg )
-                    m_on_privmsg( sender_nick, sender, content );
-            }
-            else
-            {
-                if( m_on_chanmsg )
-                    m_on_chanmsg( sender_nick, recipient, content );
-            }
-        }
-        else if( cmd_str == "NOTICE" && !content.empty() )
+    void notify_waiters( const message &msg )
+    {
+        detail::message_waiter  *matched = nullptr,
+                               **last    = &matched,
+                               **link    = &m_waiters;
+        bool claimed = false;
+        while( *link )
         {
-            std::size_t msg_len  = content.size();
-            std::string sender_nick = nickname_from( sender );
-
-            // CTCP
-            if( content[0] == 0x01 && content[msg_len - 1] == 0x01 )
+            detail::message_waiter *waiter = *link;
+            if( waiter->exclusive && claimed )
             {
-                msg_len -= 2;
-                std::string ctcp_str = content.substr( 1, msg_len );
+                link = &waiter->next;
+                continue;
             }
-            else if( recipient.find(m_nickname) != std::string::npos )
+
+            detail::wait_result result = waiter->on_message( msg );
+            if( waiter->exclusive && ( result == detail::wait_result::consumed ||
+                                       result == detail::wait_result::completed ) )
+                claimed = true;
+
+            if( result == detail::wait_result::completed ||
+                result == detail::wait_result::done )
             {
-                if( m_on_privntc )
-                    m_on_privntc( sender_nick, recipient, content );
+                *link        = waiter->next;
+                waiter->next = nullptr;
+                *last        = waiter;
+                last         = &waiter->next;
             }
             else
-            {
-                if( m_on_channtc )
-                    m_on_channtc( sender_nick, recipient, content );
-            }
+                link = &waiter->next;
         }
-        else if(cmd_str == "INVITE")
-        {
-            if( m_on_invite )
-            {
-                std::string sender_nick = nickname_from( sender );
-                m_on_invite( sender_nick, recipient, content );
-            }
-        }
-        else if(cmd_str == "KILL")
-        {
-            ;// ignore this event, not all servers generate this.
-        }
-        else // Unknown cmd_str
+        m_waiters_tail = link;
+
+        if( matched )
+            retime();
+
+        // Completions may start new waits, they will see the next message
+        while( matched )
         {
-            if( m_on_unknown )
-                m_on_unknown();
+            detail::message_waiter *waiter = matched;
+            matched = waiter->next;
+            waiter->complete( system_error_code(), msg );
         }
-#ifdef IRC_DEBUG
-        std::cout << "# message:" << content   << '\n'
-//                << "# command:" << cmd_str   << '\n'
-                  << "# from   :" << sender    << '\n'
-                  << "# to     :" << recipient << '\n';
-#endif
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                       system_error_code(), 0 ) );
     }
 
-    void pong( const std::string &sender ) { send_raw("PONG " + sender); }
-
-    void handle_ctcp( const std::string &sender )
+    void fail_waiters( const system_error_code &ec )
     {
-        
-    }
+        detail::message_waiter *waiter = m_waiters;
+        m_waiters      = nullptr;
+        m_waiters_tail = &m_waiters;
+        retime();
+
+        while( waiter )
+        {
+            detail::message_waiter *next = waiter->next;
+            waiter->complete( ec, message() );
+            waiter = next;
+        }
+    }
+
+    // The transport is built in place from the arguments, GCC warns about
+    // moving a socket never opened
+    template< typename... Args >
+    explicit client( io_service &io_service, Args &&...args )
+    :   m_service(io_service),
+        m_transport(std::forward<Args>( args )...),
+        m_connected(false),
+        m_writing(false),
+        m_read_paused(false),
+        m_read_waiting(false),
+        m_read_posted(false),
+        m_dispatching(false),
+        m_lasterror(error_code::success),
+        m_marks_head(0),
+        m_out_taken(0),
+        m_trace(nullptr),
+        m_waiters(nullptr),
+        m_waiters_tail(&m_waiters),
+        m_timer(io_service),
+        m_timer_expiry(detail::message_waiter::clock::time_point::max()),
+        m_request_timeout(30000),
+#ifdef IRC_CLIENT_HAS_IO_URING
+        m_uring_id(uring_service::npos),
+        m_uring_link(*this),
+#endif
+        m_isupport(isupport::defaults()),
+        m_held(0),
+        m_flow_paused(false),
+        m_handlers(no_handlers())
+    {
+#ifdef IRC_DEBUG
+        tracing(true);
+#endif
+    }
+
+    client() = delete;
+
+    // A buffered line is handled right away, otherwise the socket is waited
+    // for without a buffer, taken from the pool when it becomes readable
+    void start_read()
+    {
+        // The message given to the handlers points into the input
+        if( m_dispatching )
+            return;
+
+        if( flow_blocked() || m_read_paused )
+        {
+            skim();
+            return;
+        }
+
+        if( m_session.ready() )
+        {
+            if( !m_read_posted )
+            {
+                m_read_posted = true;
+                m_service.post( std::bind( &client::handle_read, shared_from_this(),
+                                           system_error_code(), 0 ) );
+            }
+            return;
+        }
+
+        if( !m_writing )
+            m_session.shrink();
+        wait_readable();
+    }
+
+    // One wait at a time, whoever restarts reading
+    void wait_readable()
+    {
+        if( m_read_waiting )
+            return;
+
+        m_read_waiting = true;
+#ifdef IRC_CLIENT_HAS_IO_URING
+        if( m_uring_id != uring_service::npos )
+        {
+            m_uring->receive( m_uring_id );
+            return;
+        }
+#endif
+        m_transport.async_wait_read( std::bind( &client::handle_readable,
+                                                shared_from_this(), ph::_1 ) );
+    }
+
+    void handle_readable( const system_error_code &ec )
+    {
+        m_read_waiting = false;
+        if( ec )
+        {
+            handle_read( ec, 0 );
+            return;
+        }
+
+        // While paused the buffer only grows up to max_buffer
+        std::size_t limit = m_flow_paused || m_read_paused ? m_flow.max_buffer : 0, size;
+        char       *data  = m_session.prepare( limit, size );
+
+        system_error_code error;
+        std::size_t bytes = m_transport.read_some( data, size, error );
+        m_session.commit( bytes, session::clock::now() );
+
+        if( error && error != boost::asio::error::would_block )
+        {
+            // The lines buffered while paused come first, the error is read again after them
+            if( !m_flow_paused && !m_read_paused )
+                handle_read( error, 0 );
+            return;
+        }
+        start_read();
+    }
+
+    // A pending read reports the closing, except with io_uring where it is done here
+    void close_socket()
+    {
+#ifdef IRC_CLIENT_HAS_IO_URING
+        if( m_uring_id != uring_service::npos )
+        {
+            detach_uring();
+            m_transport.close();
+            handle_read( boost::asio::error::operation_aborted, 0 );
+            return;
+        }
+#endif
+        m_transport.close();
+    }
+#ifdef IRC_CLIENT_HAS_IO_URING
+    // Receives and writes go through the ring while attached
+    struct uring_link : uring_connection
+    {
+        explicit uring_link( client &owner ) : owner(owner) {}
+
+        void uring_received( const char *data, std::size_t size )
+        {
+            client::ptr self = owner.shared_from_this();
+            owner.handle_received( data, size );
+        }
+
+        void uring_sent( const system_error_code &ec, std::size_t bytes )
+        {
+            client::ptr self = owner.shared_from_this();
+            owner.handle_write( ec, bytes );
+        }
+
+        void uring_closed( const system_error_code &ec )
+        {
+            client::ptr self = owner.shared_from_this();
+            owner.m_read_waiting = false;
+            owner.handle_read( ec, 0 );
+        }
+
+        client &owner;
+    };
+
+    // The ring keeps receiving: bytes nobody waits for are buffered, up to max_buffer
+    void handle_received( const char *data, std::size_t size )
+    {
+        m_session.receive( boost::string_view( data, size ), session::clock::now() );
+        if( m_read_waiting )
+        {
+            m_read_waiting = false;
+            start_read();
+        }
+        else if( m_session.buffered() >= m_flow.max_buffer )
+            m_uring->stop_receive( m_uring_id );
+    }
+
+    // A send in flight is cancelled, it will not complete
+    void detach_uring()
+    {
+        if( m_uring_id == uring_service::npos )
+            return;
+
+        m_uring->detach( m_uring_id );
+        m_uring_id     = uring_service::npos;
+        m_read_waiting = false;
+        m_writing      = false;
+    }
+#endif
+    // Pauses once the high water mark is reached, returns true while paused
+    bool flow_blocked()
+    {
+        if( !m_flow_paused && m_flow.high_water && m_held.load() >= m_flow.high_water )
+        {
+            m_flow_paused  = true;
+            m_paused_since = flow_stats::clock::now();
+            ++m_flow_stats.pauses;
+            trace_point( trace_event::read_paused, 0,
+                         static_cast<std::uint32_t>( m_held.load() ) );
+
+            // Credit given back before the pause was seen would be lost
+            if( m_held.load() <= m_flow.low_water )
+                m_service.post( std::bind( &client::flow_resume, shared_from_this() ) );
+        }
+        return m_flow_paused;
+    }
+
+    void flow_resume()
+    {
+        if( !m_flow_paused || ( m_flow.high_water && m_held.load() > m_flow.low_water ) )
+            return;
+
+        end_pause();
+        if( !m_read_paused )
+            start_read();
+    }
+
+    void end_pause()
+    {
+        if( !m_flow_paused )
+            return;
+
+        m_flow_paused = false;
+        flow_stats::clock::duration paused = flow_stats::clock::now() - m_paused_since;
+        m_flow_stats.paused += paused;
+        trace_point( trace_event::read_resumed, 0, static_cast<std::uint32_t>(
+                     std::chrono::duration_cast<std::chrono::milliseconds>( paused ).count() ) );
+    }
+
+    // While paused, the buffered lines are only looked at for PINGs, which are
+    // answered and dropped, and reading goes on while the buffer has room
+    void skim()
+    {
+        m_flow_stats.pings += m_session.skim();
+        start_write();
+
+        if( m_session.buffered() < m_flow.max_buffer )
+            wait_readable();
+    }
+
+    void do_resume()
+    {
+        if( !m_read_paused )
+            return;
+
+        m_read_paused = false;
+        start_read();
+    }
+
+    void start_list( const list_filter &filter,
+                     std::function<bool(const list_entry_view &)> on_entry,
+                     std::function<void(const system_error_code &)> on_end )
+    {
+        if( m_on_list_entry )
+        {
+            if( on_end )
+                on_end( boost::asio::error::in_progress );
+            return;
+        }
+
+        m_list_filter   = filter;
+        m_on_list_entry = on_entry;
+        m_on_list_end   = on_end;
+
+        // ELIST=U: the server understands >N and <N user count conditions
+        std::string cmd_str = "LIST";
+        if( !filter.channels.empty() )
+            cmd_str += " " + filter.channels;
+        else if( m_isupport->elist().find('U') != std::string::npos &&
+                 ( filter.min_users || filter.max_users ) )
+        {
+            cmd_str += " ";
+            if( filter.min_users )
+                cmd_str += ">" + std::to_string( filter.min_users );
+            if( filter.min_users && filter.max_users )
+                cmd_str += ",";
+            if( filter.max_users )
+                cmd_str += "<" + std::to_string( filter.max_users );
+        }
+        queue_line( cmd_str, nullptr );
+    }
+
+    // The parameters from first on, joined by spaces, the trailing one as is
+    static std::string params_text( const message_view &msg, std::size_t first )
+    {
+        if( first >= msg.param_count )
+            return std::string();
+
+        std::string text = msg.params[first].to_string();
+        for( std::size_t i = first + 1; i < msg.param_count; ++i )
+            text.append( 1, ' ' ).append( msg.params[i].data(), msg.params[i].size() );
+
+        return text;
+    }
+
+    void handle_list( int cmd_num, const message_view &msg )
+    {
+        if( cmd_num == 323 )
+        {
+            end_list( system_error_code() );
+            return;
+        }
+        if( cmd_num != 322 )
+            return;
+
+        // <me> <channel> <users> :<topic>
+        list_entry_view entry = { msg.param(1), 0, msg.param(3) };
+        for( char ch : msg.param(2) )
+        {
+            if( ch < '0' || ch > '9' )
+                break;
+            entry.users = entry.users * 10 + static_cast<unsigned>( ch - '0' );
+        }
+
+        if( ( m_list_filter.min_users && entry.users <= m_list_filter.min_users ) ||
+            ( m_list_filter.max_users && entry.users >= m_list_filter.max_users ) )
+            return;
+
+        trace_point( trace_event::callback_enter,
+                     static_cast<std::uint16_t>( trace_handler::list_entry ) );
+        if( !m_on_list_entry( entry ) )
+            m_read_paused = true;
+        trace_point( trace_event::callback_exit,
+                     static_cast<std::uint16_t>( trace_handler::list_entry ) );
+    }
+
+    void end_list( const system_error_code &ec )
+    {
+        if( !m_on_list_entry )
+            return;
+
+        std::function<void(const system_error_code &)> on_end;
+        on_end.swap( m_on_list_end );
+        m_on_list_entry = nullptr;
+
+        invoke( trace_handler::list_end, on_end, ec );
+    }
+
+    void queue_line( const std::string &line, detail::write_waiter *waiter )
+    {
+        m_session.send( line );
+        mark_lines( 1, waiter );
+        start_write();
+    }
+
+    // Lines already terminated by CR-LF, sent in a single write when possible
+    void queue_lines( const std::string &lines )
+    {
+        m_session.send_lines( lines );
+        mark_lines( static_cast<std::size_t>( std::count( lines.begin(), lines.end(), '\n' ) ),
+                    nullptr );
+        start_write();
+    }
+
+    // The application lines end at output positions, counted from the first
+    // byte ever queued: lines without a waiter still queued share a mark
+    void mark_lines( std::size_t lines, detail::write_waiter *waiter )
+    {
+        m_delivery.accepted += lines;
+
+        std::uint64_t end = m_out_taken + m_session.output().size();
+        if( !waiter && m_marks.size() > m_marks_head &&
+            !m_marks.back().waiter && m_marks.back().end > m_out_taken )
+        {
+            m_marks.back().end    = end;
+            m_marks.back().lines += lines;
+            return;
+        }
+
+        send_mark mark = { end, lines, waiter };
+        m_marks.push_back( mark );
+    }
+
+    // Completes the marks up to an output position, written or discarded
+    void complete_marks( std::uint64_t position, const system_error_code &ec )
+    {
+        while( m_marks_head < m_marks.size() && m_marks[m_marks_head].end <= position )
+        {
+            send_mark mark = m_marks[m_marks_head++];
+            if( ec )
+                m_delivery.discarded += mark.lines;
+            else
+                m_delivery.written   += mark.lines;
+
+            if( mark.waiter )
+                mark.waiter->complete( ec );
+        }
+
+        if( m_marks_head == m_marks.size() )
+        {
+            m_marks.clear();
+            m_marks_head = 0;
+        }
+    }
+
+    void take_flight()
+    {
+        m_session.take_output( m_out_flight );
+        m_out_taken += m_out_flight.size();
+    }
+
+    // Packers run on the io_service thread, with the current server features
+    void queue_targets( const std::string &command, const std::vector<std::string> &targets,
+                        const std::string &trailing )
+    {
+        std::string lines;
+        pack_targets( lines, command, targets, trailing, *m_isupport );
+        queue_lines( lines );
+    }
+
+    void queue_join( const std::vector<std::string> &channels,
+                     const std::vector<std::string> &keys )
+    {
+        std::string lines;
+        pack_join( lines, channels, keys, *m_isupport );
+        queue_lines( lines );
+    }
+
+    void queue_modes( const std::string &channel, const std::vector<mode_change> &changes )
+    {
+        std::string lines;
+        pack_mode( lines, channel, changes, *m_isupport );
+        queue_lines( lines );
+    }
+
+    // Lines queued while a write is in flight go out together in the next one
+    void start_write()
+    {
+        if( m_writing || !m_connected || !m_session.has_output() )
+            return;
+
+        take_flight();
+        write_flight();
+    }
+
+    void write_flight()
+    {
+        m_writing = true;
+        trace_point( trace_event::write_issued, 0,
+                     static_cast<std::uint32_t>( m_out_flight.size() ) );
+#ifdef IRC_CLIENT_HAS_IO_URING
+        if( m_uring_id != uring_service::npos )
+        {
+            m_uring->send( m_uring_id, m_out_flight.data(), m_out_flight.size() );
+            return;
+        }
+#endif
+        m_transport.async_write( m_out_flight.data(), m_out_flight.size(),
+                                 std::bind( &client::handle_write,
+                                            shared_from_this(), ph::_1, ph::_2 ) );
+    }
+
+    void handle_write( const system_error_code &ec, std::size_t bytes )
+    {
+        m_writing = false;
+        trace_point( trace_event::write_completed, static_cast<std::uint16_t>( ec.value() ),
+                     static_cast<std::uint32_t>( bytes ) );
+        m_out_flight.clear();
+        complete_marks( m_out_taken, ec );
+
+        if( !ec )
+            start_write();
+
+        // Nothing more to send, the buffers go back to the pool
+        if( !m_writing )
+        {
+            detail::buffer_pool::instance().release( m_out_flight );
+            m_session.shrink();
+        }
+    }
+
+    void handle_connect( const system_error_code &ec )
+    {
+        if( !ec && !m_connected )
+        {
+            // A new server, its features are not known yet
+            m_isupport_next.reset( new isupport() );
+            m_isupport_key.clear();
+            m_isupport = isupport::defaults();
+            m_hostmasks.clear();
+            m_read_waiting = false;
+            m_read_posted  = false;
+#ifdef IRC_CLIENT_HAS_IO_URING
+            detach_uring();
+            if( m_uring && m_transport.native_handle() >= 0 )
+            {
+                // The ring waits for the socket itself, which blocks
+                m_transport.non_blocking( false );
+                m_uring_id = m_uring->attach( m_transport.native_handle(), &m_uring_link );
+            }
+            else
+#endif
+            m_transport.non_blocking( true );
+
+            // The registration goes before the lines queued meanwhile
+            std::size_t queued = m_session.output().size();
+            m_session.start( session::clock::now() );
+            for( std::size_t i = m_marks_head; i < m_marks.size(); ++i )
+                m_marks[i].end += m_session.output().size() - queued;
+
+            invoke( trace_handler::connected, m_handlers->on_connected );
+
+            // Registration goes first in one write, with the commands queued before
+            start_read();
+            take_flight();
+            write_flight();
+            arm_timer( m_session.deadline() );
+        }
+        else if( ec )
+        {
+            fail_waiters( ec );
+        }
+    }
+
+    void handle_read( const system_error_code &ec, std::size_t /*bytes*/ )
+    {
+        m_read_posted = false;
+        if( ec )
+        {
+            end_pause();
+            if( m_connected )
+            {
+                m_connected = false;
+                invoke( trace_handler::disconnected, m_handlers->on_disconnected );
+            }
+            end_list( ec );
+            fail_waiters( ec );
+            m_session.stop();
+            retime();
+
+            // The lines of this connection are not sent to the next one
+            m_session.discard_output();
+            complete_marks( std::numeric_limits<std::uint64_t>::max(), ec );
+#ifdef IRC_CLIENT_HAS_IO_URING
+            detach_uring();
+#endif
+            return;
+        }
+
+        if( !m_connected )
+        {
+            m_connected = true;
+            start_write();
+        }
+
+        // PINGs and the registration are answered by the session
+        message_view  msg;
+        session_event event = m_session.next( msg );
+        start_write();
+        if( event == session_event::none )
+        {
+            start_read();
+            return;
+        }
+
+        // Handlers restarting the read would move the input under msg
+        struct dispatch_guard
+        {
+            explicit dispatch_guard( bool &flag ) : flag(flag) { flag = true; }
+            ~dispatch_guard() { flag = false; }
+
+            bool &flag;
+        };
+
+        {
+            dispatch_guard guard( m_dispatching );
+            handle_message( msg, event );
+        }
+        start_read();
+    }
+
+    // The read is restarted by the caller, which skims while paused
+    void handle_message( const message_view &msg, session_event event )
+    {
+        boost::string_view received = m_session.line();
+        trace_point( trace_event::line_received, 0,
+                     static_cast<std::uint32_t>( received.size() ),
+                     received.data(), received.size() );
+
+        std::string cmd_str = msg.command.to_string();
+        int         cmd_num = static_cast<int>( msg.code );
+        trace_point( trace_event::command_parsed, static_cast<std::uint16_t>( cmd_num ), 0,
+                     cmd_str.data(), cmd_str.size() );
+        invoke( trace_handler::message, m_handlers->on_message, msg );
+
+        // Frequent senders are cached
+        std::string sender = msg.prefix.to_string();
+        const hostmask_entry &from = m_hostmasks.find( msg.prefix );
+        m_sender = from.view;
+
+        if( cmd_num )
+            invoke( trace_handler::numeric, m_handlers->on_numeric, msg.code );
+
+        if( event == session_event::consumed )
+            return;
+
+        // ISUPPORT: "<me> <token>... :are supported by this server"
+        if( cmd_num == 5 )
+        {
+            if( msg.param_count > 1 )
+            {
+                // The tokens as received, from the first one to the end of the line
+                const char *tokens = msg.params[1].data();
+                boost::string_view tokens_view( tokens, received.end() - tokens );
+
+                // While registering, clients fed the same tokens share a table
+                if( m_isupport_next )
+                {
+                    m_isupport_next->parse( tokens_view );
+                    m_isupport_key.append( tokens_view.data(), tokens_view.size() ).append( 1, '\n' );
+                    m_isupport = isupport::shared( m_isupport_key, *m_isupport_next );
+                }
+                else
+                {
+                    isupport next( *m_isupport );
+                    next.parse( tokens_view );
+                    m_isupport = std::make_shared<const isupport>( next );
+                }
+
+                if( m_backlog )
+                    m_backlog->mapping( m_isupport->casemap() );
+
+                for( std::unique_ptr<message_bus> &bus : m_buses )
+                    if( bus )
+                        bus->mapping( m_isupport->casemap() );
+            }
+        }
+        // End of MOTD, registration is over
+        else if( ( cmd_num == 376 || cmd_num == 422 ) && m_isupport_next )
+        {
+            m_isupport_next.reset();
+            std::string().swap( m_isupport_key );
+        }
+
+        // Streamed LIST replies are taken from the parameters
+        if( m_on_list_entry && cmd_num >= 321 && cmd_num <= 323 )
+        {
+            handle_list( cmd_num, msg );
+            return;
+        }
+
+        // Only build a message when some asynchronous operation is waiting
+        if( m_waiters )
+            notify_waiters( message( msg ) );
+
+        // The recipient, then the text
+        std::string recipient = msg.param(0).to_string(),
+                    content   = params_text( msg, 1 );
+
+        if( cmd_str == "PRIVMSG" && !content.empty() )
+        {
+            const std::string &sender_nick = from.nickname;
+
+            // CTCP requests starts/ends with 0x01
+            ctcp_message ctcp;
+            if( parse_ctcp( content, ctcp ) )
+            {
+                handle_ctcp( sender, sender_nick, recipient, ctcp );
+            }
+            else
+            {
+                if( !m_isupport->is_channel( recipient ) )
+                {
+                    invoke_keyed( trace_handler::private_msg, sender_nick,
+                                  m_handlers->on_privmsg, sender_nick, sender, content );
+                    publish( message_event::private_msg, sender_nick,
+                             sender_nick, sender, content );
+                }
+                else
+                {
+                    if( m_backlog )
+                        m_backlog->append( recipient, sender_nick, content );
+
+                    invoke_keyed( trace_handler::channel_msg, recipient,
+                                  m_handlers->on_chanmsg, sender_nick, recipient, content );
+                    publish( message_event::channel_msg, recipient,
+                             sender_nick, recipient, content );
+                }
+
+                if( m_triggers && !m_triggers->empty() )
+                    m_triggers->scan( content, [&]( trigger_set::id_type id, std::size_t offset )
+                    {
+                        // Copied, the handler may register other triggers
+                        trigger_handler func = m_trigger_handlers[id];
+                        invoke_keyed( trace_handler::trigger,
+                                      m_isupport->is_channel( recipient ) ? recipient : sender_nick,
+                                      func, sender_nick, recipient, content, offset );
+                    });
+            }
+        }
+        else if( cmd_str == "NOTICE" && !content.empty() )
+        {
+            const std::string &sender_nick = from.nickname;
+
+            // CTCP replies are not dispatched
+            if( content[0] == 0x01 && content[content.size() - 1] == 0x01 )
+                return;
+
+            if( !m_isupport->is_channel( recipient ) )
+            {
+                invoke_keyed( trace_handler::private_notice, sender_nick,
+                              m_handlers->on_privntc, sender_nick, recipient, content );
+                publish( message_event::private_notice, sender_nick,
+                         sender_nick, recipient, content );
+            }
+            else
+            {
+                if( m_backlog )
+                    m_backlog->append( recipient, sender_nick, content );
+
+                invoke_keyed( trace_handler::channel_notice, recipient,
+                              m_handlers->on_channtc, sender_nick, recipient, content );
+                publish( message_event::channel_notice, recipient,
+                         sender_nick, recipient, content );
+            }
+        }
+        else if(cmd_str == "INVITE")
+        {
+            if( m_handlers->on_invite )
+                invoke_keyed( trace_handler::invite, from.nickname,
+                              m_handlers->on_invite, from.nickname, recipient, content );
+            publish( message_event::invite, from.nickname,
+                     from.nickname, recipient, content );
+        }
+        else if(cmd_str == "KILL")
+        {
+            ;// ignore this event, not all servers generate this.
+        }
+        else // Unknown cmd_str
+        {
+            invoke( trace_handler::unknown, m_handlers->on_unknown );
+        }
+    }
+
+    void trace_point( trace_event type, std::uint16_t code = 0, std::uint32_t arg = 0,
+                      const char *data = nullptr, std::size_t size = 0 )
+    {
+        trace_ring *ring = m_trace.load( std::memory_order_acquire );
+        if( ring && ring->enabled() )
+            ring->record( type, code, arg, data, size );
+    }
+
+    template< typename Func, typename... Args >
+    void invoke( trace_handler id, Func &func, Args &&... args )
+    {
+        if( !func )
+            return;
+
+        trace_point( trace_event::callback_enter, static_cast<std::uint16_t>( id ) );
+        func( std::forward<Args>( args )... );
+        trace_point( trace_event::callback_exit, static_cast<std::uint16_t>( id ) );
+    }
+
+    // As invoke(), on the worker pool if any, after the handlers of the same
+    // key. The handler and its arguments are copied, the trace ring has a
+    // single writer so the pool runs them untraced
+    template< typename Func, typename... Args >
+    void invoke_keyed( trace_handler id, const std::string &key, Func &func, Args &&... args )
+    {
+        if( !m_workers )
+        {
+            invoke( id, func, std::forward<Args>( args )... );
+            return;
+        }
+
+        if( !func )
+            return;
+
+        std::string folded( key );
+        for( char &ch : folded )
+            ch = fold_case( ch, m_isupport->casemap() );
+
+        m_workers->post( folded, std::bind( func, std::forward<Args>( args )... ) );
+    }
+
+    // Calls the subscribers of an event, or posts them as invoke_keyed()
+    void publish( message_event event, const std::string &key, const std::string &nick,
+                  const std::string &target, const std::string &text )
+    {
+        message_bus *bus = m_buses[ static_cast<std::size_t>( event ) ].get();
+        if( !bus || bus->empty() )
+            return;
+
+        if( !m_workers )
+        {
+            trace_point( trace_event::callback_enter,
+                         static_cast<std::uint16_t>( trace_handler::subscriber ) );
+            bus->publish( key, nick, target, text );
+            trace_point( trace_event::callback_exit,
+                         static_cast<std::uint16_t>( trace_handler::subscriber ) );
+            return;
+        }
+
+        std::string folded( key );
+        for( char &ch : folded )
+            ch = fold_case( ch, m_isupport->casemap() );
+
+        bus->dispatch( key, [&]( const message_bus::handler_type &func )
+        {
+            m_workers->post( folded, std::bind( func, nick, target, text ) );
+        });
+    }
+
+    // Built-in CTCP commands, shared by all the clients
+    typedef void (client::*ctcp_builtin)( const std::string &nick, const std::string &args );
+
+    struct ctcp_default
+    {
+        const char  *command;
+        ctcp_builtin handler;
+        bool         replies;
+    };
+
+    static const ctcp_default *ctcp_defaults( std::size_t &count )
+    {
+        static const ctcp_default defaults[] =
+        {
+            { "ACTION",     &client::ctcp_action,     false },
+            { "CLIENTINFO", &client::ctcp_clientinfo, true  },
+            { "DCC",        &client::ctcp_dcc,        false },
+            { "PING",       &client::ctcp_ping,       true  },
+            { "TIME",       &client::ctcp_time,       true  },
+            { "VERSION",    &client::ctcp_version,    true  }
+        };
+        count = sizeof(defaults) / sizeof(defaults[0]);
+        return defaults;
+    }
+
+    static const ctcp_default *find_ctcp_default( const std::string &command )
+    {
+        std::size_t count;
+        const ctcp_default *defaults = ctcp_defaults( count );
+        for( std::size_t i = 0; i < count; ++i )
+            if( command == defaults[i].command )
+                return &defaults[i];
+
+        return nullptr;
+    }
+
+    void ctcp_action( const std::string &nick, const std::string &args )
+    {
+        invoke_keyed( trace_handler::action, nick, m_handlers->on_action, "ACTION " + args );
+    }
+
+    void ctcp_clientinfo( const std::string &nick, const std::string & )
+    {
+        // The defaults not unregistered, and the registered commands
+        std::vector<std::string> commands;
+        std::size_t count;
+        const ctcp_default *defaults = ctcp_defaults( count );
+        for( std::size_t i = 0; i < count; ++i )
+            if( !m_ctcp.count( defaults[i].command ) )
+                commands.push_back( defaults[i].command );
+
+        for( const auto &entry : m_ctcp )
+            if( entry.second.handler )
+                commands.push_back( entry.first );
+
+        std::sort( commands.begin(), commands.end() );
+        ctcp_reply( nick, "CLIENTINFO " + boost::algorithm::join( commands, " " ) );
+    }
+
+    void ctcp_dcc( const std::string &nick, const std::string &args )
+    {
+        handle_dcc( nick, args );
+        invoke( trace_handler::dcc_request, m_handlers->on_dcc_req, "DCC " + args );
+    }
+
+    void ctcp_ping( const std::string &nick, const std::string &args )
+    {
+        ctcp_reply( nick, args.empty() ? "PING" : "PING " + args );
+    }
+
+    void ctcp_time( const std::string &nick, const std::string & )
+    {
+        char stamp[64];
+        std::time_t now = std::time( nullptr );
+        std::strftime( stamp, sizeof(stamp), "%a %b %d %H:%M:%S %Y", std::localtime( &now ) );
+        ctcp_reply( nick, std::string("TIME ") + stamp );
+    }
+
+    void ctcp_version( const std::string &nick, const std::string & )
+    {
+        if( m_handlers->on_version )
+            invoke( trace_handler::version, m_handlers->on_version );
+        else
+            ctcp_reply( nick, version() );
+    }
+
+    void handle_dcc( const std::string &nick, const std::string &args )
+    {
+        dcc_request dcc;
+        if( nick.empty() || !parse_dcc( args, dcc ) )
+            return;
+
+        if( dcc.type == "SEND" )
+        {
+            invoke( trace_handler::dcc_request, m_handlers->on_dcc_send, nick, dcc );
+        }
+        else if( dcc.type == "RESUME" && m_dcc && m_dcc->resume( dcc.port, dcc.position ) )
+        {
+            ctcp_request( nick, boost::str( boost::format("DCC ACCEPT %1% %2% %3%")
+                                            % quote_filename( dcc.filename )
+                                            % dcc.port % dcc.position ) );
+        }
+        else if( dcc.type == "ACCEPT" && m_dcc )
+        {
+            m_dcc->accept( dcc.port, dcc.position );
+        }
+    }
+
+    static std::string quote_filename( const std::string &filename )
+    {
+        return filename.find(' ') == std::string::npos ? filename : '"' + filename + '"';
+    }
+
+    void handle_ctcp( const std::string &sender, const std::string &sender_nick,
+                      const std::string &recipient, const ctcp_message &ctcp )
+    {
+        std::string command( ctcp.command.data(), ctcp.command.size() );
+        boost::to_upper( command );
+
+        // Registered handlers first, an empty one disables a default
+        ctcp_builtin builtin = nullptr;
+        bool         replies;
+        std::unordered_map<std::string, ctcp_entry>::iterator it = m_ctcp.find( command );
+        if( it != m_ctcp.end() )
+        {
+            if( !it->second.handler )
+                return;
+            replies = it->second.replies;
+        }
+        else
+        {
+            const ctcp_default *entry = find_ctcp_default( command );
+            if( !entry )
+                return;
+            builtin = entry->handler;
+            replies = entry->replies;
+        }
+
+        if( replies )
+        {
+            // Replies go to a nickname, never to a server
+            if( sender_nick.empty() )
+                return;
+
+            std::size_t at = sender.find('@');
+            boost::string_view source( sender );
+            if( at != std::string::npos )
+                source = source.substr( at + 1 );
+
+            if( !m_ctcp_limiter.allow( source ) )
+                return;
+        }
+
+        trace_point( trace_event::callback_enter,
+                     static_cast<std::uint16_t>( trace_handler::ctcp ),
+                     0, command.data(), command.size() );
+        std::string args( ctcp.args.data(), ctcp.args.size() );
+        if( builtin )
+            ( this->*builtin )( sender_nick, args );
+        else
+            it->second.handler( sender_nick, recipient, args );
+        trace_point( trace_event::callback_exit,
+                     static_cast<std::uint16_t>( trace_handler::ctcp ) );
+    }
 
     io_service &m_service;
-    socket      m_socket;
-    bool        m_connected;
-    std::string m_nickname,
-                m_username,
-                m_realname;
-    streambuf   m_buf_read,
-                m_buf_write;
-    error_code  m_lasterror;
-
-    std::function<void()> m_on_unknown;
-    std::function<void(const std::string &,
-                       const std::string &,
-                       const std::string &)> m_on_invite;
-    std::function<void(const std::string &,
-                       const std::string &,
-                       const std::string &)> m_on_channtc;
-    std::function<void(const std::string &,
-                       const std::string &,
-                       const std::string &)> m_on_privntc;
-    std::function<void(const std::string &,
-                       const std::string &,
-                       const std::string &)> m_on_chanmsg;
-    std::function<void(const std::string &,
-                       const std::string &,
-                       const std::string &)> m_on_privmsg;
-    std::function<void(const std::string &)> m_on_action;
-    std::function<void(const std::string &)> m_on_dcc_req;
-    std::function<void(reply_code)>          m_on_numeric;
-    std::function<void()>                    m_on_connected;
-    std::function<void()>                    m_on_disconnected;
-    std::function<void()>                    m_on_version;
+    transport   m_transport;
+    bool        m_connected,
+                m_writing,
+                m_read_paused,
+                m_read_waiting,  // An async_wait is pending
+                m_read_posted,   // A handle_read is posted
+                m_dispatching;   // Handlers are given a message
+    session     m_session;
+    std::string m_out_flight; // Pooled, written from the session output
+    std::atomic<error_code> m_lasterror; // Set by the commands, from any thread
+
+    // Where the application lines end in the output, for the delivery accounting
+    struct send_mark
+    {
+        std::uint64_t         end;
+        std::size_t           lines;
+        detail::write_waiter *waiter;
+    };
+
+    std::vector<send_mark> m_marks;
+    std::size_t            m_marks_head;
+    std::uint64_t          m_out_taken;  // Output bytes moved to flights
+    delivery_stats         m_delivery;
+
+    std::atomic<trace_ring *> m_trace;
+
+    detail::message_waiter  *m_waiters,
+                           **m_waiters_tail;
+    boost::asio::steady_timer m_timer;
+    detail::message_waiter::clock::time_point m_timer_expiry;
+    std::chrono::milliseconds m_request_timeout;
+
+    struct ctcp_entry
+    {
+        ctcp_handler handler;
+        bool         replies;
+    };
+
+    std::unordered_map<std::string, ctcp_entry> m_ctcp;
+    ctcp_limiter m_ctcp_limiter;
+
+    std::unique_ptr<backlog>     m_backlog;
+
+    std::unique_ptr<trigger_set> m_triggers;
+    std::vector<trigger_handler> m_trigger_handlers; // By trigger identifier
+
+    worker_pool::ptr m_workers;
+#ifdef IRC_CLIENT_HAS_IO_URING
+    uring_service::ptr     m_uring;
+    uring_service::id_type m_uring_id;
+    uring_link             m_uring_link;
+#endif
+
+    static const std::size_t message_events = 5;
+    std::unique_ptr<message_bus> m_buses[message_events]; // By message_event
+
+    dcc_manager::ptr m_dcc;
+    std::string      m_dcc_address;
+
+    std::unique_ptr<isupport> m_isupport_next; // Filled while registering only
+    std::string               m_isupport_key;  // Its 005 tokens
+    isupport::ptr             m_isupport;
+
+    flow_options              m_flow;
+    flow_stats                m_flow_stats;
+    std::atomic<std::size_t>  m_held;
+    std::atomic<bool>         m_flow_paused;
+    flow_stats::clock::time_point m_paused_since;
+
+    hostmask_cache m_hostmasks;
+    hostmask_view  m_sender;
+
+    list_filter m_list_filter;
+    std::function<bool(const list_entry_view &)>   m_on_list_entry;
+    std::function<void(const system_error_code &)> m_on_list_end;
+
+    // Handlers are shared by the clients set up alike, copied on write
+    struct handler_table
+    {
+        std::function<void(const message_view &)> on_message;
+        std::function<void()> on_unknown;
+        std::function<void(const std::string &,
+                           const std::string &,
+                           const std::string &)> on_invite;
+        std::function<void(const std::string &,
+                           const std::string &,
+                           const std::string &)> on_channtc;
+        std::function<void(const std::string &,
+                           const std::string &,
+                           const std::string &)> on_privntc;
+        std::function<void(const std::string &,
+                           const std::string &,
+                           const std::string &)> on_chanmsg;
+        std::function<void(const std::string &,
+                           const std::string &,
+                           const std::string &)> on_privmsg;
+        std::function<void(const std::string &)> on_action;
+        std::function<void(const std::string &)> on_dcc_req;
+        std::function<void(const std::string &, const dcc_request &)> on_dcc_send;
+        std::function<void(reply_code)>          on_numeric;
+        std::function<void()>                    on_connected;
+        std::function<void()>                    on_disconnected;
+        std::function<void()>                    on_version;
+    };
+
+    handler_table &handlers()
+    {
+        if( m_handlers.use_count() > 1 )
+            m_handlers = std::make_shared<handler_table>( *m_handlers );
+
+        return *m_handlers;
+    }
+
+    static const std::shared_ptr<handler_table> &no_handlers()
+    {
+        static const std::shared_ptr<handler_table> table = std::make_shared<handler_table>();
+        return table;
+    }
+
+    std::shared_ptr<handler_table> m_handlers;
 };
 
 } // namespace irc
@@ -0,0 +1,204 @@
+/*
+    Name:        irc/ctcp.hpp
+    Purpose:     CTCP tokenizer and reply rate limiter
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_CTCP_HPP
+#define IRC_CTCP_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <boost/utility/string_view.hpp>
+
+namespace irc {
+
+/** A tokenized CTCP message, the views point into the parsed text. */
+struct ctcp_message
+{
+    boost::string_view command; /**< The CTCP command, as sent. */
+    boost::string_view args;    /**< The command arguments, may be empty. */
+};
+/**
+    Tokenizes a CTCP message: "\x01COMMAND [args]\x01".
+    The closing delimiter is optional, as some clients omit it.
+    @param text The PRIVMSG or NOTICE text.
+    @param ctcp The tokenized message.
+    @return @true if text is a CTCP message, @false otherwise.
+*/
+inline bool parse_ctcp( boost::string_view text, ctcp_message &ctcp )
+{
+    if( text.size() < 2 || text[0] != '\x01' )
+        return false;
+
+    text.remove_prefix(1);
+    if( text.back() == '\x01' )
+        text.remove_suffix(1);
+
+    std::size_t space = text.find(' ');
+    ctcp.command = text.substr( 0, space );
+    ctcp.args    = space == boost::string_view::npos ? boost::string_view()
+                                                     : text.substr( space + 1 );
+    return !ctcp.command.empty();
+}
+
+/** CTCP replies rate limits, rates are replies per second. */
+struct ctcp_limits
+{
+    ctcp_limits()
+    :   global_rate(2.0),
+        global_burst(5),
+        source_rate(0.2),
+        source_burst(2)
+    {}
+
+    double   global_rate;  /**< Replies per second to everybody. */
+    unsigned global_burst; /**< Replies allowed at once to everybody. */
+    double   source_rate;  /**< Replies per second to a single host. */
+    unsigned source_burst; /**< Replies allowed at once to a single host. */
+};
+
+/** CTCP requests counters. */
+struct ctcp_stats
+{
+    ctcp_stats()
+    :   answered(0),
+        suppressed_global(0),
+        suppressed_source(0)
+    {}
+
+    std::uint64_t answered,          /**< Requests passed to their handler. */
+                  suppressed_global, /**< Requests dropped by the global limit. */
+                  suppressed_source; /**< Requests dropped by a per host limit. */
+};
+/**
+    @class ctcp_limiter
+
+    Token buckets limiting the CTCP requests a client answers, globally and
+    per source host, so a flood of requests can not make the client flood
+    itself off the server. Not thread safe, it is used by the client's
+    io_service thread only.
+*/
+class ctcp_limiter
+{
+public:
+    typedef std::chrono::steady_clock clock;
+/**
+    Constructor.
+    @param limits The rate limits.
+*/
+    explicit ctcp_limiter( const ctcp_limits &limits = ctcp_limits() )
+    :   m_limits(limits)
+    {
+        m_global.tokens = limits.global_burst;
+        m_global.stamp  = clock::now();
+    }
+/**
+    Changes the rate limits.
+    @param limits The new rate limits.
+*/
+    void limits( const ctcp_limits &limits )
+    {
+        m_limits        = limits;
+        m_global.tokens = limits.global_burst;
+        m_sources.clear();
+    }
+/**
+    Returns the rate limits.
+    @return The rate limits.
+*/
+    const ctcp_limits &limits() const { return m_limits; }
+/**
+    Takes a reply token for a source.
+    @param source The request source, usually its host.
+    @return @true if the request can be answered, @false if it must be dropped.
+*/
+    bool allow( boost::string_view source )
+    {
+        clock::time_point now = clock::now();
+
+        if( !refill( m_global, now, m_limits.global_rate, m_limits.global_burst ) )
+        {
+            ++m_stats.suppressed_global;
+            return false;
+        }
+
+        if( m_sources.size() >= max_sources )
+            prune( now );
+
+        std::string key( source.data(), source.size() );
+        std::unordered_map<std::string, bucket>::iterator it = m_sources.find( key );
+        if( it == m_sources.end() )
+        {
+            bucket b = { static_cast<double>( m_limits.source_burst ), now };
+            it = m_sources.insert( std::make_pair( std::move( key ), b ) ).first;
+        }
+
+        if( !refill( it->second, now, m_limits.source_rate, m_limits.source_burst ) )
+        {
+            ++m_stats.suppressed_source;
+            return false;
+        }
+
+        m_global.tokens    -= 1.0;
+        it->second.tokens  -= 1.0;
+        ++m_stats.answered;
+        return true;
+    }
+/**
+    Returns the requests counters.
+    @return The requests counters.
+*/
+    const ctcp_stats &stats() const { return m_stats; }
+
+private:
+    static const std::size_t max_sources = 4096;
+
+    struct bucket
+    {
+        double            tokens;
+        clock::time_point stamp;
+    };
+
+    static bool refill( bucket &b, clock::time_point now, double rate, unsigned burst )
+    {
+        double elapsed = std::chrono::duration<double>( now - b.stamp ).count();
+        b.tokens += elapsed * rate;
+        if( b.tokens > burst )
+            b.tokens = burst;
+
+        b.stamp = now;
+        return b.tokens >= 1.0;
+    }
+
+    // Forget the sources whose bucket is full again, they are idle
+    void prune( clock::time_point now )
+    {
+        for( std::unordered_map<std::string, bucket>::iterator it = m_sources.begin();
+             it != m_sources.end(); )
+        {
+            refill( it->second, now, m_limits.source_rate, m_limits.source_burst );
+            if( it->second.tokens >= m_limits.source_burst )
+                it = m_sources.erase( it );
+            else
+                ++it;
+        }
+        // Still flooded by many hosts: the global bucket protects us anyway
+        if( m_sources.size() >= max_sources )
+            m_sources.clear();
+    }
+
+    ctcp_limits                             m_limits;
+    ctcp_stats                              m_stats;
+    bucket                                  m_global;
+    std::unordered_map<std::string, bucket> m_sources;
+};
+
+} // namespace irc
+
+#endif // IRC_CTCP_HPP
@@ -0,0 +1,444 @@
+/*
+    Name:        irc/dcc.hpp
+    Purpose:     DCC file transfers
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_DCC_HPP
+#define IRC_DCC_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/asio.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/utility/string_view.hpp>
+
+namespace irc {
+
+/** A tokenized "DCC <type> <argument> ..." CTCP request. */
+struct dcc_request
+{
+    dcc_request() : port(0), position(0) {}
+
+    std::string   type;     /**< SEND, RESUME, ACCEPT, CHAT... uppercased. */
+    std::string   filename; /**< The file name, unquoted. */
+    std::string   address;  /**< The sender address, dotted or IPv6. */
+    std::uint16_t port;     /**< The sender port. */
+    std::uint64_t position; /**< The file size for SEND, the offset for RESUME/ACCEPT. */
+};
+/**
+    Tokenizes the arguments of a DCC CTCP request, the "DCC " prefix excluded:
+    "SEND <filename> <ip> <port> <size>", "RESUME <filename> <port> <position>"
+    and "ACCEPT <filename> <port> <position>". Filenames containing spaces are
+    double quoted, 32 bit integer IPv4 addresses are converted to dotted form.
+    @param args The DCC request arguments.
+    @param dcc  The tokenized request.
+    @return @true if args is a well formed request, @false otherwise.
+*/
+bool parse_dcc( boost::string_view args, dcc_request &dcc );
+
+/** Transfers settings. */
+struct dcc_options
+{
+    dcc_options()
+    :   rate_limit(0),
+        chunk_size(256u << 10),
+        ack_interval(0),
+        port_min(0),
+        port_max(0),
+        connect_timeout(120),
+        resume(true)
+    {}
+
+    std::uint64_t        rate_limit;      /**< Bytes per second sent, 0 is unlimited. */
+    std::size_t          chunk_size;      /**< Bytes moved per socket turn, the receive
+                                               buffer size. */
+    std::size_t          ack_interval;    /**< Received bytes acknowledged at once, 0 acks
+                                               every read. Senders waiting for each ack
+                                               stall with large values. */
+    std::uint16_t        port_min,        /**< Listening ports range, 0 lets */
+                         port_max;        /**< the system choose one. */
+    std::chrono::seconds connect_timeout; /**< Time allowed to connect the transfer. */
+    bool                 resume;          /**< Resume a partially received file. */
+};
+
+/** A transfer progress, taken at any time. */
+struct dcc_progress
+{
+    dcc_progress() : size(0), offset(0), transferred(0), acked(0), rate(0) {}
+
+    std::uint64_t size;        /**< The file size. */
+    std::uint64_t offset;      /**< The resumed position, 0 for a full transfer. */
+    std::uint64_t transferred; /**< Bytes moved by this session, offset excluded. */
+    std::uint64_t acked;       /**< File position acknowledged by the receiver. */
+    double        rate;        /**< Bytes per second since the transfer connected. */
+};
+
+/** Aggregate counters of a dcc_manager. */
+struct dcc_stats
+{
+    dcc_stats() : active(0), completed(0), failed(0), bytes_sent(0), bytes_received(0) {}
+
+    std::size_t   active;         /**< Transfers in progress or connecting. */
+    std::uint64_t completed,      /**< Transfers completed successfully. */
+                  failed,         /**< Transfers failed or cancelled. */
+                  bytes_sent,     /**< Bytes sent by all transfers. */
+                  bytes_received; /**< Bytes received by all transfers. */
+};
+
+class dcc_manager;
+
+namespace detail {
+
+// Token bucket counting bytes, a zero rate is unlimited
+struct byte_bucket
+{
+    typedef std::chrono::steady_clock clock;
+
+    byte_bucket() : rate(0), tokens(0) {}
+
+    void limit( std::uint64_t bytes_per_second )
+    {
+        rate   = static_cast<double>( bytes_per_second );
+        tokens = burst();
+        stamp  = clock::now();
+    }
+
+    // Up to a quarter of a second of traffic at once, never below 16 KiB
+    double burst() const { return rate / 4 > 16384 ? rate / 4 : 16384; }
+
+    std::size_t available( clock::time_point now )
+    {
+        if( !rate )
+            return static_cast<std::size_t>( -1 );
+
+        tokens += std::chrono::duration<double>( now - stamp ).count() * rate;
+        if( tokens > burst() )
+            tokens = burst();
+
+        stamp = now;
+        return tokens > 0 ? static_cast<std::size_t>( tokens ) : 0;
+    }
+
+    void consume( std::size_t bytes )
+    {
+        if( rate )
+            tokens -= static_cast<double>( bytes );
+    }
+
+    // Time to wait before a chunk of some size fits
+    clock::duration delay( std::size_t bytes ) const
+    {
+        double need = bytes < burst() ? bytes : burst();
+        double wait = rate && tokens < need ? ( need - tokens ) / rate : 0;
+        return std::chrono::duration_cast<clock::duration>(
+            std::chrono::duration<double>( wait > 0.001 ? wait : 0.001 ) );
+    }
+
+    double            rate,
+                      tokens;
+    clock::time_point stamp;
+};
+
+struct aligned_free
+{
+    void operator()( char *ptr ) const { std::free( ptr ); }
+};
+
+} // namespace detail
+/**
+    @class dcc_transfer
+
+    Base of the DCC file transfers, owned by a dcc_manager.
+*/
+class dcc_transfer: public std::enable_shared_from_this< dcc_transfer >
+                  , boost::noncopyable
+{
+public:
+/** Shared transfer pointer */
+    typedef std::shared_ptr< dcc_transfer > ptr;
+/** Completion handler, called once with the final progress. */
+    typedef std::function<void(const boost::system::error_code &,
+                               const dcc_progress &)> handler;
+/** Progress handler, called periodically while the transfer runs. */
+    typedef std::function<void(const dcc_progress &)> progress_handler;
+
+/** Destructor. */
+    virtual ~dcc_transfer();
+/**
+    Returns the transferred file name.
+    @return The file name, without its directory.
+*/
+    const std::string &filename() const { return m_filename; }
+/**
+    Returns the transfer port, listened on when sending, connected to when receiving.
+    @return The transfer port.
+*/
+    std::uint16_t port() const { return m_port; }
+/**
+    Returns the transfer progress.
+    @return The transfer progress.
+*/
+    dcc_progress progress() const;
+/**
+    Reports the progress periodically, until the transfer ends.
+    @param func     The progress handler, an empty function stops the reports.
+    @param interval Time between two reports.
+*/
+    void on_progress( progress_handler func,
+                      std::chrono::milliseconds interval = std::chrono::milliseconds(1000) );
+/**
+    Aborts the transfer, the handler completes with operation_aborted.
+*/
+    void cancel();
+
+protected:
+    friend class dcc_manager;
+
+    typedef std::chrono::steady_clock clock;
+
+    dcc_transfer( std::shared_ptr< dcc_manager > manager, int fd, std::uint64_t size,
+                  const std::string &filename, const dcc_options &opts, handler func );
+
+    void start_timeout();
+    void connected();
+    void finish( const boost::system::error_code &ec );
+
+    // Releases the transfer's own resources when it ends
+    virtual void stopped( const boost::system::error_code &ec ) = 0;
+
+    std::shared_ptr< dcc_manager > m_manager;
+    boost::asio::ip::tcp::socket   m_socket;
+    boost::asio::steady_timer      m_timer,
+                                   m_progress_timer;
+    int                            m_fd;
+    std::string                    m_filename;
+    dcc_options                    m_options;
+    handler                        m_handler;
+    progress_handler               m_on_progress;
+    std::chrono::milliseconds      m_progress_interval;
+    std::uint16_t                  m_port;
+    std::uint64_t                  m_size,
+                                   m_offset,
+                                   m_position,
+                                   m_acked;
+    bool                           m_started,
+                                   m_done;
+    clock::time_point              m_start;
+
+private:
+    void report( const boost::system::error_code &ec );
+};
+/**
+    @class dcc_sender
+
+    An outgoing DCC SEND transfer, created by dcc_manager::send().
+
+    The sender listens for the receiver's connection, then streams the file
+    straight from the page cache to the socket with sendfile(2) on Linux,
+    a buffered copy loop elsewhere, one chunk per socket turn so that many
+    transfers share an io_service thread fairly.
+    The receiver's 32 bit acknowledgements are read concurrently and never
+    block the stream, files larger than 4 GiB wrap them around as usual.
+*/
+class dcc_sender: public dcc_transfer
+{
+public:
+/** Shared sender pointer */
+    typedef std::shared_ptr< dcc_sender > ptr;
+/**
+    Changes the transfer bandwidth limit.
+    @param bytes_per_second The new limit, 0 is unlimited.
+*/
+    void rate_limit( std::uint64_t bytes_per_second ) { m_bucket.limit( bytes_per_second ); }
+
+private:
+    friend class dcc_manager;
+
+    dcc_sender( std::shared_ptr< dcc_manager > manager, int fd, std::uint64_t size,
+                const std::string &filename, const dcc_options &opts, handler func );
+
+    ptr self() { return std::static_pointer_cast< dcc_sender >( shared_from_this() ); }
+
+    boost::system::error_code listen( const boost::asio::ip::address &address );
+    bool resume( std::uint64_t position );
+    void stopped( const boost::system::error_code &ec );
+    void handle_accept( const boost::system::error_code &ec );
+    void wait_writable();
+    void handle_writable( const boost::system::error_code &ec );
+    void read_ack();
+    void handle_ack( const boost::system::error_code &ec, std::size_t bytes );
+
+    boost::asio::ip::tcp::acceptor m_acceptor;
+    unsigned char                  m_ack[4];
+    std::size_t                    m_ack_size;
+    detail::byte_bucket            m_bucket;
+    std::vector<char>              m_buffer; // Copy loop only, where sendfile is missing
+};
+/**
+    @class dcc_receiver
+
+    An incoming DCC SEND transfer, created by dcc_manager::receive().
+
+    The file is preallocated, then written from a large page aligned buffer
+    with one pwrite(2) per socket read, acknowledging the received position
+    once per read or every dcc_options::ack_interval bytes.
+    A partially received file is resumed: the receiver waits for the
+    sender's DCC ACCEPT, passed to dcc_manager::accept(), before connecting.
+*/
+class dcc_receiver: public dcc_transfer
+{
+public:
+/** Shared receiver pointer */
+    typedef std::shared_ptr< dcc_receiver > ptr;
+/**
+    Returns the position to resume from.
+    @return The size of the partial file, 0 if the transfer starts over.
+*/
+    std::uint64_t resume_position() const { return m_offset; }
+
+private:
+    friend class dcc_manager;
+
+    dcc_receiver( std::shared_ptr< dcc_manager > manager, int fd, std::uint64_t size,
+                  std::uint64_t offset, const dcc_request &offer,
+                  const dcc_options &opts, handler func );
+
+    ptr self() { return std::static_pointer_cast< dcc_receiver >( shared_from_this() ); }
+
+    void start();
+    void stopped( const boost::system::error_code &ec );
+    void handle_connect( const boost::system::error_code &ec );
+    void read_some();
+    void handle_read( const boost::system::error_code &ec, std::size_t bytes );
+    void send_ack();
+    void handle_ack( const boost::system::error_code &ec );
+
+    boost::asio::ip::tcp::endpoint                m_endpoint;
+    std::unique_ptr< char, detail::aligned_free > m_buffer;
+    unsigned char                                 m_ack[4];
+    std::uint64_t                                 m_unacked;
+    bool                                          m_ack_writing,
+                                                  m_ack_pending;
+};
+/**
+    @class dcc_manager
+
+    Owns the DCC transfers of a client and enforces their aggregate
+    bandwidth limit. All transfers run on the manager's io_service,
+    without a thread per transfer; it must be run by a single thread,
+    as for the client.
+*/
+class dcc_manager: public std::enable_shared_from_this< dcc_manager >
+                 , boost::noncopyable
+{
+public:
+/** Shared manager pointer */
+    typedef std::shared_ptr< dcc_manager > ptr;
+/**
+    Static constructor.
+    @param io_service The io_service running the transfers.
+    @return Shared pointer to a new manager object.
+*/
+    static ptr create( boost::asio::io_service &io_service );
+/**
+    Starts listening for a DCC SEND receiver.
+    Errors opening the file or the listening socket are reported through
+    the handler, as any later failure.
+    @param path    The file to send.
+    @param address The local address to listen on.
+    @param func    The completion handler.
+    @param opts    The transfer settings.
+    @return The new transfer, nullptr on failure.
+*/
+    dcc_sender::ptr send( const std::string &path,
+                          const boost::asio::ip::address &address,
+                          dcc_transfer::handler func,
+                          const dcc_options &opts = dcc_options() );
+/**
+    Accepts a DCC SEND offer, writing the file to path.
+    When path is a partial copy of the offered file and dcc_options::resume
+    is set, the receiver waits for accept() after the caller asked the
+    sender to resume from resume_position(), otherwise it connects at once.
+    With dcc_options::resume set, a path already as large as the offered
+    file completes at once with success, without a transfer, and a larger
+    one fails with invalid_argument.
+    @param offer The DCC SEND request, see parse_dcc().
+    @param path  The file to write.
+    @param func  The completion handler.
+    @param opts  The transfer settings.
+    @return The new transfer, nullptr on failure.
+*/
+    dcc_receiver::ptr receive( const dcc_request &offer, const std::string &path,
+                               dcc_transfer::handler func,
+                               const dcc_options &opts = dcc_options() );
+/**
+    Moves a transfer not yet connected to a resume position, as requested
+    by the receiver with DCC RESUME.
+    @param port     The transfer's listening port.
+    @param position The file position to start from.
+    @return The transfer, nullptr if none is waiting on port or position is invalid.
+*/
+    dcc_sender::ptr resume( std::uint16_t port, std::uint64_t position );
+/**
+    Starts a resumed receive, as confirmed by the sender with DCC ACCEPT.
+    @param port     The sender's port.
+    @param position The accepted position.
+    @return The transfer, nullptr if none is waiting for port and position.
+*/
+    dcc_receiver::ptr accept( std::uint16_t port, std::uint64_t position );
+/**
+    Sets the bandwidth limit of all transfers sending together.
+    @param bytes_per_second The aggregate limit, 0 is unlimited.
+*/
+    void rate_limit( std::uint64_t bytes_per_second ) { m_bucket.limit( bytes_per_second ); }
+/**
+    Returns the aggregate counters.
+    @return The transfers counters.
+*/
+    const dcc_stats &stats() const { return m_stats; }
+/**
+    Returns the current aggregate throughput.
+    @return The sum of the active transfers rates, in bytes per second.
+*/
+    double rate() const;
+/**
+    Aborts all transfers.
+*/
+    void close();
+
+private:
+    friend class dcc_transfer;
+    friend class dcc_sender;
+    friend class dcc_receiver;
+
+    explicit dcc_manager( boost::asio::io_service &io_service )
+    :   m_service(io_service)
+    {}
+
+    void add( dcc_transfer::ptr transfer );
+    void remove( dcc_transfer *transfer, const boost::system::error_code &ec );
+
+    boost::asio::io_service          &m_service;
+    dcc_stats                         m_stats;
+    detail::byte_bucket               m_bucket;
+    std::vector< dcc_transfer::ptr >  m_transfers;
+};
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/dcc.ipp"
+#endif
+
+#endif // IRC_DCC_HPP
@@ -0,0 +1,39 @@
+/*
+    Name:        irc/delivery.hpp
+    Purpose:     Write side counters of the lines sent by the application
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_DELIVERY_HPP
+#define IRC_DELIVERY_HPP
+
+#include <cstdint>
+
+namespace irc {
+
+/**
+    Counters of the lines queued by the application, the ones answered by
+    the protocol itself (registration, PONG, keepalive) excluded. A line
+    is written once the transport took all its bytes; the lines still
+    queued or in flight when a connection is lost are discarded, not sent
+    to the next one. The lines pending are the accepted ones less the
+    written and the discarded ones.
+*/
+struct delivery_stats
+{
+    delivery_stats()
+    :   accepted(0),
+        written(0),
+        discarded(0)
+    {}
+
+    std::uint64_t accepted,  /**< Lines queued. */
+                  written,   /**< Lines written to the transport. */
+                  discarded; /**< Lines dropped with a lost connection. */
+};
+
+} // namespace irc
+
+#endif // IRC_DELIVERY_HPP
@@ -0,0 +1,44 @@
+/*
+    Name:        irc/detail/base64.hpp
+    Purpose:     Base64 encoding for SASL payloads
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_DETAIL_BASE64_HPP
+#define IRC_DETAIL_BASE64_HPP
+
+#include <string>
+
+#include <boost/utility/string_view.hpp>
+
+namespace irc {
+namespace detail {
+
+inline std::string base64_encode( boost::string_view data )
+{
+    static const char digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string out;
+    out.reserve( ( data.size() + 2 ) / 3 * 4 );
+    for( std::size_t i = 0; i < data.size(); i += 3 )
+    {
+        unsigned long chunk = static_cast<unsigned char>( data[i] ) << 16;
+        if( i + 1 < data.size() )
+            chunk |= static_cast<unsigned char>( data[i + 1] ) << 8;
+        if( i + 2 < data.size() )
+            chunk |= static_cast<unsigned char>( data[i + 2] );
+
+        out += digits[ ( chunk >> 18 ) & 63 ];
+        out += digits[ ( chunk >> 12 ) & 63 ];
+        out += i + 1 < data.size() ? digits[ ( chunk >> 6 ) & 63 ] : '=';
+        out += i + 2 < data.size() ? digits[ chunk & 63 ] : '=';
+    }
+    return out;
+}
+
+} // namespace detail
+} // namespace irc
+
+#endif // IRC_DETAIL_BASE64_HPP
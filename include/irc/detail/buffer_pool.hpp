@@ -0,0 +1,77 @@
+/*
+    Name:        irc/detail/buffer_pool.hpp
+    Purpose:     Process wide pool of connection buffers
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_DETAIL_BUFFER_POOL_HPP
+#define IRC_DETAIL_BUFFER_POOL_HPP
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace irc {
+namespace detail {
+
+// Connections take a buffer while they have bytes to read or write and
+// give it back when idle, so thousands of idle clients hold no buffer
+class buffer_pool
+{
+public:
+    static const std::size_t buffer_size  = 4096,
+                             max_capacity = 65536, // Larger buffers are freed
+                             max_free     = 1024;
+
+    static buffer_pool &instance()
+    {
+        static buffer_pool pool;
+        return pool;
+    }
+
+    // Gives buffer a pooled capacity, if it has none
+    void acquire( std::string &buffer )
+    {
+        if( buffer.capacity() >= buffer_size )
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if( !m_free.empty() )
+            {
+                buffer.swap( m_free.back() );
+                m_free.pop_back();
+                return;
+            }
+        }
+        buffer.reserve( buffer_size );
+    }
+
+    // Takes the capacity of an empty buffer back
+    void release( std::string &buffer )
+    {
+        if( !buffer.empty() || buffer.capacity() < buffer_size )
+            return;
+
+        std::string taken;
+        taken.swap( buffer );
+        if( taken.capacity() > max_capacity )
+            return;
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if( m_free.size() < max_free )
+            m_free.push_back( std::move( taken ) );
+    }
+
+private:
+    std::mutex               m_mutex;
+    std::vector<std::string> m_free;
+};
+
+} // namespace detail
+} // namespace irc
+
+#endif // IRC_DETAIL_BUFFER_POOL_HPP
@@ -0,0 +1,237 @@
+/*
+    Name:        irc/detail/request.hpp
+    Purpose:     Numeric replies collectors for correlated requests
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_DETAIL_REQUEST_HPP
+#define IRC_DETAIL_REQUEST_HPP
+
+#include <boost/asio/error.hpp>
+
+#include "irc/reply.hpp"
+#include "irc/detail/waiter.hpp"
+
+namespace irc {
+namespace detail {
+
+inline void split_words( std::vector<std::string> &words, boost::string_view str )
+{
+    while( !str.empty() )
+    {
+        std::size_t space = str.find(' ');
+        if( space )
+            words.push_back( str.substr( 0, space ).to_string() );
+
+        str.remove_prefix( space == boost::string_view::npos ? str.size() : space + 1 );
+    }
+}
+
+// Leading decimal digits, as strtoll without a copy to terminate the text
+inline long long to_number( boost::string_view str )
+{
+    long long value = 0;
+    for( char ch : str )
+    {
+        if( ch < '0' || ch > '9' )
+            break;
+        value = value * 10 + ( ch - '0' );
+    }
+    return value;
+}
+
+/*
+    Base of the request collectors, completes with ( error_code, Result ).
+    Collectors are exclusive waiters: the server answers in order, so the
+    oldest pending request for a target owns the next reply for it.
+*/
+template< typename Result >
+struct request_matcher
+{
+    static const bool exclusive = true;
+
+    request_matcher() : error(0), mapping(casemapping::rfc1459) {}
+
+    template< typename Handler, typename Executor >
+    void complete( Handler &handler, const Executor &ex,
+                   const boost::system::error_code &ec, const message & )
+    {
+        boost::system::error_code result = ec;
+        if( !result && error )
+            result = boost::system::error_code( error, reply_category() );
+
+        dispatch_result( handler, ex, result, std::move( reply ) );
+    }
+
+    Result      reply;
+    int         error;   // Failure numeric, 0 on success
+    casemapping mapping; // Target comparison rules
+};
+
+struct names_matcher: request_matcher< names_reply >
+{
+    wait_result on_message( const message &msg )
+    {
+        int code = static_cast<int>( msg.code() );
+        if( code != 353 && code != 366 && code != 403 )
+            return wait_result::ignored;
+
+        std::size_t count = msg.param_count();
+        if( code == 353 )
+        {
+            // <me> [=*@] <channel> :<nicknames>
+            if( count < 3 || !iequals( msg.param( count - 2 ), reply.channel, mapping ) )
+                return wait_result::ignored;
+
+            split_words( reply.nicknames, msg.param( count - 1 ) );
+            return wait_result::consumed;
+        }
+
+        if( count < 2 || !iequals( msg.param(1), reply.channel, mapping ) )
+            return wait_result::ignored;
+
+        // ERR_NOSUCHCHANNEL is followed by RPL_ENDOFNAMES on most servers
+        if( code == 403 )
+        {
+            error = code;
+            return wait_result::consumed;
+        }
+        return wait_result::completed;
+    }
+};
+
+struct whois_matcher: request_matcher< whois_reply >
+{
+    wait_result on_message( const message &msg )
+    {
+        int code = static_cast<int>( msg.code() );
+        if( code != 401 && ( code < 311 || code > 319 ) )
+            return wait_result::ignored;
+
+        std::size_t count = msg.param_count();
+        if( count < 2 || !iequals( msg.param(1), reply.nickname, mapping ) )
+            return wait_result::ignored;
+
+        switch( code )
+        {
+        case 311: // <me> <nick> <user> <host> * :<real name>
+            if( count > 5 )
+            {
+                reply.username = msg.param(2).to_string();
+                reply.hostname = msg.param(3).to_string();
+                reply.realname = msg.param(5).to_string();
+            }
+            break;
+        case 312: // <me> <nick> <server> :<server info>
+            if( count > 3 )
+            {
+                reply.server      = msg.param(2).to_string();
+                reply.server_info = msg.param(3).to_string();
+            }
+            break;
+        case 313:
+            reply.is_operator = true;
+            break;
+        case 317: // <me> <nick> <idle> [<signon>] :seconds idle
+            if( count > 3 )
+                reply.idle = static_cast<unsigned long>( to_number( msg.param(2) ) );
+            if( count > 4 )
+                reply.signon = static_cast<std::time_t>( to_number( msg.param(3) ) );
+            break;
+        case 318:
+            return wait_result::completed;
+        case 319: // <me> <nick> :<channels>
+            if( count > 2 )
+                split_words( reply.channels, msg.param( count - 1 ) );
+            break;
+        case 401: // Followed by RPL_ENDOFWHOIS
+            error = code;
+            break;
+        default: // 314-316 belong to WHOWAS, WHO and the like
+            return wait_result::ignored;
+        }
+        return wait_result::consumed;
+    }
+};
+
+struct list_matcher: request_matcher< list_reply >
+{
+    wait_result on_message( const message &msg )
+    {
+        int code = static_cast<int>( msg.code() );
+        if( code == 321 )
+            return wait_result::consumed;
+        if( code == 323 )
+            return wait_result::completed;
+        if( code != 322 )
+            return wait_result::ignored;
+
+        // <me> <channel> <users> :<topic>
+        if( msg.param_count() < 3 )
+            return wait_result::consumed;
+
+        list_entry entry;
+        entry.channel = msg.param(1).to_string();
+        entry.users   = static_cast<unsigned>( to_number( msg.param(2) ) );
+        entry.topic   = msg.param(3).to_string();
+
+        reply.channels.push_back( std::move( entry ) );
+        return wait_result::consumed;
+    }
+};
+
+struct mode_matcher: request_matcher< mode_reply >
+{
+    mode_matcher() : got_modes(false) {}
+
+    wait_result on_message( const message &msg )
+    {
+        int code = static_cast<int>( msg.code() );
+        if( code == 324 || code == 329 || code == 403 || code == 442 || code == 477 )
+        {
+            if( msg.param_count() > 2 && iequals( msg.param(1), reply.channel, mapping ) )
+            {
+                if( code == 324 ) // <me> <channel> <modes> <mode params>
+                {
+                    reply.modes = msg.param(2).to_string();
+                    reply.arguments.clear();
+                    for( std::size_t i = 3; i < msg.param_count(); ++i )
+                        reply.arguments.push_back( msg.param(i).to_string() );
+                    got_modes = true;
+                    return wait_result::consumed;
+                }
+                if( code == 329 ) // <me> <channel> <creation time>
+                {
+                    reply.created = static_cast<std::time_t>( to_number( msg.param(2) ) );
+                    return wait_result::completed;
+                }
+                error = code;
+                return wait_result::completed;
+            }
+        }
+        // RPL_CREATIONTIME is optional, it directly follows RPL_CHANNELMODEIS if sent
+        return got_modes ? wait_result::done : wait_result::ignored;
+    }
+
+    // A server quiet after RPL_CHANNELMODEIS leaves the request to expire,
+    // the modes are the reply all the same
+    template< typename Handler, typename Executor >
+    void complete( Handler &handler, const Executor &ex,
+                   const boost::system::error_code &ec, const message &msg )
+    {
+        if( ec == boost::asio::error::timed_out && got_modes )
+            request_matcher< mode_reply >::complete( handler, ex,
+                                                     boost::system::error_code(), msg );
+        else
+            request_matcher< mode_reply >::complete( handler, ex, ec, msg );
+    }
+
+    bool got_modes;
+};
+
+} // namespace detail
+} // namespace irc
+
+#endif // IRC_DETAIL_REQUEST_HPP
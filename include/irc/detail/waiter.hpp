@@ -0,0 +1,236 @@
+/*
+    Name:        irc/detail/waiter.hpp
+    Purpose:     Asynchronous operations waiting for incoming messages
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_DETAIL_WAITER_HPP
+#define IRC_DETAIL_WAITER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "irc/error.hpp"
+#include "irc/isupport.hpp"
+#include "irc/message.hpp"
+
+namespace irc {
+namespace detail {
+
+/* What a waiter did with a received message. */
+enum class wait_result
+{
+    ignored,   // not interested
+    consumed,  // part of the waited reply, more is expected
+    completed, // last part of the waited reply
+    done       // finished before this message, which is left to others
+};
+
+/*
+    A pending operation in the client's intrusive waiters list, fed with
+    every received message until it completes or its deadline expires.
+    Exclusive waiters (request/reply correlation) claim the messages they
+    consume, so a reply is only collected by the oldest matching request.
+*/
+class message_waiter
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    message_waiter( bool is_exclusive )
+    :   next(nullptr),
+        deadline(clock::time_point::max()),
+        exclusive(is_exclusive)
+    {}
+
+    virtual wait_result on_message( const message &msg ) = 0;
+    // Completes the handler and frees this waiter.
+    virtual void complete( const boost::system::error_code &ec, const message &msg ) = 0;
+
+    message_waiter   *next;
+    clock::time_point deadline;
+    bool              exclusive;
+
+protected:
+    ~message_waiter() {}
+};
+
+template< typename Handler >
+struct bound_handler1
+{
+    void operator()() { handler( ec ); }
+
+    Handler                   handler;
+    boost::system::error_code ec;
+};
+
+template< typename Handler, typename Result >
+struct bound_handler2
+{
+    void operator()() { handler( ec, result ); }
+
+    Handler                   handler;
+    boost::system::error_code ec;
+    Result                    result;
+};
+
+template< typename Matcher, typename Handler, typename Executor >
+class waiter_op: public message_waiter
+{
+    typedef typename boost::asio::associated_allocator< Handler >::type handler_allocator;
+    typedef typename std::allocator_traits< handler_allocator >::
+            template rebind_alloc< waiter_op > allocator_type;
+    typedef typename boost::asio::associated_executor< Handler, Executor >::type
+            executor_type;
+
+public:
+    // The node lives in the handler's associated allocator, so completion
+    // tokens recycling their memory do not allocate per operation.
+    static waiter_op *create( Matcher matcher, Handler &handler, const Executor &ex )
+    {
+        allocator_type alloc( boost::asio::get_associated_allocator( handler ) );
+        waiter_op *op = std::allocator_traits< allocator_type >::allocate( alloc, 1 );
+        try
+        {
+            new( op ) waiter_op( std::move( matcher ), std::move( handler ), ex );
+        }
+        catch( ... )
+        {
+            std::allocator_traits< allocator_type >::deallocate( alloc, op, 1 );
+            throw;
+        }
+        return op;
+    }
+
+    wait_result on_message( const message &msg ) { return m_matcher.on_message( msg ); }
+
+    void complete( const boost::system::error_code &ec, const message &msg )
+    {
+        Handler handler( std::move( m_handler ) );
+        Matcher matcher( std::move( m_matcher ) );
+        boost::asio::executor_work_guard< executor_type > work( std::move( m_work ) );
+
+        allocator_type alloc( boost::asio::get_associated_allocator( handler ) );
+        this->~waiter_op();
+        std::allocator_traits< allocator_type >::deallocate( alloc, this, 1 );
+
+        matcher.complete( handler, work.get_executor(), ec, msg );
+    }
+
+private:
+    waiter_op( Matcher &&matcher, Handler &&handler, const Executor &ex )
+    :   message_waiter( Matcher::exclusive ),
+        m_matcher( std::move( matcher ) ),
+        m_handler( std::move( handler ) ),
+        m_work( boost::asio::get_associated_executor( m_handler, ex ) )
+    {}
+
+    Matcher m_matcher;
+    Handler m_handler;
+    boost::asio::executor_work_guard< executor_type > m_work;
+};
+
+/* Accepts every message. */
+struct any_message
+{
+    bool operator()( const message & ) const { return true; }
+};
+
+/* Completes a bound handler on its executor. */
+template< typename Handler, typename Executor, typename Result >
+void dispatch_result( Handler &handler, const Executor &ex,
+                      const boost::system::error_code &ec, Result &&result )
+{
+    typedef typename std::decay<Result>::type result_type;
+    bound_handler2< Handler, result_type > bound = { std::move( handler ), ec,
+                                                     std::forward<Result>( result ) };
+    boost::asio::dispatch( ex, std::move( bound ) );
+}
+
+/* Completes with ( error_code, message ) the first message accepted by a filter. */
+template< typename Filter >
+struct message_matcher
+{
+    static const bool exclusive = false;
+
+    wait_result on_message( const message &msg )
+    {
+        return filter( msg ) ? wait_result::completed : wait_result::ignored;
+    }
+
+    template< typename Handler, typename Executor >
+    void complete( Handler &handler, const Executor &ex,
+                   const boost::system::error_code &ec, const message &msg )
+    {
+        dispatch_result( handler, ex, ec, msg );
+    }
+
+    Filter filter;
+};
+
+/* Completes with ( error_code ) on a numeric in a set, with an optional target. */
+struct reply_matcher
+{
+    static const bool exclusive = false;
+
+    wait_result on_message( const message &msg )
+    {
+        int code = static_cast<int>( msg.code() );
+        if( code == 0 )
+            return on_error && msg.command() == "ERROR" ? wait_result::completed
+                                                        : wait_result::ignored;
+
+        if( code != static_cast<int>( success ) &&
+            std::find( failures, failures + failures_size, code ) == failures + failures_size )
+            return wait_result::ignored;
+
+        if( target.empty() )
+            return wait_result::completed;
+
+        return msg.param_count() > 1 && iequals( msg.param(1), target, mapping )
+               ? wait_result::completed : wait_result::ignored;
+    }
+
+    template< typename Handler, typename Executor >
+    void complete( Handler &handler, const Executor &ex,
+                   const boost::system::error_code &ec, const message &msg )
+    {
+        boost::system::error_code result = ec;
+        if( !result && msg.code() != success )
+        {
+            if( msg.command() == "ERROR" )
+                result = boost::system::error_code( boost::system::errc::connection_aborted,
+                                                    boost::system::generic_category() );
+            else
+                result = boost::system::error_code( static_cast<int>( msg.code() ),
+                                                    reply_category() );
+        }
+
+        bound_handler1< Handler > bound = { std::move( handler ), result };
+        boost::asio::dispatch( ex, std::move( bound ) );
+    }
+
+    reply_code  success;
+    const int  *failures;      // static array of failure numerics
+    std::size_t failures_size;
+    std::string target;
+    bool        on_error;      // ERROR command fails the operation
+    casemapping mapping;       // target comparison rules
+};
+
+} // namespace detail
+} // namespace irc
+
+#endif // IRC_DETAIL_WAITER_HPP
@@ -0,0 +1,100 @@
+/*
+    Name:        irc/detail/write_op.hpp
+    Purpose:     Asynchronous operations waiting for outgoing lines to be written
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_DETAIL_WRITE_OP_HPP
+#define IRC_DETAIL_WRITE_OP_HPP
+
+#include <chrono>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <boost/asio/associated_allocator.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/system/error_code.hpp>
+
+#include "irc/detail/waiter.hpp"
+
+namespace irc {
+namespace detail {
+
+/*
+    A queued line waiting to be written to the transport, or discarded
+    with the connection, completed with the time elapsed since queued.
+*/
+class write_waiter
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    write_waiter() : queued(clock::now()) {}
+
+    // Completes the handler and frees this waiter.
+    virtual void complete( const boost::system::error_code &ec ) = 0;
+
+    clock::time_point queued;
+
+protected:
+    ~write_waiter() {}
+};
+
+template< typename Handler, typename Executor >
+class write_op: public write_waiter
+{
+    typedef typename boost::asio::associated_allocator< Handler >::type handler_allocator;
+    typedef typename std::allocator_traits< handler_allocator >::
+            template rebind_alloc< write_op > allocator_type;
+    typedef typename boost::asio::associated_executor< Handler, Executor >::type
+            executor_type;
+
+public:
+    // As waiter_op, the node lives in the handler's associated allocator
+    static write_op *create( Handler &handler, const Executor &ex )
+    {
+        allocator_type alloc( boost::asio::get_associated_allocator( handler ) );
+        write_op *op = std::allocator_traits< allocator_type >::allocate( alloc, 1 );
+        try
+        {
+            new( op ) write_op( std::move( handler ), ex );
+        }
+        catch( ... )
+        {
+            std::allocator_traits< allocator_type >::deallocate( alloc, op, 1 );
+            throw;
+        }
+        return op;
+    }
+
+    void complete( const boost::system::error_code &ec )
+    {
+        clock::duration latency = clock::now() - queued;
+        Handler handler( std::move( m_handler ) );
+        boost::asio::executor_work_guard< executor_type > work( std::move( m_work ) );
+
+        allocator_type alloc( boost::asio::get_associated_allocator( handler ) );
+        this->~write_op();
+        std::allocator_traits< allocator_type >::deallocate( alloc, this, 1 );
+
+        dispatch_result( handler, work.get_executor(), ec, latency );
+    }
+
+private:
+    write_op( Handler &&handler, const Executor &ex )
+    :   m_handler( std::move( handler ) ),
+        m_work( boost::asio::get_associated_executor( m_handler, ex ) )
+    {}
+
+    Handler m_handler;
+    boost::asio::executor_work_guard< executor_type > m_work;
+};
+
+} // namespace detail
+} // namespace irc
+
+#endif // IRC_DETAIL_WRITE_OP_HPP
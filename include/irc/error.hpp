@@ -9,6 +9,10 @@
 #ifndef IRC_ERROR_HPP
 #define IRC_ERROR_HPP
 
+#include <string>
+
+#include <boost/system/error_code.hpp>
+
 namespace irc {
 
 enum class error_code   /** Error codes. */
@@ -17,6 +21,31 @@ enum class error_code   /** Error codes. */
     invalid_request = 1 /**< Invalid request. */
 };
 
+namespace detail {
+
+class reply_category_impl: public boost::system::error_category
+{
+public:
+    const char *name() const BOOST_NOEXCEPT { return "irc.reply"; }
+
+    std::string message( int ev ) const
+    {
+        return "IRC server replied with numeric " + std::to_string( ev );
+    }
+};
+
+} // namespace detail
+/**
+    Error category of the failures reported by the server as numeric replies,
+    the error value is the reply_code value.
+    @return The numeric replies error category.
+*/
+inline const boost::system::error_category &reply_category()
+{
+    static detail::reply_category_impl instance;
+    return instance;
+}
+
 } // namespace irc
 
 #endif // IRC_ERROR_HPP
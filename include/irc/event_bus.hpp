@@ -0,0 +1,284 @@
+/*
+    Name:        irc/event_bus.hpp
+    Purpose:     Typed multi subscriber events indexed by target
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_EVENT_BUS_HPP
+#define IRC_EVENT_BUS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include "irc/isupport.hpp"
+
+namespace irc {
+/**
+    @class event_bus
+
+    Subscribers of one event type, each one optionally keyed by a channel
+    or a nickname. The keyed subscribers are indexed in a hash table on
+    the key folded by the server case mapping, so a dispatch only touches
+    the subscribers of its key, then the unkeyed ones, each list in
+    subscription order.
+
+    A subscriber may subscribe or unsubscribe while the event is being
+    dispatched: unsubscribed ones are not called any more and are only
+    removed once the outermost dispatch returns, new ones are called from
+    the next dispatch. Not thread safe.
+
+    @tparam Signature The subscribers signature, as void(const std::string &).
+*/
+template< typename Signature >
+class event_bus : private boost::noncopyable
+{
+public:
+/** Subscriber function */
+    typedef std::function< Signature > handler_type;
+/** Subscription identifier, reused once unsubscribed. */
+    typedef std::uint32_t id_type;
+
+/** Invalid subscription identifier. */
+    static const id_type npos = 0xffffffff;
+/**
+    Constructor.
+    @param mapping The keys case mapping rules.
+*/
+    explicit event_bus( casemapping mapping = casemapping::rfc1459 )
+    :   m_mapping(mapping),
+        m_size(0),
+        m_depth(0)
+    {}
+/**
+    Adds a subscriber.
+    @param func The subscriber.
+    @param key  The channel or nickname it is interested in, empty for all.
+    @return The subscription identifier, npos if func is empty.
+*/
+    id_type subscribe( handler_type func, boost::string_view key = boost::string_view() );
+/**
+    Removes a subscriber.
+    @param id The subscription identifier.
+    @return @true if removed, @false if id is unknown.
+*/
+    bool unsubscribe( id_type id );
+/**
+    Calls a function for each subscriber of a key and for the unkeyed ones.
+    @param key  The event channel or nickname.
+    @param call The function, as void(const handler_type &), which calls or
+                copies the subscriber.
+    @return The number of subscribers.
+*/
+    template< typename Call >
+    std::size_t dispatch( boost::string_view key, Call call );
+/**
+    Calls the subscribers of a key and the unkeyed ones.
+    @param key  The event channel or nickname.
+    @param args The event arguments.
+    @return The number of subscribers called.
+*/
+    template< typename... Args >
+    std::size_t publish( boost::string_view key, const Args &... args )
+    {
+        return dispatch( key, [&]( const handler_type &func ) { func( args... ); } );
+    }
+/**
+    Changes the case mapping of the keys, rebuilding the index.
+    Not to be called while dispatching.
+    @param mapping The new case mapping rules.
+*/
+    void mapping( casemapping mapping );
+/** @return The number of subscribers. */
+    std::size_t size() const { return m_size; }
+/** @return @true if there are no subscribers. */
+    bool empty() const { return m_size == 0; }
+
+private:
+    struct entry
+    {
+        handler_type func;
+        std::string  key;  // As given
+        bool         used;
+    };
+
+    typedef std::vector< id_type >                     id_list;
+    typedef std::unordered_map< std::string, id_list > index_map;
+
+    std::string fold( boost::string_view key ) const
+    {
+        std::string folded( key.data(), key.size() );
+        for( char &ch : folded )
+            ch = fold_case( ch, m_mapping );
+
+        return folded;
+    }
+
+    // Calls the used subscribers of a list, the ones added meanwhile wait
+    template< typename Call >
+    std::size_t call_list( const id_list &list, Call &call )
+    {
+        std::size_t called = 0;
+        for( std::size_t i = 0, count = list.size(); i < count; ++i )
+        {
+            const entry &e = m_entries[ list[i] ];
+            if( !e.used )
+                continue;
+
+            ++called;
+            call( e.func );
+        }
+        return called;
+    }
+
+    void remove( id_type id );
+
+    casemapping          m_mapping;
+    std::deque<entry>    m_entries; // Never move, a called subscriber stays put
+    std::vector<id_type> m_free,
+                         m_dead;    // Unsubscribed while dispatching
+    id_list              m_any;
+    index_map            m_index;
+    std::size_t          m_size,
+                         m_depth;
+};
+
+template< typename Signature >
+const typename event_bus<Signature>::id_type event_bus<Signature>::npos;
+
+template< typename Signature >
+typename event_bus<Signature>::id_type
+event_bus<Signature>::subscribe( handler_type func, boost::string_view key )
+{
+    if( !func )
+        return npos;
+
+    id_type id;
+    if( m_free.empty() )
+    {
+        id = static_cast<id_type>( m_entries.size() );
+        m_entries.push_back( entry() );
+    }
+    else
+    {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+
+    entry &e = m_entries[id];
+    e.func = std::move( func );
+    e.key.assign( key.data(), key.size() );
+    e.used = true;
+
+    if( key.empty() )
+        m_any.push_back( id );
+    else
+        m_index[ fold( key ) ].push_back( id );
+
+    ++m_size;
+    return id;
+}
+
+template< typename Signature >
+bool event_bus<Signature>::unsubscribe( id_type id )
+{
+    if( id >= m_entries.size() || !m_entries[id].used )
+        return false;
+
+    m_entries[id].used = false;
+    --m_size;
+
+    if( m_depth )
+        m_dead.push_back( id );
+    else
+        remove( id );
+
+    return true;
+}
+
+template< typename Signature >
+template< typename Call >
+std::size_t event_bus<Signature>::dispatch( boost::string_view key, Call call )
+{
+    if( !m_size )
+        return 0;
+
+    // Removals are deferred to the outermost dispatch, even if a subscriber throws
+    struct depth_guard
+    {
+        explicit depth_guard( event_bus &bus ) : bus(bus) { ++bus.m_depth; }
+        ~depth_guard()
+        {
+            if( --bus.m_depth )
+                return;
+
+            std::vector<id_type> dead;
+            dead.swap( bus.m_dead );
+            for( id_type id : dead )
+                bus.remove( id );
+        }
+
+        event_bus &bus;
+    } guard( *this );
+
+    // Lists are not erased while dispatching, their address stays valid
+    std::size_t called = 0;
+    if( !key.empty() && !m_index.empty() )
+    {
+        typename index_map::iterator it = m_index.find( fold( key ) );
+        if( it != m_index.end() )
+            called += call_list( it->second, call );
+    }
+    called += call_list( m_any, call );
+    return called;
+}
+
+template< typename Signature >
+void event_bus<Signature>::mapping( casemapping mapping )
+{
+    if( mapping == m_mapping )
+        return;
+
+    m_mapping = mapping;
+    index_map index;
+    for( typename index_map::value_type &list : m_index )
+        for( id_type id : list.second )
+            index[ fold( m_entries[id].key ) ].push_back( id );
+
+    m_index.swap( index );
+}
+
+template< typename Signature >
+void event_bus<Signature>::remove( id_type id )
+{
+    entry &e = m_entries[id];
+
+    typename index_map::iterator it = m_index.end();
+    id_list *list = &m_any;
+    if( !e.key.empty() )
+    {
+        it   = m_index.find( fold( e.key ) );
+        list = &it->second;
+    }
+
+    list->erase( std::find( list->begin(), list->end(), id ) );
+    if( list->empty() && it != m_index.end() )
+        m_index.erase( it );
+
+    e.func = handler_type();
+    e.key.clear();
+    m_free.push_back( id );
+}
+
+} // namespace irc
+
+#endif // IRC_EVENT_BUS_HPP
@@ -0,0 +1,54 @@
+/*
+    Name:        irc/flow.hpp
+    Purpose:     Read side flow control options and counters
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_FLOW_HPP
+#define IRC_FLOW_HPP
+
+#include <chrono>
+#include <cstdint>
+
+namespace irc {
+
+/**
+    Read side flow control limits, in credit units held by the application:
+    the client stops handling lines once high_water units are held and
+    resumes when they drop to low_water.
+*/
+struct flow_options
+{
+    flow_options()
+    :   high_water(0),
+        low_water(0),
+        max_buffer(65536)
+    {}
+
+    std::size_t high_water; /**< Units held which pause reading, 0 disables flow control. */
+    std::size_t low_water;  /**< Units held which resume reading. */
+    std::size_t max_buffer; /**< Bytes still read while paused, so that PINGs are
+                                 answered; beyond it the socket is not read. */
+};
+
+/** Flow control counters. */
+struct flow_stats
+{
+    typedef std::chrono::steady_clock clock;
+
+    flow_stats()
+    :   pauses(0),
+        pings(0),
+        paused(clock::duration::zero())
+    {}
+
+    std::uint64_t   pauses; /**< Times reading was paused. */
+    std::uint64_t   pings;  /**< PINGs answered while paused. */
+    clock::duration paused; /**< Time spent paused, the current pause included. */
+};
+
+} // namespace irc
+
+#endif // IRC_FLOW_HPP
@@ -0,0 +1,126 @@
+/*
+    Name:        irc/hostmask.hpp
+    Purpose:     Message prefix parsing and per connection prefix cache
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_HOSTMASK_HPP
+#define IRC_HOSTMASK_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/utility/string_view.hpp>
+
+namespace irc {
+
+/** A message prefix split in place, the views point into the parsed prefix. */
+struct hostmask_view
+{
+    boost::string_view nick; /**< The nickname, empty for a server. */
+    boost::string_view user; /**< The username, may be empty. */
+    boost::string_view host; /**< The hostname, or the server name. */
+/**
+    Checks if the prefix is a server name.
+    @return @true if the message comes from a server, @false otherwise.
+*/
+    bool is_server() const { return nick.empty() && !host.empty(); }
+};
+/**
+    Splits a message prefix: "nick!user@host", "nick@host", "nick" or
+    "server.name". A prefix without '!' and '@' is a server name if it
+    contains a dot, which nicknames can't.
+    @param prefix The prefix, without the leading ':'.
+    @return The prefix parts.
+*/
+inline hostmask_view parse_hostmask( boost::string_view prefix )
+{
+    hostmask_view mask;
+    std::size_t bang = prefix.find('!'),
+                at   = prefix.find('@', bang == boost::string_view::npos ? 0 : bang );
+
+    if( bang == boost::string_view::npos && at == boost::string_view::npos )
+    {
+        if( prefix.find('.') != boost::string_view::npos )
+            mask.host = prefix;
+        else
+            mask.nick = prefix;
+
+        return mask;
+    }
+
+    mask.nick = prefix.substr( 0, bang < at ? bang : at );
+    if( bang != boost::string_view::npos )
+        mask.user = prefix.substr( bang + 1, at == boost::string_view::npos
+                                             ? boost::string_view::npos : at - bang - 1 );
+    if( at != boost::string_view::npos )
+        mask.host = prefix.substr( at + 1 );
+
+    return mask;
+}
+
+/** A cached prefix, with its nickname interned as a string for the handlers. */
+struct hostmask_entry
+{
+    std::string   prefix;   /**< The raw prefix. */
+    std::string   nickname; /**< The nickname, empty for a server. */
+    hostmask_view view;     /**< The prefix parts, pointing into prefix. */
+};
+/**
+    @class hostmask_cache
+
+    A small direct mapped cache of parsed message prefixes, keyed on the
+    raw prefix. The frequent senders of busy channels hit it, so their
+    prefix is parsed and their nickname allocated once rather than for
+    every message. A miss replaces the entry in its slot.
+
+    The slots are allocated by the first user prefix: server prefixes are
+    parsed without being cached, so a connection which only talked with
+    its server holds no cache.
+
+    A returned entry stays valid until the next find().
+*/
+class hostmask_cache : private boost::noncopyable
+{
+public:
+/**
+    Constructor.
+    @param slots The number of cached prefixes, rounded up to a power of 2.
+*/
+    explicit hostmask_cache( std::size_t slots = 64 );
+/**
+    Returns the parsed form of a prefix, parsing and caching it on a miss.
+    @param prefix The prefix, without the leading ':'.
+    @return The cached entry, an empty one if prefix is empty.
+*/
+    const hostmask_entry &find( boost::string_view prefix );
+/** Drops all the cached prefixes. */
+    void clear();
+
+/** @return The lookups found in the cache. */
+    std::uint64_t hits()   const { return m_hits; }
+/** @return The lookups parsed and cached. */
+    std::uint64_t misses() const { return m_misses; }
+
+private:
+    // Entries never move, so their views into prefix stay valid
+    std::vector<hostmask_entry> m_entries;
+    hostmask_entry              m_none,
+                                m_server;  // The last server prefix
+    std::size_t                 m_slots,
+                                m_mask;
+    std::uint64_t               m_hits,
+                                m_misses;
+};
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/hostmask.ipp"
+#endif
+
+#endif // IRC_HOSTMASK_HPP
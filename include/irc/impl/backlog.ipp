@@ -0,0 +1,212 @@
+/*
+    Name:        irc/impl/backlog.ipp
+    Purpose:     Bounded per channel message backlog implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_BACKLOG_HPP
+#define IRC_IMPL_BACKLOG_HPP
+
+#include <algorithm>
+#include <cstring>
+
+namespace irc {
+
+backlog::backlog( const backlog_options &opts, casemapping mapping )
+:   m_options(opts),
+    m_mapping(mapping),
+    m_memory(0)
+{
+}
+
+void backlog::append( boost::string_view channel, boost::string_view sender,
+                      boost::string_view text, clock::time_point time )
+{
+    if( !m_options.max_lines || !m_options.max_bytes || channel.empty() )
+        return;
+
+    // Lengths are stored in 16 bits
+    std::size_t limit = std::min<std::size_t>( m_options.max_bytes, 0xffff );
+    sender = sender.substr( 0, limit );
+    text   = text.substr( 0, std::min<std::size_t>( limit, m_options.max_bytes - sender.size() ) );
+
+    std::string name = key( channel );
+    index_map::iterator found = m_channels.find( name );
+    bool                created = found == m_channels.end();
+    if( created )
+    {
+        ring r = { channel.to_string(), std::vector<char>(), std::vector<header>(), 0, 0, 0, 0 };
+        m_lru.push_front( std::move( r ) );
+        found = m_channels.insert( std::make_pair( std::move( name ), m_lru.begin() ) ).first;
+    }
+    else
+        m_lru.splice( m_lru.begin(), m_lru, found->second );
+
+    // The footprint is counted again below, a new ring was not counted yet
+    ring       &r      = *found->second;
+    std::size_t length = sender.size() + text.size();
+    if( !created )
+        m_memory -= footprint( r );
+    ++m_stats.appended;
+
+    if( r.count == m_options.max_lines )
+        pop( r );
+
+    // Slabs and headers grow geometrically up to the channel limits
+    if( r.count == r.headers.size() || r.bytes + length > r.slab.size() )
+    {
+        std::size_t slab    = r.slab.size(),
+                    headers = r.headers.size();
+
+        if( r.count == headers )
+            headers = std::min( m_options.max_lines, std::max<std::size_t>( headers * 2, 8 ) );
+
+        if( r.bytes + length > slab )
+            slab = std::min( m_options.max_bytes,
+                             std::max( std::max<std::size_t>( slab * 2, 256 ), r.bytes + length ) );
+
+        if( slab != r.slab.size() || headers != r.headers.size() )
+            reshape( r, slab, headers );
+    }
+
+    // A line never wraps, the oldest lines where it goes are dropped,
+    // with those left at the slab end when it restarts from the beginning
+    if( r.write + length > r.slab.size() )
+    {
+        while( r.count && r.headers[r.first].offset >= r.write )
+            pop( r );
+        r.write = 0;
+    }
+
+    while( r.count )
+    {
+        const header &oldest = r.headers[r.first];
+        if( oldest.offset >= r.write + length || oldest.offset + oldest.sender + oldest.text <= r.write )
+            break;
+
+        pop( r );
+    }
+
+    header &h = r.headers[ ( r.first + r.count ) % r.headers.size() ];
+    h.time    = time;
+    h.offset  = static_cast<std::uint32_t>( r.write );
+    h.sender  = static_cast<std::uint16_t>( sender.size() );
+    h.text    = static_cast<std::uint16_t>( text.size() );
+
+    std::memcpy( r.slab.data() + r.write, sender.data(), sender.size() );
+    std::memcpy( r.slab.data() + r.write + sender.size(), text.data(), text.size() );
+    r.write += length;
+    r.bytes += length;
+    ++r.count;
+
+    m_memory += footprint( r );
+
+    // Over budget, drop the coldest channels but this one
+    while( m_memory > m_options.budget && m_lru.size() > 1 )
+    {
+        drop( std::prev( m_lru.end() ) );
+        ++m_stats.evicted_channels;
+    }
+}
+
+std::size_t backlog::lines( boost::string_view channel ) const
+{
+    const ring *r = find( channel );
+    return r ? r->count : 0;
+}
+
+void backlog::erase( boost::string_view channel )
+{
+    index_map::iterator it = m_channels.find( key( channel ) );
+    if( it != m_channels.end() )
+        drop( it->second );
+}
+
+void backlog::clear()
+{
+    m_channels.clear();
+    m_lru.clear();
+    m_memory = 0;
+}
+
+void backlog::mapping( casemapping mapping )
+{
+    if( mapping == m_mapping )
+        return;
+
+    m_mapping = mapping;
+    m_channels.clear();
+    for( lru_list::iterator it = m_lru.begin(); it != m_lru.end(); ++it )
+        m_channels[ key( it->name ) ] = it;
+}
+
+std::string backlog::key( boost::string_view channel ) const
+{
+    std::string result( channel.size(), '\0' );
+    for( std::size_t i = 0; i < channel.size(); ++i )
+        result[i] = fold_case( channel[i], m_mapping );
+
+    return result;
+}
+
+const backlog::ring *backlog::find( boost::string_view channel ) const
+{
+    index_map::const_iterator it = m_channels.find( key( channel ) );
+    return it == m_channels.end() ? nullptr : &*it->second;
+}
+
+void backlog::pop( ring &r )
+{
+    const header &oldest = r.headers[r.first];
+    r.bytes -= oldest.sender + oldest.text;
+    r.first  = ( r.first + 1 ) % r.headers.size();
+    if( --r.count == 0 )
+    {
+        r.first = 0;
+        r.write = 0;
+    }
+    ++m_stats.evicted_lines;
+}
+
+void backlog::reshape( ring &r, std::size_t slab, std::size_t headers )
+{
+    std::vector<char>   new_slab( slab );
+    std::vector<header> new_headers( headers );
+
+    std::size_t offset = 0;
+    for( std::size_t i = 0; i < r.count; ++i )
+    {
+        header      h      = r.headers[ ( r.first + i ) % r.headers.size() ];
+        std::size_t length = h.sender + h.text;
+
+        std::memcpy( new_slab.data() + offset, r.slab.data() + h.offset, length );
+        h.offset       = static_cast<std::uint32_t>( offset );
+        new_headers[i] = h;
+        offset        += length;
+    }
+
+    r.slab.swap( new_slab );
+    r.headers.swap( new_headers );
+    r.first = 0;
+    r.write = offset;
+}
+
+void backlog::drop( lru_list::iterator it )
+{
+    m_memory -= footprint( *it );
+    m_channels.erase( key( it->name ) );
+    m_lru.erase( it );
+}
+
+std::size_t backlog::footprint( const ring &r )
+{
+    // The list and index nodes are estimated
+    return sizeof(ring) + 2 * r.name.capacity() + 64 +
+           r.slab.capacity() + r.headers.capacity() * sizeof(header);
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_BACKLOG_HPP
@@ -13,14 +13,40 @@ namespace irc {
 
 client::ptr client::create( io_service &io_service )
 {
-    client::ptr new_client( new client( io_service ) );
+    client::ptr new_client( new client( io_service, io_service ) );
+    return new_client;
+}
+
+client::ptr client::create( io_service &io_service, transport transport )
+{
+    client::ptr new_client( new client( io_service, std::move( transport ) ) );
     return new_client;
 }
 
 client::~client()
 {
+    // Nothing can be posted from here, so the transport is closed at once
     if( m_connected )
-        disconnect();
+    {
+        m_connected = false;
+        invoke( trace_handler::disconnected, m_handlers->on_disconnected );
+#ifdef IRC_CLIENT_HAS_IO_URING
+        detach_uring();
+#endif
+        m_transport.close();
+    }
+
+    end_list( boost::asio::error::operation_aborted );
+    fail_waiters( boost::asio::error::operation_aborted );
+    complete_marks( std::numeric_limits<std::uint64_t>::max(),
+                    boost::asio::error::operation_aborted );
+    if( m_dcc )
+        m_dcc->close();
+#ifdef IRC_CLIENT_HAS_IO_URING
+    if( m_uring_id != uring_service::npos )
+        m_uring->detach( m_uring_id );
+#endif
+    delete m_trace.load();
 }
 
 void client::connect( const std::string &hostname,
@@ -30,54 +56,129 @@ void client::connect( const std::string &hostname,
                       const std::string &realname,
                       const std::string &srv_pwrd )
 {
-    resolver           resolver( m_service );
-    resolver::query    query( hostname, port );
-    resolver::iterator endpoint_iter = resolver.resolve( query );
+    m_session.identity( nickname, username, realname, srv_pwrd );
+    m_session.connecting( session::clock::now() );
 
-    m_nickname = nickname;
-    m_username = username;
-    m_realname = realname;
+    m_transport.async_connect( hostname, port, std::bind( &client::handle_connect,
+                                                          shared_from_this(), ph::_1 ) );
+}
 
-    boost::asio::async_connect( m_socket, endpoint_iter,
-                                std::bind( &client::handle_connect,
-                                            shared_from_this(), ph::_1 ) );
+void client::on_ctcp( const std::string &command, ctcp_handler func, bool replies )
+{
+    std::string key = boost::to_upper_copy( command );
+    if( !func )
+    {
+        // Defaults are shared, an empty entry disables them for this client
+        if( find_ctcp_default( key ) )
+            m_ctcp[key] = ctcp_entry();
+        else
+            m_ctcp.erase( key );
+        return;
+    }
+
+    ctcp_entry entry = { func, replies };
+    m_ctcp[key] = entry;
 }
 
-void client::disconnect()
+trigger_set::id_type client::on_trigger( const std::string &literal, trigger_handler func,
+                                         const trigger_options &opts )
 {
-    if( !m_connected )
+    if( !m_triggers )
+        m_triggers.reset( new trigger_set() );
+
+    trigger_set::id_type id = func ? m_triggers->add( literal, opts ) : trigger_set::npos;
+    if( id == trigger_set::npos )
     {
         m_lasterror = error_code::invalid_request;
-        return;
+        return id;
     }
 
-    m_connected = false;
-    if( m_on_disconnected )
-        m_on_disconnected();
+    if( id >= m_trigger_handlers.size() )
+        m_trigger_handlers.resize( id + 1 );
 
-    m_service.post([this]() { m_socket.close(); });
+    m_trigger_handlers[id] = func;
+    m_lasterror = error_code::success;
+    return id;
 }
 
-void client::send_raw( const std::string &cmd_str )
+void client::remove_trigger( trigger_set::id_type id )
 {
-    if( !m_connected )
+    if( m_triggers && m_triggers->remove( id ) )
+        m_trigger_handlers[id] = nullptr;
+}
+
+dcc_sender::ptr client::dcc_send( const std::string &nickname, const std::string &path,
+                                 dcc_transfer::handler func, const dcc_options &opts )
+{
+    system_error_code ec;
+    boost::asio::ip::address address = m_dcc_address.empty()
+                                     ? m_transport.local_address( ec )
+                                     : boost::asio::ip::make_address( m_dcc_address, ec );
+    if( nickname.empty() || ec )
     {
         m_lasterror = error_code::invalid_request;
-
-        m_service.post( std::bind( &client::send_raw,
-                                    shared_from_this(), cmd_str ) );
+        return dcc_sender::ptr();
     }
-    else
+
+    dcc_sender::ptr sender = dcc().send( path, address, func, opts );
+    if( !sender )
+        return sender;
+
+    // DCC advertises IPv4 addresses as a 32 bit integer
+    std::string host = address.is_v4() ? std::to_string( address.to_v4().to_ulong() )
+                                       : address.to_string();
+    ctcp_request( nickname, boost::str( boost::format("DCC SEND %1% %2% %3% %4%")
+                                        % quote_filename( sender->filename() ) % host
+                                        % sender->port() % sender->progress().size ) );
+    return sender;
+}
+
+dcc_receiver::ptr client::dcc_receive( const std::string &nickname, const dcc_request &offer,
+                                      const std::string &path, dcc_transfer::handler func,
+                                      const dcc_options &opts )
+{
+    if( nickname.empty() )
     {
-        m_lasterror = error_code::success;
+        m_lasterror = error_code::invalid_request;
+        return dcc_receiver::ptr();
+    }
 
-        m_buf_write.consume( m_buf_write.size() );
-        std::ostream out( &m_buf_write );
-        out << cmd_str << "\r\n";
+    dcc_receiver::ptr receiver = dcc().receive( offer, path, func, opts );
+    if( receiver && receiver->resume_position() )
+    {
+        ctcp_request( nickname, boost::str( boost::format("DCC RESUME %1% %2% %3%")
+                                            % quote_filename( offer.filename )
+                                            % offer.port % receiver->resume_position() ) );
+    }
+    return receiver;
+}
 
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                    system_error_code(), 0 ) );
+void client::disconnect()
+{
+    if( !m_connected )
+    {
+        m_lasterror = error_code::invalid_request;
+        return;
     }
+
+    m_connected = false;
+    invoke( trace_handler::disconnected, m_handlers->on_disconnected );
+
+    ptr self = shared_from_this();
+    m_service.post([self]()
+    {
+        self->close_socket();
+        self->end_list( boost::asio::error::operation_aborted );
+        self->fail_waiters( boost::asio::error::operation_aborted );
+    });
+}
+
+void client::send_raw( const std::string &cmd_str )
+{
+    m_lasterror = error_code::success;
+
+    // Queued until the server talks to us, then sent in order
+    m_service.dispatch( std::bind( &client::queue_line, shared_from_this(), cmd_str, nullptr ) );
 }
 
 void client::action( const std::string &destination, const std::string &message )
@@ -85,8 +186,6 @@ void client::action( const std::string &destination, const std::string &message
     if( destination.empty() || message.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                    system_error_code(), 0 ) );
         return;
     }
 
@@ -98,8 +197,6 @@ void client::ctcp_request( const std::string &nickname, const std::string &reque
     if( nickname.empty() || request.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                    system_error_code(), 0 ) );
         return;
     }
     send_raw("PRIVMSG "+ nickname +" :\x01"+ request +"\x01");
@@ -110,8 +207,6 @@ void client::ctcp_reply( const std::string &nickname, const std::string &reply )
     if( nickname.empty() || reply.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                    system_error_code(), 0 ) );
         return;
     }
     send_raw("NOTICE "+ nickname +" :\x01"+ reply +"\x01");
@@ -122,8 +217,6 @@ void client::invite( const std::string &nickname, const std::string &channel )
     if( nickname.empty() || channel.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                    system_error_code(), 0 ) );
         return;
     }
 
@@ -135,21 +228,30 @@ void client::join( const std::string &channel )
     if( channel.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                       system_error_code(), 0 ) );
         return;
     }
     send_raw("JOIN "+ channel);
 }
 
+void client::join_all( const std::vector<std::string> &channels,
+                       const std::vector<std::string> &keys )
+{
+    if( channels.empty() )
+    {
+        m_lasterror = error_code::invalid_request;
+        return;
+    }
+
+    m_lasterror = error_code::success;
+    m_service.dispatch( std::bind( &client::queue_join, shared_from_this(), channels, keys ) );
+}
+
 void client::kick( const std::string &nickname, const std::string &channel,
                    const std::string &reason )
 {
     if( nickname.empty() || channel.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                       system_error_code(), 0 ) );
         return;
     }
 
@@ -164,29 +266,96 @@ void client::list( const std::string &channels )
     send_raw( channels.empty() ? "LIST" : "LIST "+ channels );
 }
 
+void client::list_stream( const list_filter &filter,
+                          std::function<bool(const list_entry_view &)> on_entry,
+                          std::function<void(const system_error_code &)> on_end )
+{
+    if( !on_entry )
+    {
+        m_lasterror = error_code::invalid_request;
+        return;
+    }
+
+    m_service.dispatch( std::bind( &client::start_list, shared_from_this(),
+                                   filter, on_entry, on_end ) );
+}
+
+void client::resume()
+{
+    m_service.dispatch( std::bind( &client::do_resume, shared_from_this() ) );
+}
+
+void client::flow_control( const flow_options &opts )
+{
+    m_flow = opts;
+    if( m_flow.low_water > m_flow.high_water )
+        m_flow.low_water = m_flow.high_water;
+
+    if( m_flow_paused )
+        m_service.post( std::bind( &client::flow_resume, shared_from_this() ) );
+}
+
+void client::release( std::size_t units )
+{
+    std::size_t held = m_held.load(), left;
+    do
+    {
+        left = held > units ? held - units : 0;
+    }
+    while( !m_held.compare_exchange_weak( held, left ) );
+
+    // The watermarks belong to the client's thread, flow_resume() checks them there
+    if( m_flow_paused.load() )
+        m_service.post( std::bind( &client::flow_resume, shared_from_this() ) );
+}
+
+flow_stats client::flow() const
+{
+    flow_stats stats = m_flow_stats;
+    if( m_flow_paused )
+        stats.paused += flow_stats::clock::now() - m_paused_since;
+
+    return stats;
+}
+
+client::message_bus::id_type client::subscribe( message_event event,
+                                                message_bus::handler_type func,
+                                                const std::string &key )
+{
+    std::size_t index = static_cast<std::size_t>( event );
+    if( index >= message_events || !func )
+    {
+        m_lasterror = error_code::invalid_request;
+        return message_bus::npos;
+    }
+
+    std::unique_ptr<message_bus> &bus = m_buses[index];
+    if( !bus )
+        bus.reset( new message_bus( m_isupport->casemap() ) );
+
+    return bus->subscribe( func, key );
+}
+
+bool client::unsubscribe( message_event event, message_bus::id_type id )
+{
+    std::size_t index = static_cast<std::size_t>( event );
+    return index < message_events && m_buses[index] && m_buses[index]->unsubscribe( id );
+}
+
 void client::names( const std::string &channel )
 {
     if( channel.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                       system_error_code(), 0 ) );
         return;
     }
 
     send_raw("NAMES "+ channel);
 }
 
-std::string client::nickname_from( const std::string &hostmask ) const
+std::string client::nickname_from( boost::string_view hostmask ) const
 {
-    if( hostmask.empty() )
-        return std::string();
-
-    std::size_t found = hostmask.find('!');
-    if( found != std::string::npos )
-        return hostmask.substr( 0, found );
-
-    return std::string();
+    return parse_hostmask( hostmask ).nick.to_string();
 }
 
 void client::notice( const std::string &destination, const std::string &message )
@@ -194,40 +363,88 @@ void client::notice( const std::string &destination, const std::string &message
     if( destination.empty() || message.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                       system_error_code(), 0 ) );
         return;
     }
 
     send_raw("NOTICE "+ destination +" :"+ message);
 }
 
+void client::notice_all( const std::vector<std::string> &destinations,
+                         const std::string &message )
+{
+    if( destinations.empty() || message.empty() )
+    {
+        m_lasterror = error_code::invalid_request;
+        return;
+    }
+
+    m_lasterror = error_code::success;
+    m_service.dispatch( std::bind( &client::queue_targets, shared_from_this(),
+                                   std::string("NOTICE"), destinations, message ) );
+}
+
 void client::part( const std::string &channel )
 {
     if( channel.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                       system_error_code(), 0 ) );
         return;
     }
 
     send_raw("PART "+ channel);
 }
 
+void client::part_all( const std::vector<std::string> &channels, const std::string &reason )
+{
+    if( channels.empty() )
+    {
+        m_lasterror = error_code::invalid_request;
+        return;
+    }
+
+    m_lasterror = error_code::success;
+    m_service.dispatch( std::bind( &client::queue_targets, shared_from_this(),
+                                   std::string("PART"), channels, reason ) );
+}
+
 void client::privmsg( const std::string &destination, const std::string &message )
 {
     if( destination.empty() || message.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                       system_error_code(), 0 ) );
         return;
     }
 
     send_raw("PRIVMSG "+ destination +" :"+ message);
 }
 
+void client::privmsg_all( const std::vector<std::string> &destinations,
+                          const std::string &message )
+{
+    if( destinations.empty() || message.empty() )
+    {
+        m_lasterror = error_code::invalid_request;
+        return;
+    }
+
+    m_lasterror = error_code::success;
+    m_service.dispatch( std::bind( &client::queue_targets, shared_from_this(),
+                                   std::string("PRIVMSG"), destinations, message ) );
+}
+
+void client::set_modes( const std::string &channel, const std::vector<mode_change> &changes )
+{
+    if( channel.empty() || changes.empty() )
+    {
+        m_lasterror = error_code::invalid_request;
+        return;
+    }
+
+    m_lasterror = error_code::success;
+    m_service.dispatch( std::bind( &client::queue_modes, shared_from_this(),
+                                   channel, changes ) );
+}
+
 void client::quit( const std::string &reason )
 {
     std::string cmd_str = reason.empty() ? "QUIT" : "QUIT :"+ reason;
@@ -239,8 +456,6 @@ void client::topic( const std::string &channel, const std::string &topic )
     if( channel.empty() )
     {
         m_lasterror = error_code::invalid_request;
-        m_service.post( std::bind( &client::loop, shared_from_this(),
-                                       system_error_code(), 0 ) );
         return;
     }
 
@@ -259,6 +474,24 @@ std::string client::version() const
     return "VERSION irc::client by Andrea Zanellato v0.1";
 }
 
+void client::tracing( bool enable, std::size_t capacity )
+{
+    trace_ring *ring = m_trace.load( std::memory_order_acquire );
+    if( !ring )
+    {
+        trace_ring *created  = new trace_ring( capacity ),
+                   *expected = nullptr;
+        if( m_trace.compare_exchange_strong( expected, created ) )
+            ring = created;
+        else
+        {
+            delete created;
+            ring = expected;
+        }
+    }
+    ring->enable( enable );
+}
+
 } // namespace irc
 
 #endif // IRC_IMPL_CLIENT_HPP
@@ -0,0 +1,769 @@
+/*
+    Name:        irc/impl/dcc.ipp
+    Purpose:     DCC file transfers implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_DCC_HPP
+#define IRC_IMPL_DCC_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+    #include <sys/sendfile.h>
+#endif
+
+#include <boost/algorithm/string/case_conv.hpp>
+
+namespace irc {
+namespace detail {
+
+inline boost::string_view dcc_token( boost::string_view &rest, bool quoted )
+{
+    while( !rest.empty() && rest[0] == ' ' )
+        rest.remove_prefix(1);
+
+    std::size_t end;
+    boost::string_view token;
+    if( quoted && !rest.empty() && rest[0] == '"' )
+    {
+        end   = rest.find( '"', 1 );
+        token = rest.substr( 1, end == boost::string_view::npos ? end : end - 1 );
+        if( end != boost::string_view::npos )
+            ++end;
+    }
+    else
+    {
+        end   = rest.find(' ');
+        token = rest.substr( 0, end );
+    }
+    rest = end == boost::string_view::npos ? boost::string_view() : rest.substr( end );
+    return token;
+}
+
+inline bool dcc_number( boost::string_view token, std::uint64_t &value )
+{
+    if( token.empty() || token.size() > 20 )
+        return false;
+
+    value = 0;
+    for( char ch : token )
+    {
+        if( ch < '0' || ch > '9' )
+            return false;
+        value = value * 10 + static_cast<std::uint64_t>( ch - '0' );
+    }
+    return true;
+}
+
+} // namespace detail
+
+bool parse_dcc( boost::string_view args, dcc_request &dcc )
+{
+    boost::string_view rest = args;
+
+    dcc.type = detail::dcc_token( rest, false ).to_string();
+    boost::to_upper( dcc.type );
+    dcc.filename = detail::dcc_token( rest, true ).to_string();
+    if( dcc.type.empty() || dcc.filename.empty() )
+        return false;
+
+    // RESUME and ACCEPT have no address
+    std::uint64_t value = 0;
+    if( dcc.type == "SEND" )
+    {
+        boost::string_view address = detail::dcc_token( rest, false );
+        if( detail::dcc_number( address, value ) )
+        {
+            if( value > 0xffffffffu )
+                return false;
+
+            dcc.address = boost::asio::ip::address_v4(
+                static_cast<std::uint32_t>( value ) ).to_string();
+        }
+        else
+            dcc.address = address.to_string();
+    }
+
+    if( !detail::dcc_number( detail::dcc_token( rest, false ), value ) || value > 65535 )
+        return false;
+
+    dcc.port = static_cast<std::uint16_t>( value );
+    dcc.position = 0;
+    boost::string_view position = detail::dcc_token( rest, false );
+    return position.empty() || detail::dcc_number( position, dcc.position );
+}
+
+dcc_transfer::dcc_transfer( std::shared_ptr< dcc_manager > manager, int fd,
+                            std::uint64_t size, const std::string &filename,
+                            const dcc_options &opts, handler func )
+:   m_manager(manager),
+    m_socket(manager->m_service),
+    m_timer(manager->m_service),
+    m_progress_timer(manager->m_service),
+    m_fd(fd),
+    m_filename(filename),
+    m_options(opts),
+    m_handler(func),
+    m_progress_interval(1000),
+    m_port(0),
+    m_size(size),
+    m_offset(0),
+    m_position(0),
+    m_acked(0),
+    m_started(false),
+    m_done(false)
+{
+    if( !m_options.chunk_size )
+        m_options.chunk_size = 256u << 10;
+}
+
+dcc_transfer::~dcc_transfer()
+{
+    if( m_fd >= 0 )
+        ::close( m_fd );
+}
+
+dcc_progress dcc_transfer::progress() const
+{
+    dcc_progress prog;
+    prog.size        = m_size;
+    prog.offset      = m_offset;
+    prog.transferred = m_position - m_offset;
+    prog.acked       = m_acked;
+
+    double elapsed = m_started ? std::chrono::duration<double>( clock::now() - m_start ).count()
+                               : 0;
+    prog.rate = elapsed > 0 ? static_cast<double>( prog.transferred ) / elapsed : 0;
+    return prog;
+}
+
+void dcc_transfer::on_progress( progress_handler func, std::chrono::milliseconds interval )
+{
+    m_on_progress       = func;
+    m_progress_interval = interval;
+
+    boost::system::error_code ignored;
+    m_progress_timer.cancel( ignored );
+    if( m_started && !m_done )
+        report( boost::system::error_code() );
+}
+
+void dcc_transfer::cancel()
+{
+    m_manager->m_service.dispatch( std::bind( &dcc_transfer::finish, shared_from_this(),
+                                              boost::system::error_code(
+                                                  boost::asio::error::operation_aborted ) ) );
+}
+
+void dcc_transfer::start_timeout()
+{
+    ptr self = shared_from_this();
+    m_timer.expires_after( m_options.connect_timeout );
+    m_timer.async_wait( [self]( const boost::system::error_code &ec )
+    {
+        if( !ec && !self->m_started )
+            self->finish( boost::asio::error::timed_out );
+    });
+}
+
+void dcc_transfer::connected()
+{
+    boost::system::error_code ignored;
+    m_timer.cancel( ignored );
+    m_socket.set_option( boost::asio::ip::tcp::no_delay( true ), ignored );
+    m_socket.non_blocking( true, ignored );
+
+    m_started = true;
+    m_start   = clock::now();
+
+    if( m_on_progress )
+        report( boost::system::error_code() );
+}
+
+void dcc_transfer::report( const boost::system::error_code &ec )
+{
+    if( ec || m_done || !m_on_progress )
+        return;
+
+    ptr self = shared_from_this();
+    m_progress_timer.expires_after( m_progress_interval );
+    m_progress_timer.async_wait( [self]( const boost::system::error_code &ec )
+    {
+        if( !ec && !self->m_done && self->m_on_progress )
+            self->m_on_progress( self->progress() );
+        self->report( ec );
+    });
+}
+
+void dcc_transfer::finish( const boost::system::error_code &ec )
+{
+    if( m_done )
+        return;
+
+    m_done = true;
+
+    // Keep alive until the handler returned, the manager drops its reference
+    ptr self = shared_from_this();
+
+    boost::system::error_code ignored;
+    m_timer.cancel( ignored );
+    m_progress_timer.cancel( ignored );
+    m_socket.close( ignored );
+    stopped( ec );
+
+    m_manager->remove( this, ec );
+
+    handler func;
+    func.swap( m_handler );
+    if( func )
+        func( ec, progress() );
+}
+
+dcc_sender::dcc_sender( std::shared_ptr< dcc_manager > manager, int fd, std::uint64_t size,
+                        const std::string &filename, const dcc_options &opts, handler func )
+:   dcc_transfer( manager, fd, size, filename, opts, func ),
+    m_acceptor(manager->m_service),
+    m_ack_size(0)
+{
+    m_bucket.limit( m_options.rate_limit );
+}
+
+boost::system::error_code dcc_sender::listen( const boost::asio::ip::address &address )
+{
+    boost::system::error_code ec;
+    unsigned first = m_options.port_min,
+             last  = m_options.port_max < m_options.port_min ? m_options.port_min
+                                                             : m_options.port_max;
+    for( unsigned port = first; port <= last; ++port )
+    {
+        boost::asio::ip::tcp::endpoint endpoint( address, static_cast<std::uint16_t>( port ) );
+
+        m_acceptor.close( ec );
+        m_acceptor.open( endpoint.protocol(), ec );
+        if( !ec )
+            m_acceptor.bind( endpoint, ec );
+        if( !ec )
+            m_acceptor.listen( 1, ec );
+        if( !ec )
+            break;
+    }
+    if( ec )
+        return ec;
+
+    m_port = m_acceptor.local_endpoint( ec ).port();
+    m_acceptor.async_accept( m_socket, std::bind( &dcc_sender::handle_accept,
+                                                  self(), std::placeholders::_1 ) );
+    start_timeout();
+    return ec;
+}
+
+bool dcc_sender::resume( std::uint64_t position )
+{
+    if( m_started || m_done || position >= m_size )
+        return false;
+
+    m_offset   = position;
+    m_position = position;
+    m_acked    = position;
+    return true;
+}
+
+void dcc_sender::stopped( const boost::system::error_code & )
+{
+    boost::system::error_code ignored;
+    m_acceptor.close( ignored );
+}
+
+void dcc_sender::handle_accept( const boost::system::error_code &ec )
+{
+    if( m_done )
+        return;
+
+    if( ec )
+    {
+        finish( ec );
+        return;
+    }
+
+    boost::system::error_code ignored;
+    m_acceptor.close( ignored );
+    connected();
+
+    read_ack();
+    wait_writable();
+}
+
+void dcc_sender::wait_writable()
+{
+    if( m_done || m_position == m_size )
+        return;
+
+    m_socket.async_wait( boost::asio::ip::tcp::socket::wait_write,
+                         std::bind( &dcc_sender::handle_writable,
+                                    self(), std::placeholders::_1 ) );
+}
+
+void dcc_sender::handle_writable( const boost::system::error_code &ec )
+{
+    if( m_done )
+        return;
+
+    if( ec )
+    {
+        finish( ec );
+        return;
+    }
+
+    // Both the transfer and the aggregate bucket must allow the chunk
+    clock::time_point now = clock::now();
+    std::size_t want = static_cast<std::size_t>(
+        std::min<std::uint64_t>( m_options.chunk_size, m_size - m_position ) );
+    std::size_t allowed = std::min( want, std::min( m_bucket.available( now ),
+                                                    m_manager->m_bucket.available( now ) ) );
+
+    // Tiny grants would cost a system call each, wait for a worthwhile one
+    if( allowed < std::min<std::size_t>( want, 4096 ) )
+    {
+        clock::duration delay = std::max( m_bucket.delay( want ),
+                                          m_manager->m_bucket.delay( want ) );
+        ptr me = self();
+        m_timer.expires_after( delay );
+        m_timer.async_wait( [me]( const boost::system::error_code &ec )
+        {
+            me->handle_writable( ec );
+        });
+        return;
+    }
+
+#if defined(__linux__)
+    off_t   offset = static_cast<off_t>( m_position );
+    ssize_t sent   = ::sendfile( m_socket.native_handle(), m_fd, &offset, allowed );
+#else
+    if( m_buffer.size() < allowed )
+        m_buffer.resize( allowed );
+
+    ssize_t sent = ::pread( m_fd, m_buffer.data(), allowed, static_cast<off_t>( m_position ) );
+    if( sent > 0 )
+        sent = ::send( m_socket.native_handle(), m_buffer.data(),
+                       static_cast<std::size_t>( sent ), 0 );
+#endif
+    if( sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+    {
+        finish( boost::system::error_code( errno, boost::asio::error::get_system_category() ) );
+        return;
+    }
+    if( sent == 0 )
+    {
+        // The file shrank under us
+        finish( boost::asio::error::eof );
+        return;
+    }
+    if( sent > 0 )
+    {
+        m_position += static_cast<std::uint64_t>( sent );
+        m_bucket.consume( static_cast<std::size_t>( sent ) );
+        m_manager->m_bucket.consume( static_cast<std::size_t>( sent ) );
+        m_manager->m_stats.bytes_sent += static_cast<std::uint64_t>( sent );
+    }
+    wait_writable();
+}
+
+void dcc_sender::read_ack()
+{
+    boost::asio::async_read( m_socket,
+                             boost::asio::buffer( m_ack + m_ack_size, sizeof(m_ack) - m_ack_size ),
+                             std::bind( &dcc_sender::handle_ack, self(),
+                                        std::placeholders::_1, std::placeholders::_2 ) );
+}
+
+void dcc_sender::handle_ack( const boost::system::error_code &ec, std::size_t bytes )
+{
+    if( m_done )
+        return;
+
+    // Receivers may close as soon as they have the whole file
+    if( ec )
+    {
+        finish( ec == boost::asio::error::eof && m_position == m_size
+                ? boost::system::error_code() : ec );
+        return;
+    }
+
+    m_ack_size += bytes;
+    if( m_ack_size == sizeof(m_ack) )
+    {
+        m_ack_size = 0;
+
+        // Network order, modulo 4 GiB: the nearest position not past the sent data
+        std::uint64_t ack = static_cast<std::uint64_t>( m_ack[0] ) << 24 | m_ack[1] << 16 |
+                            m_ack[2] << 8 | m_ack[3];
+        ack |= m_position & ~static_cast<std::uint64_t>( 0xffffffffu );
+        if( ack > m_position && ack >= 0x100000000ull )
+            ack -= 0x100000000ull;
+
+        if( ack > m_acked )
+            m_acked = ack;
+
+        if( m_acked == m_size )
+        {
+            finish( boost::system::error_code() );
+            return;
+        }
+    }
+    read_ack();
+}
+
+dcc_receiver::dcc_receiver( std::shared_ptr< dcc_manager > manager, int fd, std::uint64_t size,
+                            std::uint64_t offset, const dcc_request &offer,
+                            const dcc_options &opts, handler func )
+:   dcc_transfer( manager, fd, size, offer.filename, opts, func ),
+    m_unacked(0),
+    m_ack_writing(false),
+    m_ack_pending(false)
+{
+    m_port     = offer.port;
+    m_offset   = offset;
+    m_position = offset;
+    m_acked    = offset;
+
+    void *buffer = nullptr;
+    if( ::posix_memalign( &buffer, 4096, m_options.chunk_size ) == 0 )
+        m_buffer.reset( static_cast<char *>( buffer ) );
+}
+
+void dcc_receiver::start()
+{
+    m_socket.async_connect( m_endpoint, std::bind( &dcc_receiver::handle_connect,
+                                                   self(), std::placeholders::_1 ) );
+}
+
+void dcc_receiver::stopped( const boost::system::error_code &ec )
+{
+    // Without preallocation beyond the end of file, the size is the resume position
+    if( ec && m_fd >= 0 && ::ftruncate( m_fd, static_cast<off_t>( m_position ) ) != 0 )
+        return;
+}
+
+void dcc_receiver::handle_connect( const boost::system::error_code &ec )
+{
+    if( m_done )
+        return;
+
+    if( ec )
+    {
+        finish( ec );
+        return;
+    }
+
+    connected();
+    read_some();
+}
+
+void dcc_receiver::read_some()
+{
+    std::size_t want = static_cast<std::size_t>(
+        std::min<std::uint64_t>( m_options.chunk_size, m_size - m_position ) );
+
+    m_socket.async_read_some( boost::asio::buffer( m_buffer.get(), want ),
+                              std::bind( &dcc_receiver::handle_read, self(),
+                                         std::placeholders::_1, std::placeholders::_2 ) );
+}
+
+void dcc_receiver::handle_read( const boost::system::error_code &ec, std::size_t bytes )
+{
+    if( m_done )
+        return;
+
+    if( ec )
+    {
+        finish( ec );
+        return;
+    }
+
+    // Drain what is already buffered by the kernel, one pwrite per batch
+    std::size_t want = static_cast<std::size_t>(
+        std::min<std::uint64_t>( m_options.chunk_size, m_size - m_position ) );
+    while( bytes < want )
+    {
+        ssize_t more = ::recv( m_socket.native_handle(), m_buffer.get() + bytes,
+                               want - bytes, 0 );
+        if( more <= 0 )
+            break;
+        bytes += static_cast<std::size_t>( more );
+    }
+
+    for( std::size_t written = 0; written < bytes; )
+    {
+        ssize_t ret = ::pwrite( m_fd, m_buffer.get() + written, bytes - written,
+                                static_cast<off_t>( m_position + written ) );
+        if( ret < 0 && errno != EINTR )
+        {
+            finish( boost::system::error_code( errno, boost::asio::error::get_system_category() ) );
+            return;
+        }
+        if( ret > 0 )
+            written += static_cast<std::size_t>( ret );
+    }
+
+    m_position += bytes;
+    m_unacked  += bytes;
+    m_manager->m_stats.bytes_received += bytes;
+
+    if( m_position == m_size || m_unacked >= m_options.ack_interval )
+        send_ack();
+
+    if( m_position < m_size )
+        read_some();
+}
+
+void dcc_receiver::send_ack()
+{
+    if( m_ack_writing )
+    {
+        m_ack_pending = true;
+        return;
+    }
+
+    std::uint32_t ack = static_cast<std::uint32_t>( m_position & 0xffffffffu );
+    m_ack[0] = static_cast<unsigned char>( ack >> 24 );
+    m_ack[1] = static_cast<unsigned char>( ack >> 16 );
+    m_ack[2] = static_cast<unsigned char>( ack >> 8 );
+    m_ack[3] = static_cast<unsigned char>( ack );
+
+    m_acked       = m_position;
+    m_unacked     = 0;
+    m_ack_writing = true;
+    boost::asio::async_write( m_socket, boost::asio::buffer( m_ack ),
+                              std::bind( &dcc_receiver::handle_ack, self(),
+                                         std::placeholders::_1 ) );
+}
+
+void dcc_receiver::handle_ack( const boost::system::error_code &ec )
+{
+    m_ack_writing = false;
+    if( m_done )
+        return;
+
+    // The sender may close as soon as the data is sent
+    if( ec && m_position != m_size )
+    {
+        finish( ec );
+        return;
+    }
+
+    if( m_ack_pending && !ec )
+    {
+        m_ack_pending = false;
+        send_ack();
+    }
+    else if( m_position == m_size )
+        finish( boost::system::error_code() );
+}
+
+dcc_manager::ptr dcc_manager::create( boost::asio::io_service &io_service )
+{
+    dcc_manager::ptr new_manager( new dcc_manager( io_service ) );
+    return new_manager;
+}
+
+dcc_sender::ptr dcc_manager::send( const std::string &path,
+                                   const boost::asio::ip::address &address,
+                                   dcc_transfer::handler func,
+                                   const dcc_options &opts )
+{
+    boost::system::error_code ec;
+    struct stat st;
+
+    int fd = ::open( path.c_str(), O_RDONLY );
+    if( fd < 0 || ::fstat( fd, &st ) != 0 )
+    {
+        ec = boost::system::error_code( errno, boost::asio::error::get_system_category() );
+        if( fd >= 0 )
+            ::close( fd );
+    }
+    else if( !S_ISREG( st.st_mode ) || st.st_size == 0 )
+    {
+        ec = boost::asio::error::invalid_argument;
+        ::close( fd );
+    }
+    else
+    {
+        std::size_t slash = path.find_last_of('/');
+        std::string filename = slash == std::string::npos ? path : path.substr( slash + 1 );
+
+        dcc_sender::ptr sender( new dcc_sender( shared_from_this(), fd,
+                                                static_cast<std::uint64_t>( st.st_size ),
+                                                filename, opts, func ) );
+        ec = sender->listen( address );
+        if( !ec )
+        {
+            add( sender );
+            return sender;
+        }
+    }
+
+    if( func )
+        m_service.post( std::bind( func, ec, dcc_progress() ) );
+
+    return dcc_sender::ptr();
+}
+
+dcc_receiver::ptr dcc_manager::receive( const dcc_request &offer, const std::string &path,
+                                        dcc_transfer::handler func,
+                                        const dcc_options &opts )
+{
+    boost::system::error_code ec;
+    boost::asio::ip::address  address = boost::asio::ip::make_address( offer.address, ec );
+    struct stat st;
+    int fd = -1;
+
+    if( ec || offer.type != "SEND" || !offer.port || !offer.position )
+    {
+        ec = boost::asio::error::invalid_argument;
+    }
+    else if( ( fd = ::open( path.c_str(), O_WRONLY | O_CREAT, 0644 ) ) < 0 ||
+             ::fstat( fd, &st ) != 0 )
+    {
+        ec = boost::system::error_code( errno, boost::asio::error::get_system_category() );
+        if( fd >= 0 )
+            ::close( fd );
+    }
+    else
+    {
+        std::uint64_t existing = static_cast<std::uint64_t>( st.st_size ),
+                      offset   = opts.resume && existing < offer.position ? existing : 0;
+
+        // A complete copy has nothing left to receive, a larger one is another file
+        if( opts.resume && existing >= offer.position )
+        {
+            ::close( fd );
+            if( existing > offer.position )
+                ec = boost::asio::error::invalid_argument;
+
+            dcc_progress progress;
+            if( !ec )
+                progress.size = progress.offset = progress.acked = existing;
+
+            if( func )
+                m_service.post( std::bind( func, ec, progress ) );
+
+            return dcc_receiver::ptr();
+        }
+
+        if( !offset && existing && ::ftruncate( fd, 0 ) != 0 )
+            ec = boost::system::error_code( errno, boost::asio::error::get_system_category() );
+
+        // Reserve the blocks, the file size still tells how much was received
+#if defined(__linux__)
+        if( !ec && ::fallocate( fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>( offset ),
+                                static_cast<off_t>( offer.position - offset ) ) != 0 &&
+            errno != EOPNOTSUPP )
+            ec = boost::system::error_code( errno, boost::asio::error::get_system_category() );
+#endif
+        dcc_receiver::ptr receiver;
+        if( !ec )
+        {
+            receiver.reset( new dcc_receiver( shared_from_this(), fd, offer.position,
+                                              offset, offer, opts, func ) );
+            receiver->m_endpoint = boost::asio::ip::tcp::endpoint( address, offer.port );
+            if( !receiver->m_buffer )
+                ec = boost::asio::error::no_memory;
+        }
+        else
+            ::close( fd );
+
+        if( !ec )
+        {
+            add( receiver );
+            receiver->start_timeout();
+            if( !offset )
+                receiver->start();
+
+            return receiver;
+        }
+    }
+
+    if( func )
+        m_service.post( std::bind( func, ec, dcc_progress() ) );
+
+    return dcc_receiver::ptr();
+}
+
+dcc_sender::ptr dcc_manager::resume( std::uint16_t port, std::uint64_t position )
+{
+    for( const dcc_transfer::ptr &transfer : m_transfers )
+    {
+        dcc_sender::ptr sender = std::dynamic_pointer_cast< dcc_sender >( transfer );
+        if( sender && sender->port() == port )
+            return sender->resume( position ) ? sender : dcc_sender::ptr();
+    }
+    return dcc_sender::ptr();
+}
+
+dcc_receiver::ptr dcc_manager::accept( std::uint16_t port, std::uint64_t position )
+{
+    for( const dcc_transfer::ptr &transfer : m_transfers )
+    {
+        dcc_receiver::ptr receiver = std::dynamic_pointer_cast< dcc_receiver >( transfer );
+        if( receiver && receiver->port() == port && !receiver->m_started &&
+            receiver->m_offset && receiver->m_offset == position )
+        {
+            receiver->start();
+            return receiver;
+        }
+    }
+    return dcc_receiver::ptr();
+}
+
+double dcc_manager::rate() const
+{
+    double total = 0;
+    for( const dcc_transfer::ptr &transfer : m_transfers )
+        total += transfer->progress().rate;
+
+    return total;
+}
+
+void dcc_manager::close()
+{
+    // finish() removes the transfers from the list
+    std::vector< dcc_transfer::ptr > transfers( m_transfers );
+    for( const dcc_transfer::ptr &transfer : transfers )
+        transfer->finish( boost::asio::error::operation_aborted );
+}
+
+void dcc_manager::add( dcc_transfer::ptr transfer )
+{
+    m_transfers.push_back( transfer );
+    ++m_stats.active;
+}
+
+void dcc_manager::remove( dcc_transfer *transfer, const boost::system::error_code &ec )
+{
+    for( std::size_t i = 0; i < m_transfers.size(); ++i )
+    {
+        if( m_transfers[i].get() != transfer )
+            continue;
+
+        m_transfers[i] = m_transfers.back();
+        m_transfers.pop_back();
+        --m_stats.active;
+        if( ec )
+            ++m_stats.failed;
+        else
+            ++m_stats.completed;
+        break;
+    }
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_DCC_HPP
@@ -0,0 +1,71 @@
+/*
+    Name:        irc/impl/hostmask.ipp
+    Purpose:     Message prefix parsing and per connection prefix cache implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_HOSTMASK_HPP
+#define IRC_IMPL_HOSTMASK_HPP
+
+#include <boost/functional/hash.hpp>
+
+namespace irc {
+
+hostmask_cache::hostmask_cache( std::size_t slots )
+:   m_mask(1),
+    m_hits(0),
+    m_misses(0)
+{
+    while( m_mask < slots )
+        m_mask <<= 1;
+
+    m_slots = m_mask;
+    --m_mask;
+}
+
+const hostmask_entry &hostmask_cache::find( boost::string_view prefix )
+{
+    if( prefix.empty() )
+        return m_none;
+
+    if( prefix.find('!') == boost::string_view::npos )
+    {
+        if( m_server.prefix != prefix )
+        {
+            m_server.prefix.assign( prefix.data(), prefix.size() );
+            m_server.view = parse_hostmask( m_server.prefix );
+            m_server.nickname.assign( m_server.view.nick.data(), m_server.view.nick.size() );
+        }
+        return m_server;
+    }
+
+    if( m_entries.empty() )
+        m_entries.resize( m_slots );
+
+    hostmask_entry &entry = m_entries[ boost::hash_range( prefix.begin(), prefix.end() ) & m_mask ];
+    if( entry.prefix == prefix )
+    {
+        ++m_hits;
+        return entry;
+    }
+
+    ++m_misses;
+    entry.prefix.assign( prefix.data(), prefix.size() );
+
+    // Parse the stored copy, so the views point into the entry
+    entry.view = parse_hostmask( entry.prefix );
+    entry.nickname.assign( entry.view.nick.data(), entry.view.nick.size() );
+    return entry;
+}
+
+void hostmask_cache::clear()
+{
+    std::vector<hostmask_entry>().swap( m_entries );
+    m_server = hostmask_entry();
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_HOSTMASK_HPP
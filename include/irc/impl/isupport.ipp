@@ -0,0 +1,349 @@
+/*
+    Name:        irc/impl/isupport.ipp
+    Purpose:     Server features advertised by RPL_ISUPPORT (005) implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_ISUPPORT_HPP
+#define IRC_IMPL_ISUPPORT_HPP
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace irc {
+namespace detail {
+
+struct isupport_default
+{
+    const char *name,
+               *value;
+};
+
+// Tokens not listed default to an empty value
+static const isupport_default isupport_defaults[] =
+{
+    { "CHANTYPES",   "#&" },
+    { "PREFIX",      "(ov)@+" },
+    { "CHANMODES",   "b,k,l,imnpst" },
+    { "CASEMAPPING", "rfc1459" },
+    { "MODES",       "3" },
+    { "NICKLEN",     "9" },
+    { "CHANNELLEN",  "50" },
+    { "LINELEN",     "512" }
+};
+
+inline unsigned isupport_number( const std::string &value )
+{
+    return static_cast<unsigned>( std::strtoul( value.c_str(), nullptr, 10 ) );
+}
+
+// Values escape spaces, '=' and '\' as \xHH
+inline std::string isupport_unescape( boost::string_view value )
+{
+    std::string result;
+    result.reserve( value.size() );
+    for( std::size_t i = 0; i < value.size(); ++i )
+    {
+        if( value[i] == '\\' && i + 3 < value.size() && value[i + 1] == 'x' )
+        {
+            char hex[3] = { value[i + 2], value[i + 3], 0 };
+            char *end   = nullptr;
+            long  ch    = std::strtol( hex, &end, 16 );
+            if( end == hex + 2 )
+            {
+                result += static_cast<char>( ch );
+                i += 3;
+                continue;
+            }
+        }
+        result += value[i];
+    }
+    return result;
+}
+
+// "<keys>:<number>[,<keys>:<number>]", the number of each key
+template< typename Func >
+void isupport_pairs( const std::string &value, Func func )
+{
+    std::size_t start = 0;
+    while( start < value.size() )
+    {
+        std::size_t end   = value.find( ',', start ),
+                    colon = value.find( ':', start );
+        if( end == std::string::npos )
+            end = value.size();
+
+        if( colon < end )
+            func( value.substr( start, colon - start ),
+                  isupport_number( value.substr( colon + 1, end - colon - 1 ) ) );
+
+        start = end + 1;
+    }
+}
+
+} // namespace detail
+
+isupport::ptr isupport::defaults()
+{
+    static const ptr table = std::make_shared<const isupport>();
+    return table;
+}
+
+isupport::ptr isupport::shared( const std::string &key, const isupport &table )
+{
+    typedef std::unordered_map< std::string, std::weak_ptr<const isupport> > snapshot_map;
+
+    static std::mutex   mutex;
+    static snapshot_map snapshots;
+
+    std::lock_guard<std::mutex> lock( mutex );
+
+    std::weak_ptr<const isupport> &slot = snapshots[key];
+    ptr snapshot = slot.lock();
+    if( !snapshot )
+    {
+        snapshot = std::make_shared<const isupport>( table );
+        slot     = snapshot;
+    }
+
+    // Forget the expired snapshots once the map doubled
+    static std::size_t prune_at = 64;
+    if( snapshots.size() >= prune_at )
+    {
+        for( snapshot_map::iterator it = snapshots.begin(); it != snapshots.end(); )
+        {
+            if( it->second.expired() )
+                it = snapshots.erase( it );
+            else
+                ++it;
+        }
+        prune_at = std::max<std::size_t>( 64, snapshots.size() * 2 );
+    }
+    return snapshot;
+}
+
+isupport::isupport()
+:   m_casemapping(casemapping::rfc1459),
+    m_modes(0),
+    m_nicklen(0),
+    m_channellen(0),
+    m_topiclen(0),
+    m_kicklen(0),
+    m_awaylen(0),
+    m_linelen(0),
+    m_maxtargets(0),
+    m_has_targmax(false),
+    m_excepts(0),
+    m_invex(0)
+{
+    std::memset( m_chantype,  0, sizeof(m_chantype) );
+    std::memset( m_statusmsg, 0, sizeof(m_statusmsg) );
+    std::memset( m_maxlist,   0, sizeof(m_maxlist) );
+    std::memset( m_chanlimit, 0, sizeof(m_chanlimit) );
+
+    for( const detail::isupport_default &token : detail::isupport_defaults )
+        apply( token.name, token.value );
+}
+
+void isupport::parse( boost::string_view tokens )
+{
+    while( !tokens.empty() )
+    {
+        std::size_t space = tokens.find(' ');
+        boost::string_view token = tokens.substr( 0, space );
+        tokens = space == boost::string_view::npos ? boost::string_view()
+                                                   : tokens.substr( space + 1 );
+        if( token.empty() )
+            continue;
+        if( token[0] == ':' )
+            break;
+
+        if( token[0] == '-' )
+        {
+            std::string name = token.substr(1).to_string();
+            m_tokens.erase( name );
+            reset( name );
+            continue;
+        }
+
+        std::size_t equal = token.find('=');
+        std::string name  = token.substr( 0, equal ).to_string(),
+                    value = equal == boost::string_view::npos
+                          ? std::string()
+                          : detail::isupport_unescape( token.substr( equal + 1 ) );
+        m_tokens[name] = value;
+        apply( name, value );
+    }
+}
+
+unsigned isupport::targmax( const std::string &command ) const
+{
+    if( m_has_targmax )
+    {
+        std::unordered_map<std::string, unsigned>::const_iterator it = m_targmax.find( command );
+        if( it != m_targmax.end() )
+            return it->second;
+    }
+
+    // Multiple channels are in RFC 1459 for JOIN and PART, servers omit them
+    if( command == "JOIN" || command == "PART" )
+        return 0;
+
+    if( command == "PRIVMSG" || command == "NOTICE" )
+        return m_maxtargets ? m_maxtargets : 1;
+
+    return 1;
+}
+
+void isupport::reset( const std::string &name )
+{
+    for( const detail::isupport_default &token : detail::isupport_defaults )
+    {
+        if( name == token.name )
+        {
+            apply( name, token.value );
+            return;
+        }
+    }
+    apply( name, std::string() );
+}
+
+void isupport::apply( const std::string &name, const std::string &value )
+{
+    if( name == "CHANTYPES" )
+    {
+        m_chantypes = value;
+        std::memset( m_chantype, 0, sizeof(m_chantype) );
+        for( char ch : value )
+            m_chantype[ static_cast<unsigned char>( ch ) ] = true;
+    }
+    else if( name == "PREFIX" )
+    {
+        // (ov)@+
+        std::size_t close = value.find(')');
+        if( !value.empty() && value[0] == '(' && close != std::string::npos &&
+            value.size() - close - 1 == close - 1 )
+        {
+            m_prefix_modes   = value.substr( 1, close - 1 );
+            m_prefix_symbols = value.substr( close + 1 );
+        }
+        else
+        {
+            m_prefix_modes.clear();
+            m_prefix_symbols.clear();
+        }
+        build_modes();
+    }
+    else if( name == "CHANMODES" )
+    {
+        m_chanmodes = value;
+        build_modes();
+    }
+    else if( name == "STATUSMSG" )
+    {
+        m_statusmsg_str = value;
+        std::memset( m_statusmsg, 0, sizeof(m_statusmsg) );
+        for( char ch : value )
+            m_statusmsg[ static_cast<unsigned char>( ch ) ] = true;
+    }
+    else if( name == "CASEMAPPING" )
+    {
+        m_casemapping = value == "ascii"          ? casemapping::ascii
+                      : value == "strict-rfc1459" ? casemapping::strict_rfc1459
+                      : value == "rfc1459"        ? casemapping::rfc1459
+                                                  : casemapping::ascii;
+    }
+    else if( name == "TARGMAX" )
+    {
+        m_has_targmax = !value.empty();
+        m_targmax.clear();
+        detail::isupport_pairs( value, [this]( const std::string &command, unsigned count )
+        {
+            m_targmax[command] = count;
+        });
+    }
+    else if( name == "MAXLIST" )
+    {
+        std::memset( m_maxlist, 0, sizeof(m_maxlist) );
+        detail::isupport_pairs( value, [this]( const std::string &modes, unsigned count )
+        {
+            for( char mode : modes )
+                m_maxlist[ static_cast<unsigned char>( mode ) ] = count;
+        });
+    }
+    else if( name == "MAXBANS" ) // Obsoleted by MAXLIST
+    {
+        if( !has("MAXLIST") )
+            m_maxlist[ static_cast<unsigned char>('b') ] = detail::isupport_number( value );
+    }
+    else if( name == "CHANLIMIT" )
+    {
+        std::memset( m_chanlimit, 0, sizeof(m_chanlimit) );
+        detail::isupport_pairs( value, [this]( const std::string &types, unsigned count )
+        {
+            for( char type : types )
+                m_chanlimit[ static_cast<unsigned char>( type ) ] = count;
+        });
+    }
+    else if( name == "EXCEPTS" )
+        m_excepts = value.empty() ? ( has( name ) ? 'e' : 0 ) : value[0];
+    else if( name == "INVEX" )
+        m_invex = value.empty() ? ( has( name ) ? 'I' : 0 ) : value[0];
+    else if( name == "ELIST" )
+        m_elist = value;
+    else if( name == "NETWORK" )
+        m_network = value;
+    else if( name == "MODES" )
+        m_modes = detail::isupport_number( value );
+    else if( name == "NICKLEN" || name == "MAXNICKLEN" )
+        m_nicklen = detail::isupport_number( value );
+    else if( name == "CHANNELLEN" )
+        m_channellen = detail::isupport_number( value );
+    else if( name == "TOPICLEN" )
+        m_topiclen = detail::isupport_number( value );
+    else if( name == "KICKLEN" )
+        m_kicklen = detail::isupport_number( value );
+    else if( name == "AWAYLEN" )
+        m_awaylen = detail::isupport_number( value );
+    else if( name == "LINELEN" )
+        m_linelen = detail::isupport_number( value );
+    else if( name == "MAXTARGETS" )
+        m_maxtargets = detail::isupport_number( value );
+}
+
+void isupport::build_modes()
+{
+    std::memset( m_modetype, 0, sizeof(m_modetype) );
+    std::memset( m_symbol,   0, sizeof(m_symbol) );
+    std::memset( m_prefix,   0, sizeof(m_prefix) );
+
+    // A,B,C,D groups, further groups are unknown kinds
+    unsigned char type = static_cast<unsigned char>( chanmode_type::list );
+    for( char ch : m_chanmodes )
+    {
+        if( ch == ',' )
+        {
+            if( type && ++type > static_cast<unsigned char>( chanmode_type::flag ) )
+                type = 0;
+            continue;
+        }
+        if( type )
+            m_modetype[ static_cast<unsigned char>( ch ) ] = type;
+    }
+
+    for( std::size_t i = 0; i < m_prefix_modes.size(); ++i )
+    {
+        unsigned char mode   = static_cast<unsigned char>( m_prefix_modes[i] ),
+                      symbol = static_cast<unsigned char>( m_prefix_symbols[i] );
+
+        m_modetype[mode] = static_cast<unsigned char>( chanmode_type::prefix );
+        m_symbol[mode]   = static_cast<char>( symbol );
+        m_prefix[symbol] = static_cast<char>( mode );
+    }
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_ISUPPORT_HPP
@@ -0,0 +1,310 @@
+/*
+    Name:        irc/impl/logger.ipp
+    Purpose:     Asynchronous batched chat logger implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_LOGGER_HPP
+#define IRC_IMPL_LOGGER_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+#include <boost/system/system_error.hpp>
+
+namespace irc {
+
+logger::ptr logger::create( const std::string &path, const options &opts )
+{
+    logger::ptr new_logger( new logger( path, opts ) );
+    return new_logger;
+}
+
+logger::logger( const std::string &path, const options &opts )
+:   m_options(opts),
+    m_path(path),
+    m_queue( std::min<std::size_t>( std::max<std::size_t>( opts.queue_size, 1 ), 65534 ) ),
+    m_sleeping(false),
+    m_running(true),
+    m_producers(0),
+    m_error(0),
+    m_dropped(0),
+    m_written(0),
+    m_rotations(0),
+    m_file_size(0),
+    m_stamp_sec(-1)
+{
+    if( m_options.batch_size == 0 )
+        m_options.batch_size = 1;
+
+    m_batch.reserve( m_options.batch_size * 128 );
+    open();
+    if( !m_file.is_open() )
+        throw boost::system::system_error( error(), "irc::logger " + path );
+
+    m_writer = std::thread( &logger::run, this );
+}
+
+logger::~logger()
+{
+    stop();
+}
+
+bool logger::log( const std::string &sender,
+                  const std::string &target,
+                  const std::string &text )
+{
+    // Counted before looking at m_running, so stop() waits for the push
+    m_producers.fetch_add( 1 );
+    if( !m_running.load() )
+    {
+        leave();
+        return false;
+    }
+
+    record rec;
+    rec.stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch() ).count();
+
+    std::size_t room = record_size;
+    rec.sender_len = static_cast<std::uint16_t>( std::min( sender.size(), room ) );
+    room -= rec.sender_len;
+    rec.target_len = static_cast<std::uint16_t>( std::min( target.size(), room ) );
+    room -= rec.target_len;
+    rec.text_len   = static_cast<std::uint16_t>( std::min( text.size(), room ) );
+
+    char *out = rec.data;
+    std::memcpy( out, sender.data(), rec.sender_len ); out += rec.sender_len;
+    std::memcpy( out, target.data(), rec.target_len ); out += rec.target_len;
+    std::memcpy( out, text.data(),   rec.text_len );
+
+    bool queued = push( rec );
+    if( !queued )
+        m_dropped.fetch_add( 1, std::memory_order_relaxed );
+
+    leave();
+    return queued;
+}
+
+bool logger::push( const record &rec )
+{
+    if( !m_queue.bounded_push( rec ) )
+    {
+        if( m_options.overflow == overflow_policy::drop )
+            return false;
+
+        // Block: the writer notifies m_space under the mutex after each batch
+        bool pushed = false;
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_sleeping.store( false );
+        m_wakeup.notify_one();
+        m_space.wait( lock, [&]
+        {
+            pushed = m_queue.bounded_push( rec );
+            return pushed || !m_running.load();
+        });
+        return pushed;
+    }
+
+    // Only pay for a notification when the writer is actually waiting
+    if( m_sleeping.load( std::memory_order_relaxed ) && m_sleeping.exchange( false ) )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_wakeup.notify_one();
+    }
+    return true;
+}
+
+void logger::leave()
+{
+    if( m_producers.fetch_sub( 1 ) == 1 && !m_running.load() )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_space.notify_all();
+    }
+}
+
+void logger::stop()
+{
+    if( !m_running.exchange( false ) )
+        return;
+
+    {
+        // Blocked producers give up, the others finish their push
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_wakeup.notify_one();
+        m_space.notify_all();
+        m_space.wait( lock, [this] { return m_producers.load() == 0; } );
+    }
+    if( m_writer.joinable() )
+        m_writer.join();
+
+    // The writer is gone: what it could not see is written from here
+    while( drain() )
+        ;
+    m_file.flush();
+}
+
+boost::system::error_code logger::error() const
+{
+    return boost::system::error_code( m_error.load( std::memory_order_relaxed ),
+                                      boost::system::generic_category() );
+}
+
+void logger::run()
+{
+    for( ;; )
+    {
+        if( drain() )
+        {
+            // Under the mutex, so a producer about to wait can not miss it
+            if( m_options.overflow == overflow_policy::block )
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                m_space.notify_all();
+            }
+            continue;
+        }
+
+        if( !m_running.load() )
+        {
+            // Producers may still have raced a record in before stop()
+            if( m_queue.empty() )
+                break;
+            continue;
+        }
+
+        if( m_options.rotate_interval.count() &&
+            std::chrono::steady_clock::now() - m_opened >= m_options.rotate_interval )
+            rotate();
+
+        std::unique_lock<std::mutex> lock( m_mutex );
+        m_sleeping.store( true );
+        if( m_queue.empty() && m_running.load() )
+            m_wakeup.wait_for( lock, m_options.flush_interval );
+        m_sleeping.store( false );
+    }
+}
+
+// Writes one batch, returns its records count
+std::size_t logger::drain()
+{
+    record      rec;
+    std::size_t count = 0;
+    while( count < m_options.batch_size && m_queue.pop( rec ) )
+    {
+        format( rec );
+        ++count;
+    }
+    if( !count )
+        return 0;
+
+    if( flush_batch() )
+        m_written.fetch_add( count, std::memory_order_relaxed );
+    else
+        m_dropped.fetch_add( count, std::memory_order_relaxed );
+    return count;
+}
+
+void logger::format( const record &rec )
+{
+    std::int64_t sec = rec.stamp / 1000;
+    if( sec != m_stamp_sec )
+    {
+        // The writer thread is the only caller, so localtime's buffer is ours
+        std::time_t t = static_cast<std::time_t>( sec );
+        std::strftime( m_stamp_str, sizeof(m_stamp_str),
+                       "[%Y-%m-%d %H:%M:%S] ", std::localtime( &t ) );
+        m_stamp_sec = sec;
+    }
+
+    const char *data = rec.data;
+    m_batch.append( m_stamp_str );
+    m_batch.append( data + rec.sender_len, rec.target_len );
+    m_batch.append( " <", 2 );
+    m_batch.append( data, rec.sender_len );
+    m_batch.append( "> ", 2 );
+    m_batch.append( data + rec.sender_len + rec.target_len, rec.text_len );
+    m_batch.push_back( '\n' );
+}
+
+bool logger::flush_batch()
+{
+    if( !m_file.is_open() )
+        open(); // A failed rotation is retried with each batch
+    else if( m_options.max_file_size &&
+             m_file_size && m_file_size + m_batch.size() > m_options.max_file_size )
+        rotate();
+    else if( m_options.rotate_interval.count() &&
+             std::chrono::steady_clock::now() - m_opened >= m_options.rotate_interval )
+        rotate();
+
+    bool done = false;
+    if( m_file.is_open() )
+    {
+        m_file.write( m_batch.data(), static_cast<std::streamsize>( m_batch.size() ) );
+        m_file.flush();
+        done = m_file.good();
+        if( done )
+            m_file_size += m_batch.size();
+        else
+        {
+            m_error.store( errno ? errno : EIO, std::memory_order_relaxed );
+            m_file.clear();
+        }
+    }
+    m_batch.clear();
+    return done;
+}
+
+void logger::open()
+{
+    errno = 0;
+    m_file.open( m_path, std::ios::out | std::ios::app | std::ios::binary );
+    if( !m_file.is_open() )
+    {
+        m_error.store( errno ? errno : EIO, std::memory_order_relaxed );
+        m_file.clear();
+        return;
+    }
+    m_file.seekp( 0, std::ios::end );
+    std::streamoff size = m_file.tellp();
+    m_file_size = size > 0 ? static_cast<std::uint64_t>( size ) : 0;
+    m_opened    = std::chrono::steady_clock::now();
+}
+
+void logger::rotate()
+{
+    m_file.close();
+
+    if( m_options.max_files )
+    {
+        std::string oldest = m_path + "." + std::to_string( m_options.max_files );
+        std::remove( oldest.c_str() );
+
+        for( unsigned i = m_options.max_files; i > 1; --i )
+        {
+            std::string from = m_path + "." + std::to_string( i - 1 ),
+                        to   = m_path + "." + std::to_string( i );
+            std::rename( from.c_str(), to.c_str() );
+        }
+        std::string first = m_path + ".1";
+        std::rename( m_path.c_str(), first.c_str() );
+    }
+    else
+    {
+        std::remove( m_path.c_str() );
+    }
+
+    open();
+    m_rotations.fetch_add( 1, std::memory_order_relaxed );
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_LOGGER_HPP
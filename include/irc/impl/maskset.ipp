@@ -0,0 +1,251 @@
+/*
+    Name:        irc/impl/maskset.ipp
+    Purpose:     Compiled set of wildcard hostmasks implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_MASKSET_HPP
+#define IRC_IMPL_MASKSET_HPP
+
+#include <algorithm>
+
+namespace irc {
+
+bool match_mask( boost::string_view mask, boost::string_view name, casemapping mapping )
+{
+    std::string folded_mask, folded_name;
+    folded_mask.reserve( mask.size() );
+    folded_name.reserve( name.size() );
+
+    for( char ch : mask )
+        folded_mask += fold_case( ch, mapping );
+    for( char ch : name )
+        folded_name += fold_case( ch, mapping );
+
+    return detail::glob_match( folded_mask, folded_name );
+}
+
+std::string normalize_mask( boost::string_view mask )
+{
+    std::size_t bang = mask.find('!'),
+                at   = mask.rfind('@');
+
+    if( bang == boost::string_view::npos && at == boost::string_view::npos )
+    {
+        // A host name, or a nickname
+        if( mask.find_first_of(".:") != boost::string_view::npos )
+            return "*!*@" + mask.to_string();
+
+        return ( mask.empty() ? std::string("*") : mask.to_string() ) + "!*@*";
+    }
+
+    std::string nick, user, host;
+    if( bang != boost::string_view::npos && ( at == boost::string_view::npos || bang < at ) )
+    {
+        nick = mask.substr( 0, bang ).to_string();
+        user = mask.substr( bang + 1, at == boost::string_view::npos
+                                      ? boost::string_view::npos : at - bang - 1 ).to_string();
+    }
+    else
+        user = mask.substr( 0, at ).to_string();
+
+    if( at != boost::string_view::npos )
+        host = mask.substr( at + 1 ).to_string();
+
+    return ( nick.empty() ? "*" : nick ) + "!" +
+           ( user.empty() ? "*" : user ) + "@" +
+           ( host.empty() ? "*" : host );
+}
+
+mask_set::mask_set( casemapping mapping )
+:   m_mapping(mapping),
+    m_nodes(anchors),
+    m_size(0)
+{
+}
+
+mask_set::id_type mask_set::add( boost::string_view mask )
+{
+    id_type id;
+    if( m_free.empty() )
+    {
+        id = static_cast<id_type>( m_entries.size() );
+        m_entries.push_back( entry() );
+    }
+    else
+    {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+
+    entry &e = m_entries[id];
+    e.mask = normalize_mask( mask );
+    e.used = true;
+    fold( e.mask, e.folded );
+    index( id );
+
+    ++m_size;
+    return id;
+}
+
+bool mask_set::remove( id_type id )
+{
+    if( id >= m_entries.size() || !m_entries[id].used )
+        return false;
+
+    entry &e = m_entries[id];
+    std::vector<id_type> &list = e.node == npos ? m_residual : m_nodes[e.node].masks;
+    std::vector<id_type>::iterator it = std::find( list.begin(), list.end(), id );
+    if( it != list.end() )
+    {
+        *it = list.back();
+        list.pop_back();
+    }
+
+    e.used = false;
+    e.mask.clear();
+    e.folded.clear();
+    m_free.push_back( id );
+    --m_size;
+    return true;
+}
+
+const std::string &mask_set::mask( id_type id ) const
+{
+    static const std::string none;
+    return id < m_entries.size() && m_entries[id].used ? m_entries[id].mask : none;
+}
+
+std::vector<mask_set::id_type> mask_set::matches( boost::string_view name ) const
+{
+    std::vector<id_type> result;
+    match( name, [&result]( id_type id )
+    {
+        result.push_back( id );
+        return true;
+    });
+    return result;
+}
+
+bool mask_set::any( boost::string_view name ) const
+{
+    return match( name, []( id_type ) { return false; } );
+}
+
+void mask_set::mapping( casemapping mapping )
+{
+    if( mapping == m_mapping )
+        return;
+
+    m_mapping = mapping;
+    m_nodes.assign( anchors, node() );
+    m_residual.clear();
+
+    for( id_type id = 0; id < m_entries.size(); ++id )
+    {
+        if( !m_entries[id].used )
+            continue;
+
+        fold( m_entries[id].mask, m_entries[id].folded );
+        index( id );
+    }
+}
+
+void mask_set::clear()
+{
+    m_entries.clear();
+    m_free.clear();
+    m_residual.clear();
+    m_nodes.assign( anchors, node() );
+    m_size = 0;
+}
+
+void mask_set::split( boost::string_view name, boost::string_view &nick,
+                      boost::string_view &user, boost::string_view &host )
+{
+    std::size_t bang = name.find('!'),
+                at   = name.find( '@', bang == boost::string_view::npos ? 0 : bang );
+
+    nick = name.substr( 0, bang < at ? bang : at );
+    user = bang == boost::string_view::npos
+         ? boost::string_view()
+         : name.substr( bang + 1, at == boost::string_view::npos
+                                  ? boost::string_view::npos : at - bang - 1 );
+    host = at == boost::string_view::npos ? boost::string_view() : name.substr( at + 1 );
+}
+
+void mask_set::fold( boost::string_view text, std::string &out ) const
+{
+    out.resize( text.size() );
+    for( std::size_t i = 0; i < text.size(); ++i )
+        out[i] = fold_case( text[i], m_mapping );
+}
+
+void mask_set::index( id_type id )
+{
+    entry &e = m_entries[id];
+    boost::string_view nick, user, host;
+    split( e.folded, nick, user, host );
+
+    // The literals before the first and after the last wildcard
+    boost::string_view literal[anchors];
+    std::size_t wild = host.find_last_of("*?");
+    literal[host_suffix] = wild == boost::string_view::npos ? host : host.substr( wild + 1 );
+    literal[host_prefix] = host.substr( 0, host.find_first_of("*?") );
+    literal[user_prefix] = user.substr( 0, user.find_first_of("*?") );
+    literal[nick_prefix] = nick.substr( 0, nick.find_first_of("*?") );
+
+    // The longest is the most selective, the host suffix wins ties
+    unsigned best = host_suffix;
+    for( unsigned i = host_prefix; i < anchors; ++i )
+        if( literal[i].size() > literal[best].size() )
+            best = i;
+
+    boost::string_view key = literal[best];
+    if( key.empty() )
+    {
+        e.node = npos;
+        m_residual.push_back( id );
+        return;
+    }
+
+    std::uint32_t current = best;
+    for( std::size_t i = 0; i < key.size(); ++i )
+    {
+        char ch = key[ best == host_suffix ? key.size() - 1 - i : i ];
+        std::vector< std::pair<char, std::uint32_t> > &children = m_nodes[current].children;
+        std::vector< std::pair<char, std::uint32_t> >::iterator it =
+            std::lower_bound( children.begin(), children.end(),
+                              std::make_pair( ch, std::uint32_t(0) ) );
+
+        if( it != children.end() && it->first == ch )
+        {
+            current = it->second;
+            continue;
+        }
+
+        std::uint32_t next = static_cast<std::uint32_t>( m_nodes.size() );
+        children.insert( it, std::make_pair( ch, next ) );
+        m_nodes.push_back( node() ); // children is invalidated from here
+        current = next;
+    }
+
+    e.node = current;
+    m_nodes[current].masks.push_back( id );
+}
+
+std::uint32_t mask_set::child( std::uint32_t parent, char ch ) const
+{
+    const std::vector< std::pair<char, std::uint32_t> > &children = m_nodes[parent].children;
+    std::vector< std::pair<char, std::uint32_t> >::const_iterator it =
+        std::lower_bound( children.begin(), children.end(),
+                          std::make_pair( ch, std::uint32_t(0) ) );
+
+    return it != children.end() && it->first == ch ? it->second : npos;
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_MASKSET_HPP
@@ -0,0 +1,230 @@
+/*
+    Name:        irc/impl/message.ipp
+    Purpose:     IRC message parsing implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_MESSAGE_HPP
+#define IRC_IMPL_MESSAGE_HPP
+
+#include <cctype>
+#include <cstring>
+
+namespace irc {
+
+bool message_view::tag( boost::string_view key, boost::string_view &value ) const
+{
+    boost::string_view rest = tags;
+    while( !rest.empty() )
+    {
+        std::size_t        end  = rest.find(';');
+        boost::string_view item = rest.substr( 0, end );
+        rest = end == boost::string_view::npos ? boost::string_view() : rest.substr( end + 1 );
+
+        std::size_t equal = item.find('=');
+        if( item.substr( 0, equal ) != key )
+            continue;
+
+        value = equal == boost::string_view::npos ? boost::string_view() : item.substr( equal + 1 );
+        return true;
+    }
+    return false;
+}
+
+bool parse_message( boost::string_view line, message_view &msg )
+{
+    msg = message_view();
+
+    // Leading word starting with lead, the rest skips the following spaces
+    auto take = [&line]( char lead, boost::string_view &word )
+    {
+        if( line.empty() || line[0] != lead )
+            return;
+
+        std::size_t space = line.find(' ');
+        word = line.substr( 1, space == boost::string_view::npos ? space : space - 1 );
+        line.remove_prefix( space == boost::string_view::npos ? line.size() : space );
+        while( !line.empty() && line[0] == ' ' )
+            line.remove_prefix( 1 );
+    };
+
+    take( '@', msg.tags );
+    take( ':', msg.prefix );
+
+    std::size_t space = line.find(' ');
+    msg.command = line.substr( 0, space );
+    line.remove_prefix( space == boost::string_view::npos ? line.size() : space );
+    if( msg.command.empty() )
+        return false;
+
+    if( msg.command.size() == 3 && std::isdigit( static_cast<unsigned char>( msg.command[0] ) ) &&
+        std::isdigit( static_cast<unsigned char>( msg.command[1] ) ) &&
+        std::isdigit( static_cast<unsigned char>( msg.command[2] ) ) )
+        msg.code = static_cast<reply_code>( ( msg.command[0] - '0' ) * 100 +
+                                            ( msg.command[1] - '0' ) * 10 +
+                                            ( msg.command[2] - '0' ) );
+
+    while( msg.param_count < static_cast<std::size_t>( max_params ) )
+    {
+        while( !line.empty() && line[0] == ' ' )
+            line.remove_prefix( 1 );
+
+        if( line.empty() )
+            break;
+
+        if( line[0] == ':' || msg.param_count + 1 == static_cast<std::size_t>( max_params ) )
+        {
+            msg.params[ msg.param_count++ ] = line[0] == ':' ? line.substr( 1 ) : line;
+            break;
+        }
+
+        space = line.find(' ');
+        msg.params[ msg.param_count++ ] = line.substr( 0, space );
+        line.remove_prefix( space == boost::string_view::npos ? line.size() : space );
+    }
+    return true;
+}
+
+message::message()
+{
+    reset();
+}
+
+message::message( const message_view &view )
+{
+    assign( view );
+}
+
+message::message( const std::string &sender,
+                  const std::string &str_cmd,
+                  reply_code         int_cmd,
+                  const params_type &params )
+{
+    message_view view;
+    view.prefix  = sender;
+    view.command = str_cmd;
+    view.code    = int_cmd;
+    for( const std::string &param : params )
+    {
+        if( view.param_count == static_cast<std::size_t>( max_params ) )
+            break;
+
+        view.params[ view.param_count++ ] = param;
+    }
+    assign( view );
+}
+
+message::message( const message &other )
+:   m_data(other.m_size ? new char[other.m_size] : nullptr),
+    m_size(other.m_size),
+    m_code(other.m_code),
+    m_param_count(other.m_param_count)
+{
+    if( m_size )
+        std::memcpy( m_data.get(), other.m_data.get(), m_size );
+
+    std::memcpy( m_spans, other.m_spans, sizeof(m_spans) );
+}
+
+message::message( message &&other ) noexcept
+:   m_data(std::move( other.m_data )),
+    m_size(other.m_size),
+    m_code(other.m_code),
+    m_param_count(other.m_param_count)
+{
+    std::memcpy( m_spans, other.m_spans, sizeof(m_spans) );
+    other.reset();
+}
+
+message &message::operator=( const message &other )
+{
+    if( this != &other )
+        *this = message( other );
+
+    return *this;
+}
+
+message &message::operator=( message &&other ) noexcept
+{
+    if( this == &other )
+        return *this;
+
+    m_data        = std::move( other.m_data );
+    m_size        = other.m_size;
+    m_code        = other.m_code;
+    m_param_count = other.m_param_count;
+    std::memcpy( m_spans, other.m_spans, sizeof(m_spans) );
+    other.reset();
+    return *this;
+}
+
+message::params_type message::params() const
+{
+    params_type result;
+    result.reserve( m_param_count );
+    for( std::size_t i = 0; i < m_param_count; ++i )
+        result.push_back( param( i ).to_string() );
+
+    return result;
+}
+
+message_view message::view() const
+{
+    message_view result;
+    result.tags        = tags();
+    result.prefix      = sender();
+    result.command     = command();
+    result.code        = m_code;
+    result.param_count = m_param_count;
+    for( std::size_t i = 0; i < m_param_count; ++i )
+        result.params[i] = param( i );
+
+    return result;
+}
+
+void message::assign( const message_view &view )
+{
+    const boost::string_view *texts[spans] = { &view.tags, &view.prefix, &view.command };
+    std::size_t count = first_param + view.param_count,
+                size  = 0;
+    for( std::size_t i = first_param; i < count; ++i )
+        texts[i] = &view.params[ i - first_param ];
+    for( std::size_t i = 0; i < count; ++i )
+        size += texts[i]->size();
+
+    // The view may point into this message, it is replaced once copied
+    std::unique_ptr<char[]> data( size ? new char[size] : nullptr );
+    span                    copied[spans] = {};
+    std::uint32_t           offset = 0;
+    for( std::size_t i = 0; i < count; ++i )
+    {
+        span &s = copied[i];
+        s.offset = offset;
+        s.size   = static_cast<std::uint32_t>( texts[i]->size() );
+        if( s.size )
+            std::memcpy( data.get() + offset, texts[i]->data(), s.size );
+
+        offset += s.size;
+    }
+
+    m_data        = std::move( data );
+    m_size        = static_cast<std::uint32_t>( size );
+    m_code        = view.code;
+    m_param_count = static_cast<std::uint8_t>( view.param_count );
+    std::memcpy( m_spans, copied, sizeof(m_spans) );
+}
+
+void message::reset()
+{
+    m_data.reset();
+    m_size        = 0;
+    m_code        = static_cast<reply_code>(0);
+    m_param_count = 0;
+    std::memset( m_spans, 0, sizeof(m_spans) );
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_MESSAGE_HPP
@@ -0,0 +1,194 @@
+/*
+    Name:        irc/impl/packer.ipp
+    Purpose:     Multiple targets commands packed into the fewest lines implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_PACKER_HPP
+#define IRC_IMPL_PACKER_HPP
+
+namespace irc {
+namespace detail {
+
+// Line length without CR-LF
+inline std::size_t line_budget( const isupport &limits )
+{
+    return limits.linelen() > 2 ? limits.linelen() - 2 : 510;
+}
+
+} // namespace detail
+
+std::size_t pack_targets( std::string &out, const std::string &command,
+                          const std::vector<std::string> &targets,
+                          const std::string &trailing, const isupport &limits )
+{
+    std::size_t budget = detail::line_budget( limits ),
+                lines  = 0;
+    unsigned    max    = limits.targmax( command ),
+                count  = 0;
+    std::string suffix = trailing.empty() ? std::string() : " :" + trailing,
+                line;
+
+    for( const std::string &target : targets )
+    {
+        if( target.empty() )
+            continue;
+
+        if( count && ( ( max && count == max ) ||
+                       line.size() + 1 + target.size() + suffix.size() > budget ) )
+        {
+            out.append( line ).append( suffix ).append( "\r\n" );
+            ++lines;
+            count = 0;
+        }
+
+        if( count )
+            line.append( 1, ',' ).append( target );
+        else
+            line = command + " " + target;
+
+        ++count;
+    }
+
+    if( count )
+    {
+        out.append( line ).append( suffix ).append( "\r\n" );
+        ++lines;
+    }
+    return lines;
+}
+
+std::size_t pack_join( std::string &out, const std::vector<std::string> &channels,
+                       const std::vector<std::string> &keys, const isupport &limits )
+{
+    std::size_t budget = detail::line_budget( limits ),
+                lines  = 0,
+                length = 0; // of the current line
+    unsigned    max    = limits.targmax( "JOIN" ),
+                count  = 0;
+    std::string keyed, plain, keylist;
+
+    auto flush = [&]()
+    {
+        out.append( "JOIN " ).append( keyed );
+        if( !keyed.empty() && !plain.empty() )
+            out.append( 1, ',' );
+
+        out.append( plain );
+        if( !keylist.empty() )
+            out.append( 1, ' ' ).append( keylist );
+
+        out.append( "\r\n" );
+        keyed.clear();
+        plain.clear();
+        keylist.clear();
+        length = 0;
+        count  = 0;
+        ++lines;
+    };
+
+    for( std::size_t i = 0; i < channels.size(); ++i )
+    {
+        const std::string &channel = channels[i];
+        if( channel.empty() )
+            continue;
+
+        const std::string &key = i < keys.size() ? keys[i] : std::string();
+
+        // "JOIN " + channels with their commas + " " + keys with their commas
+        std::size_t added = ( count ? 1 : 0 ) + channel.size() +
+                            ( key.empty() ? 0 : 1 + key.size() );
+        if( count && ( ( max && count == max ) || 5 + length + added > budget ) )
+        {
+            flush();
+            added = channel.size() + ( key.empty() ? 0 : 1 + key.size() );
+        }
+
+        if( key.empty() )
+        {
+            if( !plain.empty() )
+                plain.append( 1, ',' );
+            plain.append( channel );
+        }
+        else
+        {
+            if( !keyed.empty() )
+                keyed.append( 1, ',' );
+            keyed.append( channel );
+
+            if( !keylist.empty() )
+                keylist.append( 1, ',' );
+            keylist.append( key );
+        }
+        length += added;
+        ++count;
+    }
+
+    if( count )
+        flush();
+
+    return lines;
+}
+
+std::size_t pack_mode( std::string &out, const std::string &channel,
+                       const std::vector<mode_change> &changes, const isupport &limits )
+{
+    std::size_t budget = detail::line_budget( limits ),
+                lines  = 0;
+    unsigned    max    = limits.modes(),
+                params = 0;
+    std::string prefix = "MODE " + channel + " ",
+                modes,
+                args;
+    char        sign   = 0;
+
+    auto flush = [&]()
+    {
+        out.append( prefix ).append( modes ).append( args ).append( "\r\n" );
+        modes.clear();
+        args.clear();
+        params = 0;
+        sign   = 0;
+        ++lines;
+    };
+
+    for( const mode_change &change : changes )
+    {
+        if( !change.mode )
+            continue;
+
+        char        want  = change.set ? '+' : '-';
+        bool        param = !change.argument.empty();
+        std::size_t added = ( sign != want ? 1 : 0 ) + 1 +
+                            ( param ? 1 + change.argument.size() : 0 );
+
+        if( !modes.empty() &&
+            ( ( param && max && params == max ) ||
+              prefix.size() + modes.size() + args.size() + added > budget ) )
+            flush();
+
+        if( sign != want )
+        {
+            modes.append( 1, want );
+            sign = want;
+        }
+        modes.append( 1, change.mode );
+
+        if( param )
+        {
+            args.append( 1, ' ' ).append( change.argument );
+            ++params;
+        }
+    }
+
+    if( !modes.empty() )
+        flush();
+
+    return lines;
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_PACKER_HPP
@@ -0,0 +1,423 @@
+/*
+    Name:        irc/impl/session.ipp
+    Purpose:     Protocol state of a connection, without any I/O implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_SESSION_HPP
+#define IRC_IMPL_SESSION_HPP
+
+#include <algorithm>
+
+#include "irc/detail/base64.hpp"
+#include "irc/detail/buffer_pool.hpp"
+
+namespace irc {
+
+session::session()
+:   m_read_pos(0),
+    m_skim_pos(0),
+    m_prepared(0),
+    m_cap_pending(0),
+    m_nick_tries(0),
+    m_started(false),
+    m_registered(false),
+    m_sasl_active(false),
+    m_ping_sent(false),
+    m_timed_out(false),
+    m_interval(clock::duration::zero()),
+    m_timeout(clock::duration::zero())
+{
+}
+
+void session::identity( const std::string &nickname, const std::string &username,
+                        const std::string &realname, const std::string &password )
+{
+    m_nickname = nickname;
+    m_username = username;
+    m_realname = realname;
+    m_password = password;
+}
+
+bool session::capability( boost::string_view name ) const
+{
+    std::string key = name.to_string() + ' ';
+    return m_capabilities.compare( 0, key.size(), key ) == 0 ||
+           m_capabilities.find( ' ' + key ) != std::string::npos;
+}
+
+void session::start( clock::time_point now )
+{
+    stop();
+
+    m_registered  = false;
+    m_cap_pending = 0;
+    m_sasl_active = false;
+    m_nick_tries  = 0;
+    m_first_nick  = m_nickname;
+    m_capabilities.clear();
+
+    if( m_connect_start == clock::time_point() )
+        m_connect_start = now;
+
+    m_stats           = registration_stats();
+    m_stats.connected = now - m_connect_start;
+
+    m_started    = true;
+    m_ping_sent  = false;
+    m_timed_out  = false;
+    m_last_input = now;
+
+    // Registration goes first, the lines queued meanwhile follow
+    detail::buffer_pool::instance().acquire( m_output );
+    m_output.insert( 0, registration_lines() );
+}
+
+void session::stop()
+{
+    m_started  = false;
+    m_line     = boost::string_view();
+    m_read_pos = 0;
+    m_skim_pos = 0;
+    m_input.clear();
+    detail::buffer_pool::instance().release( m_input );
+}
+
+char *session::prepare( std::size_t limit, std::size_t &size )
+{
+    compact();
+    m_prepared = m_input.size();
+    size       = std::max<std::size_t>( m_input.capacity() - m_prepared, 512 );
+    if( limit && m_prepared + size > limit )
+        size = limit > m_prepared ? limit - m_prepared : 0;
+
+    m_input.resize( m_prepared + size );
+    return &m_input[ m_prepared ];
+}
+
+void session::commit( std::size_t bytes, clock::time_point now )
+{
+    m_input.resize( m_prepared + bytes );
+    if( !bytes )
+        return;
+
+    // Any input shows the server is alive
+    m_last_input = now;
+    m_ping_sent  = false;
+}
+
+void session::receive( boost::string_view bytes, clock::time_point now )
+{
+    compact();
+    m_prepared = m_input.size();
+    m_input.append( bytes.data(), bytes.size() );
+    commit( bytes.size(), now );
+}
+
+session_event session::next( message_view &msg )
+{
+    std::size_t end;
+    while( ( end = m_input.find( '\n', m_read_pos ) ) != std::string::npos )
+    {
+        boost::string_view line( m_input.data() + m_read_pos, end - m_read_pos );
+        m_read_pos = end + 1;
+
+        // Remove carriage return
+        if( !line.empty() && line.back() == '\r' )
+            line.remove_suffix( 1 );
+
+        if( line.empty() || !parse_message( line, msg ) )
+            continue;
+
+        m_line = line;
+        if( msg.command == "PING" )
+        {
+            pong( msg.param( 0 ) );
+            return session_event::message;
+        }
+
+        // Capabilities, SASL and nickname retries are answered here
+        if( ( !m_registered || msg.command == "CAP" ) && handle_registration( msg ) )
+            return session_event::consumed;
+
+        return session_event::message;
+    }
+    return session_event::none;
+}
+
+std::size_t session::skim()
+{
+    if( m_skim_pos < m_read_pos )
+        m_skim_pos = m_read_pos;
+
+    std::size_t answered = 0,
+                end;
+    while( ( end = m_input.find( '\n', m_skim_pos ) ) != std::string::npos )
+    {
+        boost::string_view line( m_input.data() + m_skim_pos, end - m_skim_pos );
+        if( !line.empty() && line.back() == '\r' )
+            line.remove_suffix( 1 );
+
+        message_view msg;
+        if( parse_message( line, msg ) && msg.command == "PING" )
+        {
+            pong( msg.param( 0 ) );
+
+            m_input.erase( m_skim_pos, end + 1 - m_skim_pos );
+            ++answered;
+        }
+        else
+            m_skim_pos = end + 1;
+    }
+    return answered;
+}
+
+// The read bytes move to the front, the buffer is taken from the pool if needed
+void session::compact()
+{
+    m_skim_pos = m_skim_pos > m_read_pos ? m_skim_pos - m_read_pos : 0;
+    m_input.erase( 0, m_read_pos );
+    m_read_pos = 0;
+    m_line     = boost::string_view();
+    detail::buffer_pool::instance().acquire( m_input );
+}
+
+void session::pong( boost::string_view token )
+{
+    detail::buffer_pool::instance().acquire( m_output );
+    m_output.append( "PONG :" ).append( token.data(), token.size() ).append( "\r\n" );
+}
+
+void session::send( boost::string_view line )
+{
+    detail::buffer_pool::instance().acquire( m_output );
+    m_output.append( line.data(), line.size() ).append( "\r\n" );
+}
+
+void session::send_lines( boost::string_view lines )
+{
+    detail::buffer_pool::instance().acquire( m_output );
+    m_output.append( lines.data(), lines.size() );
+}
+
+void session::discard_output()
+{
+    m_output.clear();
+    detail::buffer_pool::instance().release( m_output );
+}
+
+void session::take_output( std::string &flight )
+{
+    flight.clear();
+    flight.swap( m_output );
+}
+
+void session::shrink()
+{
+    if( m_read_pos == m_input.size() )
+    {
+        m_input.clear();
+        m_read_pos = 0;
+        m_skim_pos = 0;
+        m_line     = boost::string_view();
+        detail::buffer_pool::instance().release( m_input );
+    }
+    detail::buffer_pool::instance().release( m_output );
+}
+
+void session::keepalive( clock::duration interval, clock::duration timeout )
+{
+    m_interval = interval;
+    m_timeout  = timeout == clock::duration::zero() ? interval : timeout;
+}
+
+session::clock::time_point session::deadline() const
+{
+    if( !m_started || m_timed_out || m_interval == clock::duration::zero() )
+        return clock::time_point::max();
+
+    return m_ping_sent ? m_ping_at + m_timeout : m_last_input + m_interval;
+}
+
+void session::tick( clock::time_point now )
+{
+    if( now < deadline() )
+        return;
+
+    if( m_ping_sent )
+    {
+        m_timed_out = true;
+        return;
+    }
+
+    m_ping_sent = true;
+    m_ping_at   = now;
+    send( "PING :" + m_nickname );
+}
+
+std::string session::registration_lines()
+{
+    const std::string &password = m_password.empty() ? m_options.password : m_password;
+
+    std::string lines;
+    if( !password.empty() )
+        lines += "PASS " + password + "\r\n";
+
+    if( negotiating() )
+    {
+        lines += "CAP LS 302\r\n";
+
+        std::string request;
+        for( const std::string &cap : m_options.capabilities )
+            request += request.empty() ? cap : ' ' + cap;
+
+        if( !m_options.sasl_username.empty() )
+            request += request.empty() ? "sasl" : " sasl";
+
+        if( !request.empty() )
+        {
+            lines += "CAP REQ :" + request + "\r\n";
+            ++m_cap_pending;
+        }
+    }
+
+    lines += "NICK " + m_nickname + "\r\n"
+             "USER " + m_username + " unknown unknown :" + m_realname + "\r\n";
+    return lines;
+}
+
+bool session::handle_registration( const message_view &msg )
+{
+    switch( static_cast<int>( msg.code ) )
+    {
+    case 1: // RPL_WELCOME, with the nickname given by the server
+        m_registered     = true;
+        m_stats.welcomed = m_last_input - m_connect_start;
+        if( msg.param_count )
+            m_nickname = msg.params[0].to_string();
+        return false;
+
+    case 433: // ERR_NICKNAMEINUSE
+    case 437: // ERR_UNAVAILRESOURCE
+        return retry_nickname();
+
+    case 900: // RPL_LOGGEDIN, RPL_SASLMECHS
+    case 908:
+        return true;
+
+    case 903: // RPL_SASLSUCCESS
+    case 902: // ERR_NICKLOCKED, ERR_SASLFAIL, ERR_SASLTOOLONG, ERR_SASLABORTED, ERR_SASLALREADY
+    case 904:
+    case 905:
+    case 906:
+    case 907:
+        m_stats.sasl  = msg.code == static_cast<reply_code>( 903 );
+        m_sasl_active = false;
+        end_negotiation();
+        return true;
+    }
+
+    if( msg.command == "AUTHENTICATE" )
+    {
+        if( m_sasl_active && msg.param(0) == "+" )
+            send_sasl_plain();
+        return true;
+    }
+
+    if( msg.command != "CAP" || msg.param_count < 2 )
+        return false;
+
+    // CAP <target> <subcommand> [*] :<capabilities>
+    boost::string_view sub  = msg.params[1],
+                       list = msg.params[ msg.param_count - 1 ];
+    bool               more = msg.param_count > 3 && msg.params[2] == "*";
+    if( sub == "LS" )
+    {
+        if( !more && !m_registered )
+            end_negotiation();
+    }
+    else if( sub == "ACK" || sub == "NEW" )
+    {
+        for_each_word( list, [this]( boost::string_view cap )
+        {
+            if( cap.empty() || cap[0] == '-' )
+                return;
+            m_capabilities.append( cap.data(), cap.size() ).append( 1, ' ' );
+            if( cap == "sasl" && !m_registered && !m_options.sasl_username.empty() )
+            {
+                m_sasl_active = true;
+                send( "AUTHENTICATE PLAIN" );
+            }
+        });
+        if( sub == "ACK" && m_cap_pending )
+            --m_cap_pending;
+        end_negotiation();
+    }
+    else if( sub == "NAK" )
+    {
+        if( m_cap_pending )
+            --m_cap_pending;
+        end_negotiation();
+    }
+    else if( sub == "DEL" )
+    {
+        for_each_word( list, [this]( boost::string_view cap )
+        {
+            std::size_t at = (" " + m_capabilities).find( " " + cap.to_string() + " " );
+            if( at != std::string::npos )
+                m_capabilities.erase( at, cap.size() + 1 );
+        });
+    }
+    return true;
+}
+
+// CAP END once nothing is awaited, the server then completes the registration
+void session::end_negotiation()
+{
+    if( m_registered || m_cap_pending || m_sasl_active || !negotiating() )
+        return;
+
+    send( "CAP END" );
+}
+
+void session::send_sasl_plain()
+{
+    const std::string &user    = m_options.sasl_username;
+    std::string        payload = detail::base64_encode( user + '\0' + user + '\0' +
+                                                        m_options.sasl_password );
+
+    // 400 bytes per line, a full last line is followed by an empty one
+    std::size_t at = 0;
+    do
+    {
+        std::string chunk = payload.substr( at, 400 );
+        at += 400;
+        send( "AUTHENTICATE " + ( chunk.empty() ? std::string("+") : chunk ) );
+        if( chunk.size() < 400 )
+            break;
+    }
+    while( true );
+}
+
+bool session::retry_nickname()
+{
+    const std::vector<std::string> &alternates = m_options.alt_nicknames;
+    if( m_registered ||
+        m_nick_tries >= alternates.size() + m_options.nick_retries )
+        return false;
+
+    m_nickname = m_nick_tries < alternates.size()
+               ? alternates[m_nick_tries]
+               : m_first_nick + std::string( m_nick_tries - alternates.size() + 1, '_' );
+    ++m_nick_tries;
+    ++m_stats.nick_retries;
+
+    send( "NICK " + m_nickname );
+    return true;
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_SESSION_HPP
@@ -0,0 +1,212 @@
+/*
+    Name:        irc/impl/trace.ipp
+    Purpose:     Binary low-overhead trace ring buffer implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_TRACE_HPP
+#define IRC_IMPL_TRACE_HPP
+
+#include <cstdio>
+#include <istream>
+#include <ostream>
+
+namespace irc {
+namespace detail {
+
+static const char trace_magic[8] = { 'I','R','C','T','R','A','C','E' };
+
+inline const char *trace_event_name( std::uint8_t type )
+{
+    static const char *names[] = { "line_received", "command_parsed",
+                                   "callback_enter", "callback_exit",
+                                   "write_issued", "write_completed",
+                                   "read_paused", "read_resumed" };
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "invalid";
+}
+
+inline const char *trace_handler_name( std::uint16_t code )
+{
+    static const char *names[] = { "on_unknown", "on_invite", "on_channel_notice",
+                                   "on_private_notice", "on_channel_msg",
+                                   "on_private_msg", "on_action", "on_dcc_request",
+                                   "on_numeric_reply", "on_connected",
+                                   "on_disconnected", "on_version",
+                                   "on_list_entry", "on_list_end", "on_ctcp",
+                                   "on_trigger", "subscriber", "on_message" };
+    return code < sizeof(names) / sizeof(names[0]) ? names[code] : "invalid";
+}
+
+inline void trace_escape( std::ostream &out, const trace_record &rec )
+{
+    for( std::uint8_t i = 0; i < rec.size; ++i )
+    {
+        unsigned char ch = static_cast<unsigned char>( rec.data[i] );
+        if( ch == '"' || ch == '\\' )
+            out << '\\' << ch;
+        else if( ch < 0x20 || ch == 0x7f )
+        {
+            char hex[8];
+            std::snprintf( hex, sizeof(hex), "\\u%04x", ch );
+            out << hex;
+        }
+        else
+            out << ch;
+    }
+}
+
+} // namespace detail
+
+trace_ring::trace_ring( std::size_t capacity )
+:   m_mask(0),
+    m_head(0),
+    m_enabled(false)
+{
+    std::size_t size = 1;
+    while( size < capacity )
+        size <<= 1;
+
+    m_slots.reset( new slot[size] );
+    m_mask = size - 1;
+
+    for( std::size_t i = 0; i < size; ++i )
+        m_slots[i].seq.store( 0, std::memory_order_relaxed );
+}
+
+std::vector<trace_record> trace_ring::snapshot() const
+{
+    std::vector<trace_record> records;
+
+    std::uint64_t head = m_head.load( std::memory_order_acquire ),
+                  size = m_mask + 1,
+                  tail = head > size ? head - size : 0;
+
+    records.reserve( static_cast<std::size_t>( head - tail ) );
+    for( std::uint64_t i = tail; i < head; ++i )
+    {
+        const slot &s = m_slots[ i & m_mask ];
+        if( s.seq.load( std::memory_order_acquire ) != i + 1 )
+            continue;
+
+        trace_record rec = s.rec;
+        std::atomic_thread_fence( std::memory_order_acquire );
+
+        // Overwritten by the writer while copying
+        if( s.seq.load( std::memory_order_relaxed ) != i + 1 )
+            continue;
+
+        records.push_back( rec );
+    }
+    return records;
+}
+
+void trace_ring::save( std::ostream &out ) const
+{
+    std::vector<trace_record> records = snapshot();
+    std::uint64_t count = records.size();
+
+    out.write( detail::trace_magic, sizeof(detail::trace_magic) );
+    out.write( reinterpret_cast<const char *>( &count ), sizeof(count) );
+    if( count )
+        out.write( reinterpret_cast<const char *>( records.data() ),
+                   static_cast<std::streamsize>( count * sizeof(trace_record) ) );
+}
+
+std::vector<trace_record> trace_ring::load( std::istream &in )
+{
+    std::vector<trace_record> records;
+    char          magic[sizeof(detail::trace_magic)];
+    std::uint64_t count = 0;
+
+    if( !in.read( magic, sizeof(magic) ) ||
+        std::memcmp( magic, detail::trace_magic, sizeof(magic) ) != 0 ||
+        !in.read( reinterpret_cast<char *>( &count ), sizeof(count) ) )
+        return records;
+
+    trace_record rec;
+    while( count-- && in.read( reinterpret_cast<char *>( &rec ), sizeof(rec) ) )
+        records.push_back( rec );
+
+    return records;
+}
+
+void trace_ring::dump_text( std::ostream &out, const std::vector<trace_record> &records )
+{
+    if( records.empty() )
+        return;
+
+    std::uint64_t start = records.front().stamp;
+    for( const trace_record &rec : records )
+    {
+        char stamp[32];
+        std::snprintf( stamp, sizeof(stamp), "%14.3f us ",
+                       static_cast<double>( rec.stamp - start ) / 1000.0 );
+        out << stamp << detail::trace_event_name( rec.type );
+
+        switch( static_cast<trace_event>( rec.type ) )
+        {
+        case trace_event::callback_enter:
+        case trace_event::callback_exit:
+            out << ' ' << detail::trace_handler_name( rec.code );
+            break;
+        case trace_event::command_parsed:
+            out << " code=" << rec.code;
+            break;
+        case trace_event::write_completed:
+            out << " error=" << rec.code << " bytes=" << rec.arg;
+            break;
+        case trace_event::read_paused:
+            out << " held=" << rec.arg;
+            break;
+        case trace_event::read_resumed:
+            out << " ms=" << rec.arg;
+            break;
+        default:
+            out << " bytes=" << rec.arg;
+            break;
+        }
+
+        if( rec.size )
+            out << " \"" << std::string( rec.data, rec.size ) << '"';
+        out << '\n';
+    }
+}
+
+void trace_ring::dump_chrome( std::ostream &out, const std::vector<trace_record> &records )
+{
+    out << "{\"traceEvents\":[";
+
+    bool first = true;
+    for( const trace_record &rec : records )
+    {
+        trace_event type = static_cast<trace_event>( rec.type );
+        const char *phase = type == trace_event::callback_enter ? "B"
+                          : type == trace_event::callback_exit  ? "E" : "i";
+        char ts[32];
+        std::snprintf( ts, sizeof(ts), "%.3f", static_cast<double>( rec.stamp ) / 1000.0 );
+
+        out << ( first ? "\n" : ",\n" ) << "{\"name\":\"";
+        if( type == trace_event::callback_enter || type == trace_event::callback_exit )
+            out << detail::trace_handler_name( rec.code );
+        else
+            out << detail::trace_event_name( rec.type );
+
+        out << "\",\"ph\":\"" << phase << "\",\"ts\":" << ts
+            << ",\"pid\":1,\"tid\":1";
+        if( *phase == 'i' )
+            out << ",\"s\":\"t\"";
+
+        out << ",\"args\":{\"code\":" << rec.code << ",\"arg\":" << rec.arg
+            << ",\"data\":\"";
+        detail::trace_escape( out, rec );
+        out << "\"}}";
+        first = false;
+    }
+    out << "\n]}\n";
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_TRACE_HPP
@@ -0,0 +1,212 @@
+/*
+    Name:        irc/impl/transport.ipp
+    Purpose:     Byte streams a client can talk to a server over implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_TRANSPORT_HPP
+#define IRC_IMPL_TRANSPORT_HPP
+
+#include <algorithm>
+#include <cstring>
+
+#include <boost/asio/connect.hpp>
+
+namespace irc {
+
+void tcp_transport::async_connect( const std::string &host, const std::string &port,
+                                   connect_handler handler )
+{
+    boost::asio::ip::tcp::resolver           resolver( m_socket.get_executor() );
+    boost::asio::ip::tcp::resolver::query    query( host, port );
+    boost::asio::ip::tcp::resolver::iterator endpoint_iter = resolver.resolve( query );
+
+    boost::asio::async_connect( m_socket, endpoint_iter,
+        [handler]( const boost::system::error_code &ec,
+                   boost::asio::ip::tcp::resolver::iterator )
+        {
+            handler( ec );
+        });
+}
+
+void unix_transport::async_connect( const std::string &path, const std::string &,
+                                    connect_handler handler )
+{
+    close();
+    m_socket.async_connect( boost::asio::local::stream_protocol::endpoint( path ), handler );
+}
+
+memory_pipe::memory_pipe( boost::asio::io_context &io )
+:   m_io(io),
+    m_read_pos(0),
+    m_open(false)
+{
+}
+
+memory_pipe::ptr memory_pipe::create( boost::asio::io_context &io )
+{
+    return std::make_shared<memory_pipe>( io );
+}
+
+void memory_pipe::write( boost::string_view bytes )
+{
+    m_to_client.append( bytes.data(), bytes.size() );
+    wake( boost::system::error_code() );
+}
+
+std::size_t memory_pipe::read( std::string &bytes )
+{
+    std::size_t size = m_to_server.size();
+    bytes.append( m_to_server );
+    m_to_server.clear();
+    return size;
+}
+
+void memory_pipe::close()
+{
+    m_open = false;
+    wake( boost::system::error_code() );
+}
+
+// The waiting client reads next, bytes or the end of file
+void memory_pipe::wake( const boost::system::error_code &ec )
+{
+    if( !m_waiter )
+        return;
+
+    connect_handler waiter;
+    waiter.swap( m_waiter );
+    boost::asio::post( m_io, std::bind( waiter, ec ) );
+}
+
+void pipe_transport::async_connect( const std::string &, const std::string &,
+                                    connect_handler handler )
+{
+    m_pipe->m_to_client.clear();
+    m_pipe->m_to_server.clear();
+    m_pipe->m_read_pos = 0;
+    m_pipe->m_open     = true;
+    boost::asio::post( m_pipe->m_io, std::bind( handler, boost::system::error_code() ) );
+}
+
+void pipe_transport::async_wait_read( connect_handler handler )
+{
+    m_pipe->m_waiter = handler;
+    if( m_pipe->m_read_pos < m_pipe->m_to_client.size() || !m_pipe->m_open )
+        m_pipe->wake( boost::system::error_code() );
+}
+
+std::size_t pipe_transport::read_some( char *data, std::size_t size,
+                                       boost::system::error_code &ec )
+{
+    std::string &input = m_pipe->m_to_client;
+    std::size_t  bytes = std::min( size, input.size() - m_pipe->m_read_pos );
+    if( !bytes )
+    {
+        if( m_pipe->m_open )
+            ec = boost::asio::error::would_block;
+        else
+            ec = boost::asio::error::eof;
+        return 0;
+    }
+
+    std::memcpy( data, input.data() + m_pipe->m_read_pos, bytes );
+    m_pipe->m_read_pos += bytes;
+    if( m_pipe->m_read_pos == input.size() )
+    {
+        input.clear();
+        m_pipe->m_read_pos = 0;
+    }
+    ec = boost::system::error_code();
+    return bytes;
+}
+
+void pipe_transport::close()
+{
+    m_pipe->m_open = false;
+    m_pipe->wake( boost::asio::error::operation_aborted );
+}
+
+#ifdef IRC_CLIENT_HAS_SSL
+const std::size_t tls_transport::buffer_size;
+
+void tls_transport::async_connect( const std::string &host, const std::string &port,
+                                   connect_handler handler )
+{
+    close();
+    m_state = std::make_shared<state>( *m_io, *m_context );
+
+    // The server name is not sent for an address (RFC 6066), only checked
+    boost::system::error_code ec;
+    std::shared_ptr<state>    s = m_state;
+    boost::asio::ip::make_address( host, ec );
+    if( ec && !SSL_set_tlsext_host_name( s->stream.native_handle(), host.c_str() ) )
+        ec = boost::system::error_code( static_cast<int>( ERR_get_error() ),
+                                        boost::asio::error::get_ssl_category() );
+    else
+        s->stream.set_verify_callback( boost::asio::ssl::host_name_verification( host ), ec );
+
+    if( ec )
+    {
+        boost::asio::post( *m_io, std::bind( handler, ec ) );
+        return;
+    }
+
+    boost::asio::ip::tcp::resolver           resolver( *m_io );
+    boost::asio::ip::tcp::resolver::query    query( host, port );
+    boost::asio::ip::tcp::resolver::iterator endpoint_iter = resolver.resolve( query );
+
+    boost::asio::async_connect( s->stream.lowest_layer(), endpoint_iter,
+        [s, handler]( const boost::system::error_code &ec,
+                      boost::asio::ip::tcp::resolver::iterator )
+        {
+            if( ec )
+            {
+                handler( ec );
+                return;
+            }
+            s->stream.async_handshake( boost::asio::ssl::stream_base::client, handler );
+        });
+}
+
+std::size_t tls_transport::read_some( char *data, std::size_t size,
+                                      boost::system::error_code &ec )
+{
+    std::size_t bytes = m_state ? std::min( size, m_state->end - m_state->begin ) : 0;
+    if( !bytes )
+    {
+        ec = boost::asio::error::would_block;
+        return 0;
+    }
+
+    std::memcpy( data, m_state->buffer.get() + m_state->begin, bytes );
+    m_state->begin += bytes;
+    ec = boost::system::error_code();
+    return bytes;
+}
+
+void tls_transport::close()
+{
+    if( !m_state )
+        return;
+
+    boost::system::error_code ignored;
+    m_state->stream.lowest_layer().close( ignored );
+}
+
+boost::asio::ip::address tls_transport::local_address( boost::system::error_code &ec ) const
+{
+    if( !m_state )
+    {
+        ec = boost::asio::error::not_connected;
+        return boost::asio::ip::address();
+    }
+    return m_state->stream.lowest_layer().local_endpoint( ec ).address();
+}
+#endif
+
+} // namespace irc
+
+#endif // IRC_IMPL_TRANSPORT_HPP
@@ -0,0 +1,218 @@
+/*
+    Name:        irc/impl/trigger.ipp
+    Purpose:     Keywords and commands triggers matched in one pass implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_TRIGGER_HPP
+#define IRC_IMPL_TRIGGER_HPP
+
+#include <cstring>
+
+namespace irc {
+
+trigger_set::trigger_set()
+:   m_size(0),
+    m_dirty(true),
+    m_stamp(0),
+    m_classes(1)
+{
+    std::memset( m_class, 0, sizeof(m_class) );
+}
+
+trigger_set::id_type trigger_set::add( const std::string &literal, const trigger_options &opts )
+{
+    if( literal.empty() && opts.regex.empty() )
+        return npos;
+
+    std::shared_ptr<std::regex> regex;
+    if( !opts.regex.empty() )
+    {
+        std::regex::flag_type flags = std::regex::ECMAScript | std::regex::optimize;
+        if( !opts.case_sensitive )
+            flags |= std::regex::icase;
+
+        try
+        {
+            regex = std::make_shared<std::regex>( opts.regex, flags );
+        }
+        catch( const std::regex_error & )
+        {
+            return npos;
+        }
+    }
+
+    id_type id;
+    if( m_free.empty() )
+    {
+        id = static_cast<id_type>( m_patterns.size() );
+        m_patterns.push_back( pattern() );
+    }
+    else
+    {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+
+    pattern &p = m_patterns[id];
+    p.literal = literal;
+    p.opts    = opts;
+    p.regex   = regex;
+    p.stamp   = 0;
+    p.used    = true;
+
+    ++m_size;
+    m_dirty = true;
+    return id;
+}
+
+bool trigger_set::remove( id_type id )
+{
+    if( id >= m_patterns.size() || !m_patterns[id].used )
+        return false;
+
+    // The identifier is reused once the automaton forgot it
+    m_patterns[id].used = false;
+    m_patterns[id].regex.reset();
+    --m_size;
+    m_dirty = true;
+    return true;
+}
+
+void trigger_set::compile()
+{
+    m_dirty = false;
+    m_always.clear();
+    m_free.clear();
+
+    // A class per character used, uppercase letters share the lowercase ones
+    std::memset( m_class, 0, sizeof(m_class) );
+    m_classes = 1;
+    for( id_type id = 0; id < m_patterns.size(); ++id )
+    {
+        pattern &p = m_patterns[id];
+        if( !p.used )
+        {
+            p.literal.clear();
+            m_free.push_back( id );
+            continue;
+        }
+
+        if( p.literal.empty() )
+            m_always.push_back( id );
+
+        for( char ch : p.literal )
+        {
+            unsigned char folded = fold( static_cast<unsigned char>( ch ) );
+            if( !m_class[folded] )
+                m_class[folded] = static_cast<unsigned char>( m_classes++ );
+        }
+    }
+    for( unsigned ch = 'A'; ch <= 'Z'; ++ch )
+        m_class[ch] = m_class[ch + 32];
+
+    // The trie, none for missing transitions
+    const std::uint32_t none = npos;
+    std::vector< std::vector<id_type> > own( 1 );
+    m_delta.assign( m_classes, none );
+    for( id_type id = 0; id < m_patterns.size(); ++id )
+    {
+        const pattern &p = m_patterns[id];
+        if( !p.used || p.literal.empty() )
+            continue;
+
+        std::uint32_t state = 0;
+        for( char ch : p.literal )
+        {
+            std::uint32_t &next = m_delta[ state * m_classes + m_class[ static_cast<unsigned char>( ch ) ] ];
+            if( next == npos )
+            {
+                next = static_cast<std::uint32_t>( own.size() );
+                own.push_back( std::vector<id_type>() );
+                m_delta.resize( own.size() * m_classes, none ); // next is invalidated
+            }
+            state = m_delta[ state * m_classes + m_class[ static_cast<unsigned char>( ch ) ] ];
+        }
+        own[state].push_back( id );
+    }
+
+    // Failure links in breadth first order, turning the trie into a complete
+    // automaton and collecting the patterns ending at each state
+    std::size_t                states = own.size();
+    std::vector<std::uint32_t> fail( states, 0 ),
+                               queue;
+    std::vector< std::vector<id_type> > out( states );
+    queue.reserve( states );
+
+    for( std::size_t c = 0; c < m_classes; ++c )
+    {
+        std::uint32_t &next = m_delta[c];
+        if( next == npos )
+            next = 0;
+        else
+            queue.push_back( next );
+    }
+
+    out[0] = own[0];
+    for( std::size_t head = 0; head < queue.size(); ++head )
+    {
+        std::uint32_t state = queue[head];
+        out[state] = own[state];
+        out[state].insert( out[state].end(), out[ fail[state] ].begin(), out[ fail[state] ].end() );
+
+        for( std::size_t c = 0; c < m_classes; ++c )
+        {
+            std::uint32_t &next = m_delta[ state * m_classes + c ];
+            if( next == npos )
+                next = m_delta[ fail[state] * m_classes + c ];
+            else
+            {
+                fail[next] = m_delta[ fail[state] * m_classes + c ];
+                queue.push_back( next );
+            }
+        }
+    }
+
+    m_out.clear();
+    m_out_begin.assign( states + 1, 0 );
+    for( std::size_t state = 0; state < states; ++state )
+    {
+        m_out_begin[state] = static_cast<std::uint32_t>( m_out.size() );
+        m_out.insert( m_out.end(), out[state].begin(), out[state].end() );
+    }
+    m_out_begin[states] = static_cast<std::uint32_t>( m_out.size() );
+
+    for( std::uint32_t &next : m_delta )
+        next = static_cast<std::uint32_t>( next * m_classes ) |
+               ( out[next].empty() ? 0 : output_flag );
+}
+
+bool trigger_set::accept( id_type id, boost::string_view text, std::size_t start )
+{
+    pattern &p = m_patterns[id];
+    if( !p.used || p.stamp == m_stamp )
+        return false;
+
+    std::size_t length = p.literal.size();
+    if( p.opts.anchored && start != 0 )
+        return false;
+
+    if( p.opts.case_sensitive && text.compare( start, length, p.literal ) != 0 )
+        return false;
+
+    if( p.opts.whole_word && length &&
+        ( ( start > 0 && word_char( static_cast<unsigned char>( text[start - 1] ) ) ) ||
+          ( start + length < text.size() &&
+            word_char( static_cast<unsigned char>( text[start + length] ) ) ) ) )
+        return false;
+
+    // The regex searches the whole text, other occurrences would not change it
+    p.stamp = m_stamp;
+    return !p.regex || std::regex_search( text.begin(), text.end(), *p.regex );
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_TRIGGER_HPP
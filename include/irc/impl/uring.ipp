@@ -0,0 +1,517 @@
+/*
+    Name:        irc/impl/uring.ipp
+    Purpose:     Linux io_uring transport shared by many clients implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_URING_HPP
+#define IRC_IMPL_URING_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <boost/asio/post.hpp>
+#include <boost/system/system_error.hpp>
+
+namespace irc {
+namespace {
+
+// The buffer group of the receive buffers, one per ring
+const std::uint16_t receive_group = 0;
+
+void throw_errno( int error, const char *what )
+{
+    throw boost::system::system_error(
+        boost::system::error_code( error, boost::system::system_category() ), what );
+}
+
+} // namespace
+
+const uring_service::id_type uring_service::npos;
+
+uring_service::uring_service( boost::asio::io_context &io, const uring_options &opts )
+:   m_fd(-1),
+    m_event(-1),
+    m_io(io),
+    m_notify(io),
+    m_sq_ring(MAP_FAILED),
+    m_cq_ring(MAP_FAILED),
+    m_sq_size(0),
+    m_cq_size(0),
+    m_sqes(static_cast<io_uring_sqe *>( MAP_FAILED )),
+    m_sq_local(0),
+    m_sq_flushed(0),
+    m_buf_ring(static_cast<io_uring_buf *>( MAP_FAILED )),
+    m_buf_ring_size(0),
+    m_options(opts),
+    m_buf_tail(0),
+    m_pending(0),
+    m_flush_posted(false),
+    m_waiting(false)
+{
+    // The destructor does not run if this throws
+    struct cleanup
+    {
+        explicit cleanup( uring_service &self ) : self(self), done(false) {}
+        ~cleanup()
+        {
+            if( !done )
+                self.shutdown();
+        }
+
+        uring_service &self;
+        bool           done;
+    } guard( *this );
+
+    if( !m_options.buffers || m_options.buffers > 32768 ||
+        ( m_options.buffers & ( m_options.buffers - 1 ) ) || !m_options.buffer_size )
+        throw_errno( EINVAL, "uring_service buffers" );
+
+    io_uring_params params;
+    std::memset( &params, 0, sizeof(params) );
+    params.flags      = IORING_SETUP_CQSIZE;
+    params.cq_entries = m_options.entries * 4;
+
+    m_fd = static_cast<int>( syscall( __NR_io_uring_setup, m_options.entries, &params ) );
+    if( m_fd < 0 )
+        throw_errno( errno, "io_uring_setup" );
+
+    m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if( params.features & IORING_FEAT_SINGLE_MMAP )
+        m_sq_size = m_cq_size = std::max( m_sq_size, m_cq_size );
+
+    m_sq_ring = mmap( nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      m_fd, IORING_OFF_SQ_RING );
+    if( m_sq_ring == MAP_FAILED )
+        throw_errno( errno, "io_uring mmap" );
+
+    if( params.features & IORING_FEAT_SINGLE_MMAP )
+        m_cq_ring = m_sq_ring;
+    else
+    {
+        m_cq_ring = mmap( nullptr, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          m_fd, IORING_OFF_CQ_RING );
+        if( m_cq_ring == MAP_FAILED )
+            throw_errno( errno, "io_uring mmap" );
+    }
+
+    m_sqes = static_cast<io_uring_sqe *>(
+                 mmap( nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES ) );
+    if( m_sqes == MAP_FAILED )
+        throw_errno( errno, "io_uring mmap" );
+
+    char *sq = static_cast<char *>( m_sq_ring ),
+         *cq = static_cast<char *>( m_cq_ring );
+    m_sq_head    = reinterpret_cast<unsigned *>( sq + params.sq_off.head );
+    m_sq_tail    = reinterpret_cast<unsigned *>( sq + params.sq_off.tail );
+    m_sq_array   = reinterpret_cast<unsigned *>( sq + params.sq_off.array );
+    m_sq_mask    = *reinterpret_cast<unsigned *>( sq + params.sq_off.ring_mask );
+    m_sq_entries = params.sq_entries;
+    m_cq_head    = reinterpret_cast<unsigned *>( cq + params.cq_off.head );
+    m_cq_tail    = reinterpret_cast<unsigned *>( cq + params.cq_off.tail );
+    m_cq_mask    = *reinterpret_cast<unsigned *>( cq + params.cq_off.ring_mask );
+    m_cqes       = reinterpret_cast<io_uring_cqe *>( cq + params.cq_off.cqes );
+    m_sq_local   = m_sq_flushed = *m_sq_tail;
+
+    // Receive buffers, handed to the kernel through a ring of their own
+    m_buf_ring_size = m_options.buffers * sizeof(io_uring_buf);
+    m_buf_ring = static_cast<io_uring_buf *>(
+                     mmap( nullptr, m_buf_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) );
+    if( m_buf_ring == MAP_FAILED )
+        throw_errno( errno, "io_uring buffer ring" );
+
+    io_uring_buf_reg reg;
+    std::memset( &reg, 0, sizeof(reg) );
+    reg.ring_addr    = reinterpret_cast<std::uintptr_t>( m_buf_ring );
+    reg.ring_entries = m_options.buffers;
+    reg.bgid         = receive_group;
+    if( syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_PBUF_RING, &reg, 1 ) < 0 )
+        throw_errno( errno, "io_uring provided buffers" );
+
+    m_buffers.reset( new char[ m_options.buffers * m_options.buffer_size ] );
+    for( unsigned bid = 0; bid < m_options.buffers; ++bid )
+        recycle( bid );
+
+    // Completions wake the io_context through an eventfd
+    m_event = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if( m_event < 0 )
+        throw_errno( errno, "eventfd" );
+
+    if( syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_EVENTFD, &m_event, 1 ) < 0 )
+        throw_errno( errno, "io_uring eventfd" );
+
+    m_notify.assign( dup( m_event ) );
+    guard.done = true;
+}
+
+uring_service::~uring_service()
+{
+    boost::system::error_code ignored;
+    m_notify.close( ignored );
+    shutdown();
+}
+
+void uring_service::shutdown()
+{
+    // Closing the ring cancels what is left in the kernel
+    if( m_fd >= 0 )
+        close( m_fd );
+    if( m_event >= 0 )
+        close( m_event );
+    if( m_buf_ring != MAP_FAILED )
+        munmap( m_buf_ring, m_buf_ring_size );
+    if( m_sqes != MAP_FAILED )
+        munmap( m_sqes, m_sq_entries * sizeof(io_uring_sqe) );
+    if( m_cq_ring != MAP_FAILED && m_cq_ring != m_sq_ring )
+        munmap( m_cq_ring, m_cq_size );
+    if( m_sq_ring != MAP_FAILED )
+        munmap( m_sq_ring, m_sq_size );
+
+    m_fd      = m_event = -1;
+    m_sq_ring = m_cq_ring = MAP_FAILED;
+    m_sqes    = static_cast<io_uring_sqe *>( MAP_FAILED );
+    m_buf_ring = static_cast<io_uring_buf *>( MAP_FAILED );
+}
+
+uring_service::ptr uring_service::create( boost::asio::io_context &io, const uring_options &opts )
+{
+    return std::make_shared<uring_service>( io, opts );
+}
+
+uring_service::id_type uring_service::attach( int fd, uring_connection *conn )
+{
+    id_type id;
+    if( m_free.empty() )
+    {
+        id = static_cast<id_type>( m_channels.size() );
+        m_channels.push_back( channel() );
+        m_channels.back().generation = 0;
+    }
+    else
+    {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+
+    channel &ch = m_channels[id];
+    ch.conn      = conn;
+    ch.fd        = fd;
+    ch.receiving = ch.sending = ch.wanted = false;
+    ch.data      = nullptr;
+    ch.left      = ch.done = 0;
+    ++ch.generation;
+    return id;
+}
+
+void uring_service::detach( id_type id )
+{
+    channel &ch = m_channels[id];
+    ch.conn   = nullptr;
+    ch.wanted = false;
+
+    if( ch.receiving )
+        cancel( tag( id, ch.generation, op_receive ) );
+    if( ch.sending )
+        cancel( tag( id, ch.generation, op_send ) );
+
+    release( id );
+}
+
+void uring_service::receive( id_type id )
+{
+    channel &ch = m_channels[id];
+    ch.wanted = true;
+    if( !ch.receiving )
+        submit_receive( id );
+}
+
+void uring_service::stop_receive( id_type id )
+{
+    channel &ch = m_channels[id];
+    if( ch.wanted && ch.receiving )
+        cancel( tag( id, ch.generation, op_receive ) );
+
+    ch.wanted = false;
+}
+
+void uring_service::send( id_type id, const char *data, std::size_t size )
+{
+    channel &ch = m_channels[id];
+    ch.data = data;
+    ch.left = size;
+    ch.done = 0;
+    submit_send( id );
+}
+
+// Queued entries are only submitted by flush(), so a full queue flushes first
+io_uring_sqe *uring_service::next_sqe()
+{
+    if( m_sq_local - __atomic_load_n( m_sq_head, __ATOMIC_ACQUIRE ) >= m_sq_entries )
+        flush();
+
+    unsigned      index = m_sq_local++ & m_sq_mask;
+    io_uring_sqe *sqe   = &m_sqes[index];
+    std::memset( sqe, 0, sizeof(*sqe) );
+    m_sq_array[index] = index;
+
+    ++m_stats.submitted;
+    ++m_pending;
+    schedule_flush();
+    if( !m_waiting )
+        wait_completions();
+
+    return sqe;
+}
+
+void uring_service::submit_receive( id_type id )
+{
+    channel &ch = m_channels[id];
+    ch.receiving = true;
+
+    io_uring_sqe *sqe = next_sqe();
+    sqe->opcode    = IORING_OP_RECV;
+    sqe->fd        = ch.fd;
+    sqe->ioprio    = IORING_RECV_MULTISHOT;
+    sqe->flags     = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = receive_group;
+    sqe->user_data = tag( id, ch.generation, op_receive );
+}
+
+void uring_service::submit_send( id_type id )
+{
+    channel &ch = m_channels[id];
+    ch.sending = true;
+
+    io_uring_sqe *sqe = next_sqe();
+    sqe->opcode    = IORING_OP_SEND;
+    sqe->fd        = ch.fd;
+    sqe->addr      = reinterpret_cast<std::uintptr_t>( ch.data + ch.done );
+    sqe->len       = static_cast<std::uint32_t>( std::min<std::size_t>( ch.left, 0x7fffffff ) );
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = tag( id, ch.generation, op_send );
+}
+
+void uring_service::cancel( std::uint64_t target )
+{
+    io_uring_sqe *sqe = next_sqe();
+    sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+    sqe->fd        = -1;
+    sqe->addr      = target;
+    sqe->user_data = op_cancel;
+}
+
+// Everything queued while handling the current event goes in one system call
+void uring_service::schedule_flush()
+{
+    if( m_flush_posted )
+        return;
+
+    m_flush_posted = true;
+    boost::asio::post( m_io, std::bind( &uring_service::flush, shared_from_this() ) );
+}
+
+void uring_service::flush()
+{
+    m_flush_posted = false;
+    unsigned pending = m_sq_local - m_sq_flushed;
+    if( !pending )
+        return;
+
+    __atomic_store_n( m_sq_tail, m_sq_local, __ATOMIC_RELEASE );
+    while( pending )
+    {
+        long done = syscall( __NR_io_uring_enter, m_fd, pending, 0, 0, nullptr, 0 );
+        ++m_stats.enters;
+        if( done < 0 )
+        {
+            if( errno == EINTR )
+                continue;
+
+            // EAGAIN or EBUSY: the kernel is short of memory or completions,
+            // these are handled first and the rest goes out next time
+            schedule_flush();
+            break;
+        }
+        pending      -= static_cast<unsigned>( done );
+        m_sq_flushed += static_cast<unsigned>( done );
+    }
+}
+
+// Completions are only waited for while operations are in the kernel, so
+// that the io_context runs out of work like with the reactor
+void uring_service::wait_completions()
+{
+    // The wait holds the service, its handler may run after the last
+    // client let it go
+    ptr self = shared_from_this();
+    m_waiting = true;
+    m_notify.async_wait( boost::asio::posix::stream_descriptor::wait_read,
+                         [self]( const boost::system::error_code &ec )
+    {
+        self->m_waiting = false;
+        if( ec )
+            return;
+
+        std::uint64_t count;
+        if( read( self->m_event, &count, sizeof(count) ) < 0 && errno != EAGAIN )
+            return;
+
+        self->reap();
+        if( self->m_pending && !self->m_waiting )
+            self->wait_completions();
+    });
+}
+
+void uring_service::reap()
+{
+    unsigned head = *m_cq_head;
+    while( head != __atomic_load_n( m_cq_tail, __ATOMIC_ACQUIRE ) )
+    {
+        const io_uring_cqe &cqe = m_cqes[ head & m_cq_mask ];
+        std::uint64_t user_data = cqe.user_data;
+        int           res       = cqe.res;
+        unsigned      flags     = cqe.flags;
+
+        // The entry is given back before the connection may queue more
+        __atomic_store_n( m_cq_head, ++head, __ATOMIC_RELEASE );
+        ++m_stats.completions;
+        if( !( flags & IORING_CQE_F_MORE ) )
+            --m_pending;
+        complete( user_data, res, flags );
+    }
+}
+
+void uring_service::complete( std::uint64_t user_data, int res, unsigned flags )
+{
+    operation op = static_cast<operation>( user_data & 3 );
+    id_type   id = static_cast<id_type>( user_data >> 2 & 0x3fffffff );
+    if( op == op_cancel )
+        return;
+
+    const bool    buffer = ( flags & IORING_CQE_F_BUFFER ) != 0;
+    const unsigned bid   = flags >> IORING_CQE_BUFFER_SHIFT;
+    if( id >= m_channels.size() ||
+        m_channels[id].generation != static_cast<std::uint32_t>( user_data >> 32 ) )
+    {
+        if( buffer )
+            recycle( bid );
+        return;
+    }
+
+    if( op == op_send )
+    {
+        channel &ch = m_channels[id];
+        ch.sending = false;
+        if( !ch.conn )
+        {
+            release( id );
+            return;
+        }
+
+        boost::system::error_code ec;
+        if( res < 0 )
+            ec.assign( -res, boost::system::system_category() );
+        else
+        {
+            m_stats.sent += static_cast<std::uint64_t>( res );
+            ch.done += static_cast<std::size_t>( res );
+            ch.left -= static_cast<std::size_t>( res );
+            if( ch.left && res > 0 )
+            {
+                submit_send( id );
+                return;
+            }
+        }
+        ch.conn->uring_sent( ec, ch.done );
+        return;
+    }
+
+    // Multishot receive, it goes on while IORING_CQE_F_MORE is set
+    const std::uint32_t generation = m_channels[id].generation;
+    if( !( flags & IORING_CQE_F_MORE ) )
+        m_channels[id].receiving = false;
+
+    if( res > 0 )
+    {
+        m_stats.received += static_cast<std::uint64_t>( res );
+        if( m_channels[id].conn && buffer )
+            m_channels[id].conn->uring_received(
+                m_buffers.get() + bid * m_options.buffer_size, static_cast<std::size_t>( res ) );
+    }
+    if( buffer )
+        recycle( bid );
+
+    // The connection may have detached itself meanwhile, the slot may be reused
+    channel &ch = m_channels[id];
+    if( ch.generation != generation )
+        return;
+    if( !ch.conn )
+    {
+        release( id );
+        return;
+    }
+    if( ch.receiving )
+        return;
+
+    if( res == 0 || ( res < 0 && res != -ENOBUFS && res != -ECANCELED ) )
+    {
+        ch.wanted = false;
+        boost::system::error_code ec = res == 0
+            ? boost::system::error_code( boost::asio::error::eof )
+            : boost::system::error_code( -res, boost::system::system_category() );
+        ch.conn->uring_closed( ec );
+        return;
+    }
+
+    // Out of buffers, cancelled while wanted again, or ended by the kernel
+    if( ch.wanted )
+    {
+        if( res == -ENOBUFS )
+            ++m_stats.rearms;
+        submit_receive( id );
+    }
+}
+
+// The ring is indexed by hand: io_uring_buf_ring::bufs is misplaced by the
+// C++ expansion of the kernel's flexible array macro
+void uring_service::recycle( unsigned bid )
+{
+    io_uring_buf &buf = m_buf_ring[ m_buf_tail & ( m_options.buffers - 1 ) ];
+    buf.addr = reinterpret_cast<std::uintptr_t>( m_buffers.get() + bid * m_options.buffer_size );
+    buf.len  = static_cast<std::uint32_t>( m_options.buffer_size );
+    buf.bid  = static_cast<std::uint16_t>( bid );
+
+    __atomic_store_n( &m_buf_ring[0].resv, static_cast<std::uint16_t>( ++m_buf_tail ),
+                      __ATOMIC_RELEASE );
+}
+
+// The slot is reused once the kernel is done with it
+void uring_service::release( id_type id )
+{
+    channel &ch = m_channels[id];
+    if( ch.conn || ch.receiving || ch.sending )
+        return;
+
+    if( ch.fd < 0 )
+        return;
+
+    ch.fd = -1;
+    m_free.push_back( id );
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_URING_HPP
@@ -0,0 +1,142 @@
+/*
+    Name:        irc/impl/worker_pool.ipp
+    Purpose:     Thread pool running callbacks in order per key implementation
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_IMPL_WORKER_POOL_HPP
+#define IRC_IMPL_WORKER_POOL_HPP
+
+#include <algorithm>
+
+namespace irc {
+
+worker_pool::worker_pool( std::size_t threads )
+:   m_threads(threads ? threads : std::max( 1u, std::thread::hardware_concurrency() )),
+    m_pool(m_threads),
+    m_depth(0),
+    m_joining(false)
+{
+}
+
+worker_pool::~worker_pool()
+{
+    join();
+}
+
+void worker_pool::post( const std::string &key, std::function<void()> task )
+{
+    std::shared_ptr<serial_queue> queue;
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        queue_map::iterator it = m_queues.find( key );
+
+        // A joining pool stops once dry, only the queues it still runs are drained
+        if( m_joining && ( it == m_queues.end() || !it->second->running ) )
+            return;
+
+        std::shared_ptr<serial_queue> &slot = it != m_queues.end() ? it->second : m_queues[key];
+        if( !slot )
+            slot = std::make_shared<serial_queue>();
+
+        task_entry entry = { std::move( task ), clock::now() };
+        slot->tasks.push_back( std::move( entry ) );
+        ++slot->stats.depth;
+        ++m_depth;
+
+        if( slot->running )
+            return;
+
+        slot->running = true;
+        queue = slot;
+    }
+    boost::asio::post( m_pool, std::bind( &worker_pool::run, this, queue ) );
+}
+
+void worker_pool::run( std::shared_ptr<serial_queue> queue )
+{
+    task_entry entry;
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        entry = std::move( queue->tasks.front() );
+        queue->tasks.pop_front();
+    }
+
+    clock::time_point start  = clock::now();
+    bool              failed = false;
+    try
+    {
+        entry.task();
+    }
+    catch( ... )
+    {
+        failed = true;
+    }
+    clock::time_point end = clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        worker_key_stats &stats = queue->stats;
+        --stats.depth;
+        --m_depth;
+        ++stats.handled;
+        if( failed )
+            ++stats.failed;
+
+        stats.waited     += start - entry.queued;
+        stats.busy       += end - start;
+        stats.max_latency = std::max( stats.max_latency, end - entry.queued );
+
+        if( queue->tasks.empty() )
+        {
+            queue->running = false;
+            return;
+        }
+    }
+    // Behind the other keys' queues, rather than looping on this one
+    boost::asio::post( m_pool, std::bind( &worker_pool::run, this, queue ) );
+}
+
+worker_key_stats worker_pool::stats( const std::string &key ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    queue_map::const_iterator it = m_queues.find( key );
+    return it == m_queues.end() ? worker_key_stats() : it->second->stats;
+}
+
+std::size_t worker_pool::depth() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    return m_depth;
+}
+
+void worker_pool::clear_idle()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    for( queue_map::iterator it = m_queues.begin(); it != m_queues.end(); )
+    {
+        if( it->second->stats.depth == 0 )
+            it = m_queues.erase( it );
+        else
+            ++it;
+    }
+}
+
+void worker_pool::join()
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if( m_joining )
+            return;
+
+        m_joining = true;
+    }
+    // The queued tasks may still post to their keys, until the pool runs dry
+    m_pool.join();
+}
+
+} // namespace irc
+
+#endif // IRC_IMPL_WORKER_POOL_HPP
@@ -0,0 +1,264 @@
+/*
+    Name:        irc/isupport.hpp
+    Purpose:     Server features advertised by RPL_ISUPPORT (005)
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_ISUPPORT_HPP
+#define IRC_ISUPPORT_HPP
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <boost/utility/string_view.hpp>
+
+namespace irc {
+
+/** Nickname and channel name case folding rules, from CASEMAPPING. */
+enum class casemapping
+{
+    ascii,          /**< Only A-Z fold to a-z. */
+    rfc1459,        /**< As ascii, plus []\~ fold to {}|^, the default. */
+    strict_rfc1459  /**< As rfc1459, without ~ and ^. */
+};
+/**
+    Folds a character to lower case.
+    @param ch      The character to fold.
+    @param mapping The case mapping rules.
+    @return The folded character.
+*/
+inline char fold_case( char ch, casemapping mapping )
+{
+    if( ch >= 'A' && ch <= 'Z' )
+        return static_cast<char>( ch + 32 );
+
+    if( mapping != casemapping::ascii && ch >= '[' && ch <= ( mapping == casemapping::rfc1459
+                                                              ? '^' : ']' ) )
+        return static_cast<char>( ch + 32 );
+
+    return ch;
+}
+/**
+    Compares two nicknames or channel names, case insensitively.
+    @param lhs     The first name.
+    @param rhs     The second name.
+    @param mapping The case mapping rules.
+    @return @true if the names are equal, @false otherwise.
+*/
+inline bool iequals( boost::string_view lhs, boost::string_view rhs,
+                     casemapping mapping = casemapping::rfc1459 )
+{
+    if( lhs.size() != rhs.size() )
+        return false;
+
+    for( std::size_t i = 0; i < lhs.size(); ++i )
+        if( fold_case( lhs[i], mapping ) != fold_case( rhs[i], mapping ) )
+            return false;
+
+    return true;
+}
+
+/** Channel mode kinds, from CHANMODES and PREFIX. */
+enum class chanmode_type
+{
+    unknown, /**< Not advertised. */
+    list,    /**< Type A: a list, always takes a parameter (b, e, I). */
+    always,  /**< Type B: always takes a parameter (k). */
+    set,     /**< Type C: takes a parameter when set only (l). */
+    flag,    /**< Type D: never takes a parameter (n, t...). */
+    prefix   /**< A channel status, takes a nickname (o, v...). */
+};
+/**
+    @class isupport
+
+    The features a server advertises with RPL_ISUPPORT (005).
+
+    A client fills a table while the 005 replies arrive and publishes a
+    copy as an immutable snapshot after each of them, so it can be shared
+    and read without locks. Tokens not sent keep their RFC 2812 defaults,
+    the typed accessors are all constant time lookups.
+*/
+class isupport
+{
+public:
+/** Shared immutable table pointer */
+    typedef std::shared_ptr< const isupport > ptr;
+
+/** Constructor, sets the RFC 2812 defaults. */
+    isupport();
+/** @return The snapshot of the RFC 2812 defaults, shared by all the clients. */
+    static ptr defaults();
+/**
+    Returns the snapshot of a table, shared with the other tables published
+    with the same key while it is alive. Clients of the same network get
+    the same 005 replies, so they end up sharing one snapshot.
+    @param key   The 005 tokens parsed into table.
+    @param table The table, copied if no snapshot has that key.
+    @return The shared snapshot.
+*/
+    static ptr shared( const std::string &key, const isupport &table );
+/**
+    Parses the tokens of a RPL_ISUPPORT reply, without the leading nickname.
+    Parsing stops at the trailing ":are supported by this server".
+    A "-TOKEN" restores the default of TOKEN.
+    @param tokens The space separated tokens.
+*/
+    void parse( boost::string_view tokens );
+/**
+    Returns a raw token value.
+    @param name The token name, as CHANTYPES.
+    @return The unescaped token value, empty if not sent or without value.
+*/
+    boost::string_view get( const std::string &name ) const
+    {
+        std::unordered_map<std::string, std::string>::const_iterator it = m_tokens.find( name );
+        return it == m_tokens.end() ? boost::string_view() : boost::string_view( it->second );
+    }
+/**
+    Checks if a token was sent.
+    @param name The token name.
+    @return @true if the server sent the token, @false otherwise.
+*/
+    bool has( const std::string &name ) const { return m_tokens.count( name ) != 0; }
+/**
+    Checks if a target is a channel, from CHANTYPES.
+    A leading STATUSMSG prefix, as in "@#channel", is skipped.
+    @param target The target name.
+    @return @true if target is a channel name, @false otherwise.
+*/
+    bool is_channel( boost::string_view target ) const
+    {
+        if( !target.empty() && m_statusmsg[ static_cast<unsigned char>( target[0] ) ] )
+            target.remove_prefix(1);
+
+        return !target.empty() && m_chantype[ static_cast<unsigned char>( target[0] ) ];
+    }
+/**
+    Returns the kind of a channel mode, from CHANMODES and PREFIX.
+    @param mode The mode letter.
+    @return The mode kind.
+*/
+    chanmode_type mode_type( char mode ) const
+    {
+        return static_cast<chanmode_type>( m_modetype[ static_cast<unsigned char>( mode ) ] );
+    }
+/**
+    Returns the status symbol of a prefix mode, from PREFIX.
+    @param mode The mode letter, as 'o'.
+    @return The symbol, as '@', or 0 if mode is not a prefix.
+*/
+    char prefix_symbol( char mode ) const { return m_symbol[ static_cast<unsigned char>( mode ) ]; }
+/**
+    Returns the prefix mode of a status symbol, from PREFIX.
+    @param symbol The symbol, as '@'.
+    @return The mode letter, as 'o', or 0 if symbol is not a prefix.
+*/
+    char prefix_mode( char symbol ) const { return m_prefix[ static_cast<unsigned char>( symbol ) ]; }
+/**
+    Returns the maximum number of targets of a command, from TARGMAX
+    or MAXTARGETS. Without them, JOIN and PART are unlimited and the
+    other commands take one target.
+    @param command The uppercase command, as "PRIVMSG".
+    @return The targets limit, 0 if unlimited.
+*/
+    unsigned targmax( const std::string &command ) const;
+/**
+    Returns the maximum number of entries of a list mode, from MAXLIST.
+    @param mode The list mode letter, as 'b'.
+    @return The entries limit, 0 if unknown.
+*/
+    unsigned maxlist( char mode ) const { return m_maxlist[ static_cast<unsigned char>( mode ) ]; }
+/**
+    Returns the maximum number of joined channels of a type, from CHANLIMIT.
+    @param chantype The channel type, as '#'.
+    @return The channels limit, 0 if unlimited.
+*/
+    unsigned chanlimit( char chantype ) const
+    {
+        return m_chanlimit[ static_cast<unsigned char>( chantype ) ];
+    }
+
+/** @return CHANTYPES, "#&" by default. */
+    const std::string &chantypes()      const { return m_chantypes; }
+/** @return The PREFIX modes, "ov" by default. */
+    const std::string &prefix_modes()   const { return m_prefix_modes; }
+/** @return The PREFIX symbols, "@+" by default. */
+    const std::string &prefix_symbols() const { return m_prefix_symbols; }
+/** @return CHANMODES, "b,k,l,imnpst" by default. */
+    const std::string &chanmodes()      const { return m_chanmodes; }
+/** @return STATUSMSG, empty by default. */
+    const std::string &statusmsg()      const { return m_statusmsg_str; }
+/** @return ELIST, empty by default. */
+    const std::string &elist()          const { return m_elist; }
+/** @return NETWORK, empty by default. */
+    const std::string &network()        const { return m_network; }
+/** @return CASEMAPPING, rfc1459 by default. */
+    casemapping        casemap()        const { return m_casemapping; }
+/** @return MODES, the mode changes allowed per MODE line, 3 by default, 0 if unlimited. */
+    unsigned           modes()          const { return m_modes; }
+/** @return NICKLEN, 9 by default. */
+    unsigned           nicklen()        const { return m_nicklen; }
+/** @return CHANNELLEN, 50 by default. */
+    unsigned           channellen()     const { return m_channellen; }
+/** @return TOPICLEN, 0 if unknown. */
+    unsigned           topiclen()       const { return m_topiclen; }
+/** @return KICKLEN, 0 if unknown. */
+    unsigned           kicklen()        const { return m_kicklen; }
+/** @return AWAYLEN, 0 if unknown. */
+    unsigned           awaylen()        const { return m_awaylen; }
+/** @return LINELEN, the line length limit with CR-LF, 512 by default. */
+    unsigned           linelen()        const { return m_linelen; }
+/** @return The EXCEPTS mode letter, 0 if not supported. */
+    char               excepts()        const { return m_excepts; }
+/** @return The INVEX mode letter, 0 if not supported. */
+    char               invex()          const { return m_invex; }
+
+private:
+    void reset( const std::string &name );
+    void apply( const std::string &name, const std::string &value );
+    void build_modes();
+
+    std::unordered_map<std::string, std::string> m_tokens;
+    std::unordered_map<std::string, unsigned>    m_targmax;
+
+    std::string   m_chantypes,
+                  m_prefix_modes,
+                  m_prefix_symbols,
+                  m_chanmodes,
+                  m_statusmsg_str,
+                  m_elist,
+                  m_network;
+    casemapping   m_casemapping;
+    unsigned      m_modes,
+                  m_nicklen,
+                  m_channellen,
+                  m_topiclen,
+                  m_kicklen,
+                  m_awaylen,
+                  m_linelen,
+                  m_maxtargets;
+    bool          m_has_targmax;
+    char          m_excepts,
+                  m_invex;
+
+    bool          m_chantype[256],
+                  m_statusmsg[256];
+    unsigned char m_modetype[256];
+    char          m_symbol[256],
+                  m_prefix[256];
+    unsigned      m_maxlist[256],
+                  m_chanlimit[256];
+};
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/isupport.ipp"
+#endif
+
+#endif // IRC_ISUPPORT_HPP
@@ -0,0 +1,184 @@
+/*
+    Name:        irc/logger.hpp
+    Purpose:     Asynchronous batched chat logger
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_LOGGER_HPP
+#define IRC_LOGGER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <boost/lockfree/queue.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+
+namespace irc {
+
+/** What a logger does when its queue is full. */
+enum class overflow_policy
+{
+    drop, /**< Discard the record and count it, never wait. */
+    block /**< Sleep until the writer thread frees a slot. */
+};
+/** logger settings. */
+struct logger_options
+{
+    logger_options()
+    :   queue_size(8192),
+        batch_size(256),
+        max_file_size(64u << 20),
+        rotate_interval(0),
+        max_files(5),
+        flush_interval(200),
+        overflow(overflow_policy::drop)
+    {}
+
+    std::size_t               queue_size;      /**< Queue slots, at most 65534. */
+    std::size_t               batch_size;      /**< Records formatted per write. */
+    std::uint64_t             max_file_size;   /**< Rotate past this size, 0 disables. */
+    std::chrono::seconds      rotate_interval; /**< Rotate past this age, 0 disables. */
+    unsigned                  max_files;       /**< Rotated files kept (path.1 ...). */
+    std::chrono::milliseconds flush_interval;  /**< Writer wake up when idle. */
+    overflow_policy           overflow;        /**< Queue full policy. */
+};
+/**
+    @class logger
+
+    Chat logger sink running its file I/O on a background thread.
+
+    Records are copied into fixed size slots of a bounded lock-free queue,
+    the writer thread formats them in batches, writes each batch with a
+    single call and rotates the file by size and/or age.
+    With overflow_policy::drop, log() never waits, so it is safe to call
+    from the io_service thread inside the client callbacks:
+    @code
+    irc::logger::ptr log = irc::logger::create( "chat.log" );
+    c->on_channel_msg( std::bind( &irc::logger::log, log, ph::_1, ph::_2, ph::_3 ) );
+    @endcode
+*/
+class logger: boost::noncopyable
+{
+public:
+/** Shared logger pointer */
+    typedef std::shared_ptr< logger > ptr;
+/** Logger settings, see logger_options. */
+    typedef logger_options options;
+/**
+    Static constructor, starts the writer thread.
+    @param path File path to log to, it is opened in append mode.
+    @param opts Logger settings.
+    @return Shared pointer to a new logger object.
+    @throw boost::system::system_error If the file can not be opened.
+*/
+    static ptr create( const std::string &path, const options &opts = options() );
+
+/** Destructor, writes all queued records and joins the writer thread. */
+    ~logger();
+/**
+    Queues a chat line, the signature matches client::on_channel_msg().
+    Fields longer than a single IRC line are truncated.
+    @param sender The sender nickname.
+    @param target The channel or nickname the message was sent to.
+    @param text   The message text.
+    @return @true if the record was queued, @false if it was dropped.
+*/
+    bool log( const std::string &sender,
+              const std::string &target,
+              const std::string &text );
+/**
+    Stops accepting records, drains the queue and joins the writer thread.
+    The records of log() calls running meanwhile are written or refused,
+    never left in the queue.
+*/
+    void stop();
+/**
+    Returns the number of records dropped because the queue was full.
+    @return The dropped records count.
+*/
+    std::uint64_t dropped() const { return m_dropped.load( std::memory_order_relaxed ); }
+/**
+    Returns the number of records written to disk.
+    @return The written records count.
+*/
+    std::uint64_t written() const { return m_written.load( std::memory_order_relaxed ); }
+/**
+    Returns the number of file rotations done so far.
+    @return The rotations count.
+*/
+    std::uint64_t rotations() const { return m_rotations.load( std::memory_order_relaxed ); }
+/**
+    Returns the last file error, when a rotated file could not be opened
+    or a batch could not be written; the records lost are counted as dropped.
+    @return The error, success if none.
+*/
+    boost::system::error_code error() const;
+
+private:
+    static const std::size_t record_size = 512; /**< RFC 2812 maximum line length */
+
+    struct record
+    {
+        std::int64_t  stamp; // system_clock milliseconds
+        std::uint16_t sender_len,
+                      target_len,
+                      text_len;
+        char          data[record_size];
+    };
+
+    logger( const std::string &path, const options &opts );
+
+    logger() = delete;
+
+    void run();
+    bool push( const record &rec );
+    void leave();
+    std::size_t drain();
+    void format( const record &rec );
+    bool flush_batch();
+    void open();
+    void rotate();
+
+    typedef boost::lockfree::queue< record,
+                                    boost::lockfree::fixed_sized<true> > queue;
+
+    options                 m_options;
+    std::string             m_path;
+    queue                   m_queue;
+    std::thread             m_writer;
+    std::mutex              m_mutex;
+    std::condition_variable m_wakeup,     // The writer waits for records
+                            m_space;      // Blocked producers and stop() wait
+    std::atomic<bool>       m_sleeping,
+                            m_running;
+    std::atomic<unsigned>   m_producers;  // log() calls running
+    std::atomic<int>        m_error;      // errno of the last file failure
+    std::atomic<std::uint64_t> m_dropped,
+                               m_written,
+                               m_rotations;
+    // Writer thread only
+    std::ofstream           m_file;
+    std::string             m_batch;
+    std::uint64_t           m_file_size;
+    std::chrono::steady_clock::time_point m_opened;
+    std::int64_t            m_stamp_sec;
+    char                    m_stamp_str[24];
+};
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/logger.ipp"
+#endif
+
+#endif // IRC_LOGGER_HPP
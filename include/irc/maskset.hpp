@@ -0,0 +1,243 @@
+/*
+    Name:        irc/maskset.hpp
+    Purpose:     Compiled set of wildcard hostmasks, as bans, ignores and ACLs
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_MASKSET_HPP
+#define IRC_MASKSET_HPP
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+
+#include "irc/isupport.hpp"
+
+namespace irc {
+namespace detail {
+
+// '*' matches any sequence, '?' any character, both strings already folded
+inline bool glob_match( boost::string_view mask, boost::string_view name )
+{
+    std::size_t m = 0, n = 0,
+                star = boost::string_view::npos, retry = 0;
+
+    while( n < name.size() )
+    {
+        if( m < mask.size() && ( mask[m] == '?' || mask[m] == name[n] ) )
+        {
+            ++m;
+            ++n;
+        }
+        else if( m < mask.size() && mask[m] == '*' )
+        {
+            star  = m++;
+            retry = n;
+        }
+        else if( star != boost::string_view::npos )
+        {
+            m = star + 1;
+            n = ++retry;
+        }
+        else
+            return false;
+    }
+
+    while( m < mask.size() && mask[m] == '*' )
+        ++m;
+
+    return m == mask.size();
+}
+
+} // namespace detail
+/**
+    Matches a name against an IRC wildcard mask, case insensitively.
+    @param mask    The mask, '*' matches any sequence and '?' any character.
+    @param name    The name, as "nick!user@host".
+    @param mapping The case mapping rules.
+    @return @true if name matches mask, @false otherwise.
+*/
+bool match_mask( boost::string_view mask, boost::string_view name,
+                 casemapping mapping = casemapping::rfc1459 );
+/**
+    Completes a mask to the "nick!user@host" form, as servers do:
+    "host.name" and "*@host" become "*!*@host.name" and "*!*@host",
+    "nick" becomes "nick!*@*", missing parts become '*'.
+    @param mask The mask.
+    @return The complete mask.
+*/
+std::string normalize_mask( boost::string_view mask );
+/**
+    @class mask_set
+
+    A set of wildcard hostmasks compiled into an index, answering which
+    masks match a "nick!user@host" without testing each of them.
+
+    Each mask is filed in a character trie by its longest literal anchor:
+    the host suffix after the last wildcard, as ".example.net" in
+    "*!*@*.example.net", or else the literal prefix of its host, user or
+    nickname, as "192.168." in "*!*@192.168.*". A lookup walks the four
+    tries along the parts of the name and tests only the masks met on
+    the way. Masks without any literal anchor, as "*!*x*@*", are residual
+    masks tested for every lookup. A lookup thus costs about the length
+    of the name plus the masks sharing its anchors, instead of the size
+    of the list.
+
+    Masks are added and removed one by one, the index is updated in place.
+    Comparisons fold the case with the set's casemapping.
+    Not thread safe.
+*/
+class mask_set
+{
+public:
+/** Mask identifier, stable until the mask is removed. */
+    typedef std::uint32_t id_type;
+/**
+    Constructor.
+    @param mapping The case mapping rules, usually the server's CASEMAPPING.
+*/
+    explicit mask_set( casemapping mapping = casemapping::rfc1459 );
+/**
+    Adds a mask, completed with normalize_mask().
+    @param mask The mask.
+    @return The mask identifier.
+*/
+    id_type add( boost::string_view mask );
+/**
+    Removes a mask.
+    @param id The mask identifier.
+    @return @true if the mask was removed, @false if id is unknown.
+*/
+    bool remove( id_type id );
+/**
+    Returns a mask, as completed when added.
+    @param id The mask identifier.
+    @return The mask, empty if id is unknown.
+*/
+    const std::string &mask( id_type id ) const;
+/**
+    Calls a function for each mask matching a name.
+    @param name The name, as "nick!user@host".
+    @param func The function, as bool(id_type), returning @false to stop.
+    @return @true if the lookup was stopped by func, @false otherwise.
+*/
+    template< typename Func >
+    bool match( boost::string_view name, Func func ) const;
+/**
+    Returns the masks matching a name.
+    @param name The name, as "nick!user@host".
+    @return The identifiers of the matching masks.
+*/
+    std::vector<id_type> matches( boost::string_view name ) const;
+/**
+    Checks if any mask matches a name.
+    @param name The name, as "nick!user@host".
+    @return @true if a mask matches, @false otherwise.
+*/
+    bool any( boost::string_view name ) const;
+/**
+    Changes the case mapping, rebuilding the index.
+    @param mapping The new case mapping rules.
+*/
+    void mapping( casemapping mapping );
+/** @return The case mapping rules. */
+    casemapping mapping() const { return m_mapping; }
+/** @return The number of masks. */
+    std::size_t size() const { return m_size; }
+/** @return The number of masks tested on every lookup. */
+    std::size_t residual() const { return m_residual.size(); }
+/** Removes all the masks. */
+    void clear();
+
+private:
+    static const std::uint32_t npos = 0xffffffff;
+
+    // Tries roots in m_nodes, the host suffix trie is walked backwards
+    enum anchor { host_suffix, host_prefix, user_prefix, nick_prefix, anchors };
+
+    struct entry
+    {
+        std::string   mask,   // As added, completed
+                      folded; // Case folded, as matched
+        std::uint32_t node;   // Trie node, npos if residual
+        bool          used;
+    };
+
+    struct node
+    {
+        std::vector< std::pair<char, std::uint32_t> > children; // Sorted by char
+        std::vector< id_type >                        masks;
+    };
+
+    // The nickname, username and hostname of a name or mask
+    static void split( boost::string_view name, boost::string_view &nick,
+                       boost::string_view &user, boost::string_view &host );
+
+    void fold( boost::string_view text, std::string &out ) const;
+    void index( id_type id );
+    std::uint32_t child( std::uint32_t parent, char ch ) const;
+
+    template< typename Func >
+    bool walk( std::uint32_t current, boost::string_view part, bool backwards,
+               boost::string_view folded, Func &func ) const;
+
+    casemapping          m_mapping;
+    std::vector<entry>   m_entries;
+    std::vector<id_type> m_free,
+                         m_residual;
+    std::vector<node>    m_nodes;    // The first anchors nodes are the roots
+    std::size_t          m_size;
+    mutable std::string  m_scratch;  // Folded lookup name
+};
+
+template< typename Func >
+bool mask_set::match( boost::string_view name, Func func ) const
+{
+    fold( name, m_scratch );
+    boost::string_view folded( m_scratch );
+
+    boost::string_view nick, user, host;
+    split( folded, nick, user, host );
+
+    if( walk( host_suffix, host, true,  folded, func ) ||
+        walk( host_prefix, host, false, folded, func ) ||
+        walk( user_prefix, user, false, folded, func ) ||
+        walk( nick_prefix, nick, false, folded, func ) )
+        return true;
+
+    for( id_type id : m_residual )
+        if( detail::glob_match( m_entries[id].folded, folded ) && !func( id ) )
+            return true;
+
+    return false;
+}
+
+template< typename Func >
+bool mask_set::walk( std::uint32_t current, boost::string_view part, bool backwards,
+                     boost::string_view folded, Func &func ) const
+{
+    for( std::size_t i = 0; i < part.size(); ++i )
+    {
+        current = child( current, part[ backwards ? part.size() - 1 - i : i ] );
+        if( current == npos )
+            return false;
+
+        for( id_type id : m_nodes[current].masks )
+            if( detail::glob_match( m_entries[id].folded, folded ) && !func( id ) )
+                return true;
+    }
+    return false;
+}
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/maskset.ipp"
+#endif
+
+#endif // IRC_MASKSET_HPP
@@ -9,37 +9,151 @@
 #ifndef IRC_MESSAGE_HPP
 #define IRC_MESSAGE_HPP
 
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include <boost/utility/string_view.hpp>
+
+#include "irc/numeric.hpp"
+
 namespace irc {
 
+const int max_params = 15; /**< RFC 2812: maximum parameters allowed */
+/**
+    A parsed line, as views into the line: valid as long as it is.
+    The middle and trailing parameters are alike, the 15th one takes the
+    rest of the line.
+*/
+struct message_view
+{
+    message_view()
+    :   code(static_cast<reply_code>(0)),
+        param_count(0)
+    {}
+
+    boost::string_view tags;    /**< The IRCv3 tags, without '@', as sent. */
+    boost::string_view prefix;  /**< The prefix, without ':'. */
+    boost::string_view command; /**< The command or the 3 digits numeric. */
+    reply_code         code;    /**< The numeric, 0 for a command. */
+    boost::string_view params[max_params]; /**< The parameters, without ':'. */
+    std::size_t        param_count;        /**< The number of parameters. */
+/**
+    Returns a parameter.
+    @param index The parameter index.
+    @return The parameter, empty if there are less.
+*/
+    boost::string_view param( std::size_t index ) const
+    {
+        return index < param_count ? params[index] : boost::string_view();
+    }
+/**
+    Finds a tag.
+    @param key   The tag name, vendor prefix included.
+    @param value Receives the value, still escaped, empty if the tag has none.
+    @return @true if the tag is present.
+*/
+    bool tag( boost::string_view key, boost::string_view &value ) const;
+};
+/**
+    Parses a line, without CR-LF.
+    @param line The line.
+    @param msg  Receives the views into line.
+    @return @false if the line has no command.
+*/
+bool parse_message( boost::string_view line, message_view &msg );
+
+/**
+    @class message
+
+    An owning message, for when it must outlive the received line.
+    Its texts share one block, allocated once, and the parameters are
+    spans into it held in place, so a message converts from a
+    message_view with one allocation and moves without any.
+*/
 class message
 {
 public:
+/** Owning parameters list, as returned by params(). */
     typedef std::vector<std::string> params_type;
 
-    message(const std::string &sender,
-            const std::string &str_cmd,
-            reply_code         int_cmd,
-            params_type        params)
-    :   m_sender(sender),
-        m_command(str_cmd),
-        m_rpl_code(int_cmd),
-        m_params(params)
-    {}
+/** Constructor, an empty message. */
+    message();
+/**
+    Constructor, copies a parsed line.
+    @param view The parsed line.
+*/
+    explicit message( const message_view &view );
+/**
+    Constructor.
+    @param sender  The prefix.
+    @param str_cmd The command.
+    @param int_cmd The numeric, 0 for a command.
+    @param params  The parameters, the ones beyond max_params are dropped.
+*/
+    message( const std::string &sender,
+             const std::string &str_cmd,
+             reply_code         int_cmd,
+             const params_type &params );
+
+    message( const message &other );
+    message( message &&other ) noexcept;
+    message &operator=( const message &other );
+    message &operator=( message &&other ) noexcept;
 
-    std::string sender()  const { return m_sender; }
-    std::string command() const { return m_command; }
-    reply_code  code()    const { return m_code; }
-    params_type params()  const { return m_params; }
+/** @return The prefix, without ':'. */
+    boost::string_view sender()  const { return text( m_spans[prefix_span] ); }
+/** @return The command or the 3 digits numeric. */
+    boost::string_view command() const { return text( m_spans[command_span] ); }
+/** @return The IRCv3 tags, without '@'. */
+    boost::string_view tags()    const { return text( m_spans[tags_span] ); }
+/** @return The numeric, 0 for a command. */
+    reply_code         code()    const { return m_code; }
+/** @return The number of parameters. */
+    std::size_t param_count() const { return m_param_count; }
+/**
+    Returns a parameter.
+    @param index The parameter index.
+    @return The parameter, empty if there are less.
+*/
+    boost::string_view param( std::size_t index ) const
+    {
+        return index < m_param_count ? text( m_spans[first_param + index] ) : boost::string_view();
+    }
+/** @return A copy of the parameters, param() does not copy. */
+    params_type params() const;
+/** @return The message as a view, valid while the message is unchanged. */
+    message_view view() const;
 
 private:
-    std::string m_sender,
-                m_command;
-    reply_code  m_code;
-    params_type m_params;
+    struct span
+    {
+        std::uint32_t offset,
+                      size;
+    };
+
+    enum { tags_span, prefix_span, command_span, first_param, spans = first_param + max_params };
+
+    boost::string_view text( const span &s ) const
+    {
+        return boost::string_view( m_data.get() + s.offset, s.size );
+    }
+
+    void assign( const message_view &view );
+    void reset();
+
+    std::unique_ptr<char[]> m_data;
+    std::uint32_t           m_size;
+    span                    m_spans[spans];
+    reply_code              m_code;
+    std::uint8_t            m_param_count;
 };
 
 } // namespace irc
 
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/message.ipp"
+#endif
+
 #endif // IRC_MESSAGE_HPP
@@ -0,0 +1,77 @@
+/*
+    Name:        irc/packer.hpp
+    Purpose:     Multiple targets commands packed into the fewest lines
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_PACKER_HPP
+#define IRC_PACKER_HPP
+
+#include <string>
+#include <vector>
+
+#include "irc/isupport.hpp"
+
+namespace irc {
+
+/** A channel mode change, as +o nickname or -k key. */
+struct mode_change
+{
+    mode_change( bool s = true, char m = 0, const std::string &arg = std::string() )
+    :   set(s),
+        mode(m),
+        argument(arg)
+    {}
+
+    bool        set;      /**< @true to set the mode, @false to unset it. */
+    char        mode;     /**< The mode letter. */
+    std::string argument; /**< The mode parameter, empty if none. */
+};
+/**
+    Packs a command to many targets into the fewest lines, as
+    "PRIVMSG #a,#b,#c :text", each one within the server's LINELEN and
+    the command's TARGMAX. The lines are appended to out with CR-LF.
+    A target which does not fit a line on its own is sent alone.
+    @param out      The string to append the lines to.
+    @param command  The command, as PRIVMSG, NOTICE or PART.
+    @param targets  The targets, in order.
+    @param trailing The trailing parameter, sent as is after " :" if not empty.
+    @param limits   The server features.
+    @return The number of lines appended.
+*/
+std::size_t pack_targets( std::string &out, const std::string &command,
+                          const std::vector<std::string> &targets,
+                          const std::string &trailing, const isupport &limits );
+/**
+    Packs a JOIN of many channels, as "JOIN #a,#b,#c keya,keyb".
+    Keys are positional, so in every line the channels with a key come
+    first, keeping their keys aligned; the others follow.
+    @param out      The string to append the lines to.
+    @param channels The channels to join.
+    @param keys     The keys of the channels, by index, empty if none.
+    @param limits   The server features.
+    @return The number of lines appended.
+*/
+std::size_t pack_join( std::string &out, const std::vector<std::string> &channels,
+                       const std::vector<std::string> &keys, const isupport &limits );
+/**
+    Packs channel mode changes, as "MODE #a +oo-v nick1 nick2 nick3",
+    at most MODES changes with a parameter per line.
+    @param out     The string to append the lines to.
+    @param channel The channel.
+    @param changes The mode changes, in order.
+    @param limits  The server features.
+    @return The number of lines appended.
+*/
+std::size_t pack_mode( std::string &out, const std::string &channel,
+                       const std::vector<mode_change> &changes, const isupport &limits );
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/packer.ipp"
+#endif
+
+#endif // IRC_PACKER_HPP
@@ -0,0 +1,61 @@
+/*
+    Name:        irc/registration.hpp
+    Purpose:     Connection registration options and timings
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_REGISTRATION_HPP
+#define IRC_REGISTRATION_HPP
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace irc {
+
+/** How a client registers, all sent in the first write to the server. */
+struct registration_options
+{
+    registration_options()
+    :   negotiate(false),
+        nick_retries(3)
+    {}
+
+    std::string              password;      /**< PASS, unless connect() was given one. */
+    bool                     negotiate;     /**< Sends CAP LS 302 even with nothing to
+                                                 request. Negotiation holds the
+                                                 registration until CAP END, sent after
+                                                 the replies; capabilities or SASL
+                                                 imply it. */
+    std::vector<std::string> capabilities;  /**< Requested with CAP REQ, sasl is added
+                                                 when sasl_username is set. */
+    std::string              sasl_username, /**< SASL PLAIN account, empty for none. */
+                             sasl_password; /**< SASL PLAIN password. */
+    std::vector<std::string> alt_nicknames; /**< Tried in order on ERR_NICKNAMEINUSE. */
+    unsigned                 nick_retries;  /**< Then the nickname with up to nick_retries
+                                                 trailing underscores is tried. */
+};
+
+/** Timings and outcome of the last registration. */
+struct registration_stats
+{
+    typedef std::chrono::steady_clock clock;
+
+    registration_stats()
+    :   connected(clock::duration::zero()),
+        welcomed(clock::duration::zero()),
+        nick_retries(0),
+        sasl(false)
+    {}
+
+    clock::duration connected;    /**< From connect() to the TCP connection. */
+    clock::duration welcomed;     /**< From connect() to RPL_WELCOME, zero until then. */
+    unsigned        nick_retries; /**< Nicknames tried after the first one. */
+    bool            sasl;         /**< @true if SASL authentication succeeded. */
+};
+
+} // namespace irc
+
+#endif // IRC_REGISTRATION_HPP
@@ -0,0 +1,94 @@
+/*
+    Name:        irc/reply.hpp
+    Purpose:     Structured results of correlated IRC requests
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_REPLY_HPP
+#define IRC_REPLY_HPP
+
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+
+namespace irc {
+
+/** Channel user list, from RPL_NAMREPLY (353) up to RPL_ENDOFNAMES (366). */
+struct names_reply
+{
+    std::string              channel;   /**< The channel name. */
+    std::vector<std::string> nicknames; /**< Nicknames with their status prefix (@, +...). */
+};
+
+/** User details, from RPL_WHOISUSER (311) up to RPL_ENDOFWHOIS (318). */
+struct whois_reply
+{
+    whois_reply() : is_operator(false), idle(0), signon(0) {}
+
+    std::string              nickname,    /**< The nickname. */
+                             username,    /**< The user name (ident). */
+                             hostname,    /**< The user host. */
+                             realname,    /**< The real name. */
+                             server,      /**< The server the user is connected to. */
+                             server_info; /**< The server description. */
+    bool                     is_operator; /**< @true if RPL_WHOISOPERATOR (313) was sent. */
+    unsigned long            idle;        /**< Idle seconds, from RPL_WHOISIDLE (317). */
+    std::time_t              signon;      /**< Sign on time, 0 if not sent. */
+    std::vector<std::string> channels;    /**< Channels with their status prefix. */
+};
+
+/** A channel entry from RPL_LIST (322). */
+struct list_entry
+{
+    list_entry() : users(0) {}
+
+    std::string channel; /**< The channel name. */
+    unsigned    users;   /**< The visible users count. */
+    std::string topic;   /**< The channel topic. */
+};
+
+/** Channel list, from RPL_LISTSTART (321) up to RPL_LISTEND (323). */
+struct list_reply
+{
+    std::vector<list_entry> channels; /**< The listed channels. */
+};
+
+/**
+    A channel entry streamed from RPL_LIST (322).
+    The views point into the receive buffer and are only valid during the callback.
+*/
+struct list_entry_view
+{
+    boost::string_view channel; /**< The channel name. */
+    unsigned           users;   /**< The visible users count. */
+    boost::string_view topic;   /**< The channel topic. */
+};
+
+/** Filter of a streamed channel list. */
+struct list_filter
+{
+    list_filter() : min_users(0), max_users(0) {}
+
+    std::string channels;  /**< Comma separated channels to list, empty for all. */
+    unsigned    min_users, /**< Only list channels with more users than this, 0 for any. */
+                max_users; /**< Only list channels with less users than this, 0 for any. */
+};
+
+/** Channel modes, from RPL_CHANNELMODEIS (324) and RPL_CREATIONTIME (329). */
+struct mode_reply
+{
+    mode_reply() : created(0) {}
+
+    std::string              channel,   /**< The channel name. */
+                             modes;     /**< The mode letters, as "+ntk". */
+    std::vector<std::string> arguments; /**< The mode arguments, in order. */
+    std::time_t              created;   /**< Channel creation time, 0 if not sent. */
+};
+
+} // namespace irc
+
+#endif // IRC_REPLY_HPP
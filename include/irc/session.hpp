@@ -0,0 +1,246 @@
+/*
+    Name:        irc/session.hpp
+    Purpose:     Protocol state of a connection, without any I/O
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_SESSION_HPP
+#define IRC_SESSION_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include <boost/core/noncopyable.hpp>
+#include <boost/utility/string_view.hpp>
+
+#include "irc/message.hpp"
+#include "irc/registration.hpp"
+
+namespace irc {
+
+/** What session::next() found in the input. */
+enum class session_event
+{
+    none,     /**< No complete line is buffered. */
+    message,  /**< A message for the application. */
+    consumed  /**< A registration message already answered by the session:
+                   CAP, AUTHENTICATE, SASL replies or a nickname in use. */
+};
+/**
+    @class session
+
+    The protocol state of one connection, without any I/O: the bytes read
+    from the server go in, messages come out and the lines to send pile up
+    in an output buffer which the caller writes when it can. Time is only
+    taken from the arguments and the keepalive timer is a deadline to wait
+    for, so a session runs on any event loop, or on none at all.
+
+    The registration (PASS, CAP, SASL PLAIN, NICK and USER, nickname retries)
+    and the PINGs are answered by the session itself. The buffers come from
+    the process wide pool while they hold bytes, lines are parsed in place
+    and nothing is allocated per byte or per line. Not thread safe.
+*/
+class session : private boost::noncopyable
+{
+public:
+/** Clock of the deadlines */
+    typedef registration_stats::clock clock;
+
+/** Constructor. */
+    session();
+/**
+    Sets who registers on the next start().
+    @param nickname The nickname.
+    @param username The user name.
+    @param realname The real name.
+    @param password The server password, if empty the registration_options one.
+*/
+    void identity( const std::string &nickname, const std::string &username,
+                   const std::string &realname, const std::string &password = std::string() );
+/**
+    Sets how the next start() registers.
+    @param opts The registration options.
+*/
+    void registration( const registration_options &opts ) { m_options = opts; }
+/** @return The registration options. */
+    const registration_options &registration() const { return m_options; }
+/** @return The timings of the last registration. */
+    const registration_stats &stats() const { return m_stats; }
+/** @return The nickname, the one accepted by the server once registered. */
+    const std::string &nickname() const { return m_nickname; }
+/** @return The user name. */
+    const std::string &username() const { return m_username; }
+/** @return The real name. */
+    const std::string &realname() const { return m_realname; }
+/** @return @true once RPL_WELCOME was received. */
+    bool registered() const { return m_registered; }
+/**
+    Tells if a capability was acknowledged by the server.
+    @param name The capability name.
+    @return @true if enabled on this connection.
+*/
+    bool capability( boost::string_view name ) const;
+/**
+    Records when the connection was attempted, for the registration timings.
+    @param now The current time.
+*/
+    void connecting( clock::time_point now ) { m_connect_start = now; }
+/**
+    Starts a connection: the unread input and the registration state are
+    reset and the registration lines are queued before any other output.
+    @param now The current time.
+*/
+    void start( clock::time_point now );
+/** Ends a connection, dropping the unread input. The output is kept. */
+    void stop();
+/**
+    Returns room at the end of the input buffer for the next read,
+    to be followed by commit().
+    @param limit Bytes the input may hold, 0 for no limit.
+    @param size  Receives the room size, which may be 0 when limited.
+    @return Where to read.
+*/
+    char *prepare( std::size_t limit, std::size_t &size );
+/**
+    Adds to the input the bytes read after prepare().
+    @param bytes The bytes read.
+    @param now   The current time.
+*/
+    void commit( std::size_t bytes, clock::time_point now );
+/**
+    Copies bytes to the input.
+    @param bytes The bytes received.
+    @param now   The current time.
+*/
+    void receive( boost::string_view bytes, clock::time_point now );
+/** @return @true if a complete line is buffered. */
+    bool ready() const { return m_input.find( '\n', m_read_pos ) != std::string::npos; }
+/** @return The unread input size. */
+    std::size_t buffered() const { return m_input.size() - m_read_pos; }
+/**
+    Parses the next complete line, empty and invalid lines are skipped.
+    PINGs are answered and still returned, registration messages are
+    answered and returned as consumed.
+    @param msg Receives the message, which points into the input buffer
+               until the next prepare(), receive() or stop().
+    @return What was found.
+*/
+    session_event next( message_view &msg );
+/** @return The raw line of the last message, valid as the message. */
+    boost::string_view line() const { return m_line; }
+/**
+    Answers and drops the PINGs among the unread lines, leaving the other
+    lines in place: a reader paused by flow control still keeps the
+    connection alive.
+    @return The PINGs answered.
+*/
+    std::size_t skim();
+/**
+    Queues a line, CR-LF is appended.
+    @param line The line.
+*/
+    void send( boost::string_view line );
+/**
+    Queues lines already terminated by CR-LF.
+    @param lines The lines.
+*/
+    void send_lines( boost::string_view lines );
+/** @return @true if there are bytes to write. */
+    bool has_output() const { return !m_output.empty(); }
+/** @return The bytes to write, until the next send() or take_output(). */
+    boost::string_view output() const { return m_output; }
+/** Drops the bytes to write, as a lost connection does not send them to the next one. */
+    void discard_output();
+/**
+    Moves the bytes to write into a buffer, which gives its capacity to
+    the output in exchange: two buffers take turns without copies.
+    @param flight Receives the bytes, cleared first.
+*/
+    void take_output( std::string &flight );
+/** Gives the emptied buffers back to the pool. */
+    void shrink();
+/**
+    Sets the keepalive timer: after interval without input a PING is sent,
+    after timeout more without input the connection has timed out.
+    @param interval The idle time before a PING, zero to disable.
+    @param timeout  The time allowed to answer, interval if zero.
+*/
+    void keepalive( clock::duration interval, clock::duration timeout = clock::duration::zero() );
+/** @return When tick() has something to do, time_point::max() for never. */
+    clock::time_point deadline() const;
+/**
+    Runs the keepalive timer, to be called at the deadline.
+    @param now The current time.
+*/
+    void tick( clock::time_point now );
+/** @return @true if the server did not answer the keepalive PING in time. */
+    bool timed_out() const { return m_timed_out; }
+
+private:
+    void compact();
+    void pong( boost::string_view token );
+    std::string registration_lines();
+
+    // Returns true when the message was consumed by the registration
+    bool handle_registration( const message_view &msg );
+    void end_negotiation();
+    // Plain clients register as before CAP, without waiting for CAP END
+    bool negotiating() const
+    {
+        return m_options.negotiate || !m_options.capabilities.empty() ||
+               !m_options.sasl_username.empty();
+    }
+    void send_sasl_plain();
+    bool retry_nickname();
+
+    template< typename Func >
+    static void for_each_word( boost::string_view list, Func func )
+    {
+        while( !list.empty() )
+        {
+            std::size_t space = list.find(' ');
+            func( list.substr( 0, space ) );
+            list.remove_prefix( space == boost::string_view::npos ? list.size() : space + 1 );
+        }
+    }
+
+    std::string          m_input,    // Pooled, unread bytes start at m_read_pos
+                         m_output;   // Pooled
+    std::size_t          m_read_pos,
+                         m_skim_pos, // Lines before it have no PING
+                         m_prepared; // Input size before the last prepare()
+    boost::string_view   m_line;
+
+    registration_options m_options;
+    registration_stats   m_stats;
+    std::string          m_nickname,
+                         m_username,
+                         m_realname,
+                         m_password,
+                         m_first_nick,
+                         m_capabilities; // Acknowledged, space terminated
+    std::size_t          m_cap_pending,  // CAP REQ not answered
+                         m_nick_tries;
+    bool                 m_started,
+                         m_registered,
+                         m_sasl_active,
+                         m_ping_sent,
+                         m_timed_out;
+
+    clock::time_point    m_connect_start,
+                         m_last_input,
+                         m_ping_at;
+    clock::duration      m_interval,
+                         m_timeout;
+};
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/session.ipp"
+#endif
+
+#endif // IRC_SESSION_HPP
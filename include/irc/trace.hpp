@@ -0,0 +1,185 @@
+/*
+    Name:        irc/trace.hpp
+    Purpose:     Binary low-overhead trace ring buffer
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_TRACE_HPP
+#define IRC_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+
+namespace irc {
+
+/** Trace event types. */
+enum class trace_event : std::uint8_t
+{
+    line_received   = 0, /**< A line was read, arg is its length. */
+    command_parsed  = 1, /**< A command was parsed, code is the numeric or 0. */
+    callback_enter  = 2, /**< An user callback is called, code is a trace_handler. */
+    callback_exit   = 3, /**< An user callback returned, code is a trace_handler. */
+    write_issued    = 4, /**< An async write was started, arg is its size. */
+    write_completed = 5, /**< An async write completed, code is the error value. */
+    read_paused     = 6, /**< Flow control paused reading, arg is the units held. */
+    read_resumed    = 7  /**< Flow control resumed reading, arg is the pause in ms. */
+};
+
+/** User callbacks identifiers for callback_enter and callback_exit events. */
+enum class trace_handler : std::uint16_t
+{
+    unknown        = 0,
+    invite         = 1,
+    channel_notice = 2,
+    private_notice = 3,
+    channel_msg    = 4,
+    private_msg    = 5,
+    action         = 6,
+    dcc_request    = 7,
+    numeric        = 8,
+    connected      = 9,
+    disconnected   = 10,
+    version        = 11,
+    list_entry     = 12,
+    list_end       = 13,
+    ctcp           = 14,
+    trigger        = 15,
+    subscriber     = 16,
+    message        = 17
+};
+/**
+    A fixed size trace record, 64 bytes.
+*/
+struct trace_record
+{
+    std::uint64_t stamp; /**< steady_clock nanoseconds. */
+    std::uint32_t arg;   /**< Event argument, usually a size. */
+    std::uint16_t code;  /**< Event code, a numeric, handler or error value. */
+    std::uint8_t  type;  /**< A trace_event value. */
+    std::uint8_t  size;  /**< Used bytes of data. */
+    char          data[48]; /**< Truncated payload, not null terminated. */
+};
+/**
+    @class trace_ring
+
+    Fixed size ring of trace records.
+
+    There is a single writer, the io_service thread owning the client,
+    recording never blocks nor allocates and overwrites the oldest records.
+    Any thread can take a snapshot(): slots being overwritten while copied
+    are detected through their sequence number and skipped.
+*/
+class trace_ring: boost::noncopyable
+{
+public:
+/** Shared trace ring pointer */
+    typedef std::shared_ptr< trace_ring > ptr;
+/**
+    Constructor.
+    @param capacity Number of records, rounded up to a power of two.
+*/
+    explicit trace_ring( std::size_t capacity = 4096 );
+/**
+    Enables or disables recording.
+    @param enable @true to record events, @false to ignore them.
+*/
+    void enable( bool enable ) { m_enabled.store( enable, std::memory_order_relaxed ); }
+/**
+    Returns the recording state.
+    @return @true if recording, @false otherwise.
+*/
+    bool enabled() const { return m_enabled.load( std::memory_order_relaxed ); }
+/**
+    Records an event, to be called by the ring's writer thread only.
+    @param type The event type.
+    @param code The event code.
+    @param arg  The event argument.
+    @param data Optional payload, truncated to trace_record::data size.
+    @param size The payload size.
+*/
+    void record( trace_event type, std::uint16_t code = 0, std::uint32_t arg = 0,
+                 const char *data = nullptr, std::size_t size = 0 )
+    {
+        std::uint64_t head = m_head.load( std::memory_order_relaxed );
+        slot &s = m_slots[ head & m_mask ];
+
+        s.seq.store( 0, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        s.rec.stamp = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count() );
+        s.rec.arg  = arg;
+        s.rec.code = code;
+        s.rec.type = static_cast<std::uint8_t>( type );
+        s.rec.size = static_cast<std::uint8_t>( size < sizeof(s.rec.data)
+                                                ? size : sizeof(s.rec.data) );
+        if( s.rec.size )
+            std::memcpy( s.rec.data, data, s.rec.size );
+
+        s.seq.store( head + 1, std::memory_order_release );
+        m_head.store( head + 1, std::memory_order_release );
+    }
+/**
+    Copies the recorded events, oldest first.
+    @return The recorded events.
+*/
+    std::vector<trace_record> snapshot() const;
+/**
+    Returns the total number of recorded events, including overwritten ones.
+    @return The recorded events count.
+*/
+    std::uint64_t count() const { return m_head.load( std::memory_order_acquire ); }
+/**
+    Writes a snapshot in binary form, to be decoded later by load().
+    @param out The stream to write to.
+*/
+    void save( std::ostream &out ) const;
+/**
+    Reads records written by save().
+    @param in The stream to read from.
+    @return The loaded records, empty if the stream is not a trace.
+*/
+    static std::vector<trace_record> load( std::istream &in );
+/**
+    Writes records as human readable text, one per line.
+    @param out     The stream to write to.
+    @param records The records to decode.
+*/
+    static void dump_text( std::ostream &out, const std::vector<trace_record> &records );
+/**
+    Writes records in Chrome trace event JSON format (chrome://tracing, Perfetto).
+    @param out     The stream to write to.
+    @param records The records to decode.
+*/
+    static void dump_chrome( std::ostream &out, const std::vector<trace_record> &records );
+
+private:
+    struct slot
+    {
+        std::atomic<std::uint64_t> seq; // index + 1 when complete, 0 while written
+        trace_record               rec;
+    };
+
+    std::unique_ptr<slot[]>    m_slots;
+    std::uint64_t              m_mask;
+    std::atomic<std::uint64_t> m_head;
+    std::atomic<bool>          m_enabled;
+};
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/trace.ipp"
+#endif
+
+#endif // IRC_TRACE_HPP
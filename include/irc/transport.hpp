@@ -0,0 +1,518 @@
+/*
+    Name:        irc/transport.hpp
+    Purpose:     Byte streams a client can talk to a server over
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_TRANSPORT_HPP
+#define IRC_TRANSPORT_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/local/stream_protocol.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+#include <boost/utility/string_view.hpp>
+#include <boost/variant2/variant.hpp>
+#ifdef IRC_CLIENT_HAS_SSL
+    #include <boost/asio/ssl.hpp>
+#endif
+
+namespace irc {
+
+/** Completion of a transport connection, with the error if any. */
+typedef std::function<void(const boost::system::error_code &)> connect_handler;
+
+namespace detail {
+
+// What the stream socket transports share, the transport concept being:
+//  async_connect( host, port, handler )  Connects, the meaning of host and port is its own
+//  async_wait_read( handler )            Waits until read_some() has something to say
+//  read_some( data, size, ec )           Reads without blocking, would_block if nothing
+//  async_write( data, size, handler )    Writes all the bytes
+//  close()                               Closes, a pending wait completes with an error
+//  native_handle()                       The descriptor for io_uring, -1 if none
+//  non_blocking( mode )                  Sets how the descriptor is used, see below
+//  local_address( ec )                   The local IP address, for DCC
+template< typename Socket >
+class socket_transport
+{
+public:
+    explicit socket_transport( boost::asio::io_context &io ) : m_socket(io) {}
+
+    template< typename Handler >
+    void async_wait_read( Handler &&handler )
+    {
+        m_socket.async_wait( Socket::wait_read, std::forward<Handler>( handler ) );
+    }
+
+    std::size_t read_some( char *data, std::size_t size, boost::system::error_code &ec )
+    {
+        return m_socket.read_some( boost::asio::buffer( data, size ), ec );
+    }
+
+    template< typename Handler >
+    void async_write( const char *data, std::size_t size, Handler &&handler )
+    {
+        boost::asio::async_write( m_socket, boost::asio::buffer( data, size ),
+                                  std::forward<Handler>( handler ) );
+    }
+
+    void close()
+    {
+        boost::system::error_code ignored;
+        m_socket.close( ignored );
+    }
+
+    int native_handle() { return m_socket.is_open() ? m_socket.native_handle() : -1; }
+
+    // Reads fail with would_block instead of waiting, unless an io_uring
+    // waits for the descriptor itself, which then blocks
+    void non_blocking( bool mode )
+    {
+        boost::system::error_code ignored;
+        if( mode )
+            m_socket.non_blocking( true, ignored );
+        else
+            m_socket.native_non_blocking( false, ignored );
+    }
+
+    Socket &socket() { return m_socket; }
+
+protected:
+    Socket m_socket;
+};
+
+} // namespace detail
+
+/** Plain TCP connections, the hostname is resolved and each address is tried. */
+class tcp_transport : public detail::socket_transport< boost::asio::ip::tcp::socket >
+{
+public:
+/**
+    Constructor.
+    @param io The io_context of the client.
+*/
+    explicit tcp_transport( boost::asio::io_context &io ) : socket_transport(io) {}
+
+/** @cond */
+    void async_connect( const std::string &host, const std::string &port,
+                        connect_handler handler );
+
+    boost::asio::ip::address local_address( boost::system::error_code &ec ) const
+    {
+        return m_socket.local_endpoint( ec ).address();
+    }
+/** @endcond */
+};
+
+/** Unix domain stream sockets, as local bouncers listen on: the hostname is the socket path. */
+class unix_transport
+    : public detail::socket_transport< boost::asio::local::stream_protocol::socket >
+{
+public:
+/**
+    Constructor.
+    @param io The io_context of the client.
+*/
+    explicit unix_transport( boost::asio::io_context &io ) : socket_transport(io) {}
+
+/** @cond */
+    void async_connect( const std::string &path, const std::string &port,
+                        connect_handler handler );
+
+    boost::asio::ip::address local_address( boost::system::error_code &ec ) const
+    {
+        ec = boost::asio::error::operation_not_supported;
+        return boost::asio::ip::address();
+    }
+/** @endcond */
+};
+/**
+    @class memory_pipe
+
+    An in-process connection, without any socket: the client end is given
+    to a client through a pipe_transport and the server end is driven by
+    the application, which writes the server lines and reads the client
+    ones. Everything happens on the io_context thread, in order, so a run
+    over a pipe is repeatable, as benchmarks and tests need.
+
+    Each connect() of the client opens the pipe again, emptied.
+*/
+class memory_pipe : public std::enable_shared_from_this< memory_pipe >
+                  , private boost::noncopyable
+{
+public:
+/** Shared pipe pointer */
+    typedef std::shared_ptr< memory_pipe > ptr;
+
+/**
+    Constructor.
+    @param io The io_context of the client.
+*/
+    explicit memory_pipe( boost::asio::io_context &io );
+/**
+    Static constructor.
+    @param io The io_context of the client.
+    @return Shared pointer to a new pipe.
+*/
+    static ptr create( boost::asio::io_context &io );
+/**
+    Sends bytes to the client.
+    @param bytes The bytes.
+*/
+    void write( boost::string_view bytes );
+/**
+    Takes the bytes sent by the client.
+    @param bytes Receives them, appended.
+    @return The byte count.
+*/
+    std::size_t read( std::string &bytes );
+/**
+    Sets the function called when the client sent bytes.
+    @param func The function, called on the io_context thread.
+*/
+    void on_receive( std::function<void()> func ) { m_on_receive = func; }
+/** Closes the connection, the client reads the end of file after the bytes written. */
+    void close();
+/** @return @true while the client is connected. */
+    bool is_open() const { return m_open; }
+
+private:
+    friend class pipe_transport;
+
+    void wake( const boost::system::error_code &ec );
+
+    boost::asio::io_context &m_io;
+    std::string              m_to_client,
+                             m_to_server;
+    std::size_t              m_read_pos;  // Bytes of m_to_client read by the client
+    connect_handler          m_waiter;    // The client waiting for bytes
+    std::function<void()>    m_on_receive;
+    bool                     m_open;
+};
+
+/** The client end of a memory_pipe: the hostname and the port are not used. */
+class pipe_transport
+{
+public:
+/**
+    Constructor.
+    @param pipe The pipe.
+*/
+    explicit pipe_transport( memory_pipe::ptr pipe ) : m_pipe(pipe) {}
+
+/** @cond */
+    void async_connect( const std::string &host, const std::string &port,
+                        connect_handler handler );
+
+    void async_wait_read( connect_handler handler );
+
+    std::size_t read_some( char *data, std::size_t size, boost::system::error_code &ec );
+
+    template< typename Handler >
+    void async_write( const char *data, std::size_t size, Handler &&handler )
+    {
+        boost::system::error_code ec;
+        if( m_pipe->m_open )
+            m_pipe->m_to_server.append( data, size );
+        else
+            ec = boost::asio::error::not_connected;
+
+        boost::asio::post( m_pipe->m_io, std::bind( std::forward<Handler>( handler ), ec,
+                                                    ec ? 0 : size ) );
+        if( !ec && m_pipe->m_on_receive )
+            boost::asio::post( m_pipe->m_io, m_pipe->m_on_receive );
+    }
+
+    void close();
+
+    int native_handle() { return -1; }
+
+    void non_blocking( bool ) {}
+
+    boost::asio::ip::address local_address( boost::system::error_code &ec ) const
+    {
+        ec = boost::asio::error::operation_not_supported;
+        return boost::asio::ip::address();
+    }
+/** @endcond */
+
+private:
+    memory_pipe::ptr m_pipe;
+};
+
+#ifdef IRC_CLIENT_HAS_SSL
+/**
+    TLS over TCP, with the server name sent (SNI) and checked against the
+    certificate when the context verifies peers. The decrypted bytes wait
+    in a 4 KB buffer, held while a read is pending.
+
+    Needs building with IRC_CLIENT_HAS_SSL and linking with OpenSSL.
+*/
+class tls_transport
+{
+public:
+/**
+    Constructor.
+    @param io      The io_context of the client.
+    @param context The TLS settings, kept by the caller while the transport is used.
+*/
+    tls_transport( boost::asio::io_context &io, boost::asio::ssl::context &context )
+    :   m_io(&io), m_context(&context)
+    {}
+
+/** @cond */
+    void async_connect( const std::string &host, const std::string &port,
+                        connect_handler handler );
+
+    // A read is made into the buffer, read_some() copies from it
+    template< typename Handler >
+    void async_wait_read( Handler &&handler )
+    {
+        if( m_state && m_state->begin < m_state->end )
+        {
+            boost::asio::post( *m_io, std::bind( std::forward<Handler>( handler ),
+                                                 boost::system::error_code() ) );
+            return;
+        }
+        if( !m_state )
+        {
+            boost::asio::post( *m_io, std::bind( std::forward<Handler>( handler ),
+                                                 boost::asio::error::not_connected ) );
+            return;
+        }
+
+        std::shared_ptr<state> s = m_state;
+        if( !s->buffer )
+            s->buffer.reset( new char[ buffer_size ] );
+
+        typename std::decay<Handler>::type h( std::forward<Handler>( handler ) );
+        s->stream.async_read_some( boost::asio::buffer( s->buffer.get(), buffer_size ),
+            [s, h]( const boost::system::error_code &ec, std::size_t bytes ) mutable
+            {
+                s->begin = 0;
+                s->end   = bytes;
+                h( ec );
+            });
+    }
+
+    std::size_t read_some( char *data, std::size_t size, boost::system::error_code &ec );
+
+    template< typename Handler >
+    void async_write( const char *data, std::size_t size, Handler &&handler )
+    {
+        std::shared_ptr<state> s = m_state;
+        typename std::decay<Handler>::type h( std::forward<Handler>( handler ) );
+        boost::asio::async_write( s->stream, boost::asio::buffer( data, size ),
+            [s, h]( const boost::system::error_code &ec, std::size_t bytes ) mutable
+            {
+                h( ec, bytes );
+            });
+    }
+
+    void close();
+
+    int native_handle() { return -1; }
+
+    void non_blocking( bool ) {}
+
+    boost::asio::ip::address local_address( boost::system::error_code &ec ) const;
+/** @endcond */
+
+private:
+    static const std::size_t buffer_size = 4096;
+
+    // Shared with the pending operations, a new connection gets a new stream
+    struct state
+    {
+        state( boost::asio::io_context &io, boost::asio::ssl::context &context )
+        :   stream(io, context), begin(0), end(0)
+        {}
+
+        boost::asio::ssl::stream< boost::asio::ip::tcp::socket > stream;
+        std::unique_ptr<char[]> buffer;
+        std::size_t             begin,
+                                end;
+    };
+
+    boost::asio::io_context   *m_io;
+    boost::asio::ssl::context *m_context;
+    std::shared_ptr<state>     m_state;
+};
+#endif
+/**
+    @class transport
+
+    The byte stream of a client, one of the transports above, chosen when
+    the client is created. The set is closed, a new transport is added to
+    this class. Every call is a switch at run time on the type held,
+    followed by a direct call to it: there is no virtual call and nothing
+    is allocated.
+*/
+class transport
+{
+public:
+/**
+    Constructor, a TCP transport.
+    @param io The io_context of the client.
+*/
+    explicit transport( boost::asio::io_context &io )
+    :   m_impl( boost::variant2::in_place_type_t<tcp_transport>(), io )
+    {}
+/**
+    Constructors, from any transport.
+    @param t The transport.
+*/
+    transport( tcp_transport  t ) : m_impl( std::move( t ) ) {}
+    transport( unix_transport t ) : m_impl( std::move( t ) ) {}
+    transport( pipe_transport t ) : m_impl( std::move( t ) ) {}
+#ifdef IRC_CLIENT_HAS_SSL
+    transport( tls_transport  t ) : m_impl( std::move( t ) ) {}
+#endif
+
+/** @cond */
+    void async_connect( const std::string &host, const std::string &port,
+                        connect_handler handler )
+    {
+        connect_op op = { host, port, handler };
+        boost::variant2::visit( op, m_impl );
+    }
+
+    template< typename Handler >
+    void async_wait_read( Handler &&handler )
+    {
+        wait_op< typename std::decay<Handler>::type > op = { std::forward<Handler>( handler ) };
+        boost::variant2::visit( op, m_impl );
+    }
+
+    std::size_t read_some( char *data, std::size_t size, boost::system::error_code &ec )
+    {
+        read_op op = { data, size, ec };
+        return boost::variant2::visit( op, m_impl );
+    }
+
+    template< typename Handler >
+    void async_write( const char *data, std::size_t size, Handler &&handler )
+    {
+        write_op< typename std::decay<Handler>::type > op = { data, size,
+                                                              std::forward<Handler>( handler ) };
+        boost::variant2::visit( op, m_impl );
+    }
+
+    void close() { boost::variant2::visit( close_op(), m_impl ); }
+
+    int native_handle() { return boost::variant2::visit( handle_op(), m_impl ); }
+
+    void non_blocking( bool mode )
+    {
+        blocking_op op = { mode };
+        boost::variant2::visit( op, m_impl );
+    }
+
+    boost::asio::ip::address local_address( boost::system::error_code &ec )
+    {
+        address_op op = { ec };
+        return boost::variant2::visit( op, m_impl );
+    }
+/** @endcond */
+
+private:
+    struct connect_op
+    {
+        const std::string &host,
+                          &port;
+        connect_handler   &handler;
+
+        template< typename T > void operator()( T &t ) const
+        {
+            t.async_connect( host, port, std::move( handler ) );
+        }
+    };
+
+    template< typename Handler >
+    struct wait_op
+    {
+        Handler handler;
+
+        template< typename T > void operator()( T &t )
+        {
+            t.async_wait_read( std::move( handler ) );
+        }
+    };
+
+    struct read_op
+    {
+        char                      *data;
+        std::size_t                size;
+        boost::system::error_code &ec;
+
+        template< typename T > std::size_t operator()( T &t ) const
+        {
+            return t.read_some( data, size, ec );
+        }
+    };
+
+    template< typename Handler >
+    struct write_op
+    {
+        const char *data;
+        std::size_t size;
+        Handler     handler;
+
+        template< typename T > void operator()( T &t )
+        {
+            t.async_write( data, size, std::move( handler ) );
+        }
+    };
+
+    struct close_op
+    {
+        template< typename T > void operator()( T &t ) const { t.close(); }
+    };
+
+    struct handle_op
+    {
+        template< typename T > int operator()( T &t ) const { return t.native_handle(); }
+    };
+
+    struct blocking_op
+    {
+        bool mode;
+
+        template< typename T > void operator()( T &t ) const { t.non_blocking( mode ); }
+    };
+
+    struct address_op
+    {
+        boost::system::error_code &ec;
+
+        template< typename T > boost::asio::ip::address operator()( T &t ) const
+        {
+            return t.local_address( ec );
+        }
+    };
+
+#ifdef IRC_CLIENT_HAS_SSL
+    boost::variant2::variant< tcp_transport, unix_transport, pipe_transport,
+                              tls_transport > m_impl;
+#else
+    boost::variant2::variant< tcp_transport, unix_transport, pipe_transport > m_impl;
+#endif
+};
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/transport.ipp"
+#endif
+
+#endif // IRC_TRANSPORT_HPP
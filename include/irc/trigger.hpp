@@ -0,0 +1,193 @@
+/*
+    Name:        irc/trigger.hpp
+    Purpose:     Keywords and commands triggers matched in one pass
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_TRIGGER_HPP
+#define IRC_TRIGGER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include <boost/utility/string_view.hpp>
+
+namespace irc {
+
+/** How a trigger literal must appear in a message. */
+struct trigger_options
+{
+    trigger_options()
+    :   anchored(false),
+        whole_word(false),
+        case_sensitive(false)
+    {}
+
+    bool        anchored;       /**< Only at the start of the message, as "!help". */
+    bool        whole_word;     /**< Not inside a word. */
+    bool        case_sensitive; /**< Letters case matters. */
+    std::string regex;          /**< Searched in the whole message once the literal
+                                     matched, ECMAScript syntax, empty if none. */
+};
+/**
+    @class trigger_set
+
+    A registry of literal patterns compiled into one Aho-Corasick
+    automaton, so a message is scanned once, in one table lookup per
+    character, whatever the number of patterns. Only the patterns found
+    are then checked for their options and regular expression, and each
+    of them reported once per message.
+
+    Characters which appear in no pattern share one transition class,
+    so a message matching nothing only costs its scan. The automaton is
+    rebuilt by the first scan after patterns are added or removed.
+    Not thread safe.
+*/
+class trigger_set
+{
+public:
+/** Trigger identifier, stable until the trigger is removed. */
+    typedef std::uint32_t id_type;
+
+/** Invalid trigger identifier. */
+    static const id_type npos = 0xffffffff;
+
+/** Constructor. */
+    trigger_set();
+/**
+    Adds a trigger.
+    A trigger without literal and with a regex is checked on every message.
+    @param literal The text to find, ASCII letters fold unless case_sensitive.
+    @param opts    The trigger options.
+    @return The trigger identifier, npos if both literal and regex are
+            empty or regex is not valid.
+*/
+    id_type add( const std::string &literal, const trigger_options &opts = trigger_options() );
+/**
+    Removes a trigger.
+    @param id The trigger identifier.
+    @return @true if the trigger was removed, @false if id is unknown.
+*/
+    bool remove( id_type id );
+/**
+    Finds the triggers in a text.
+    func may add or remove triggers, the changes apply to the next scan.
+    @param text The text to scan.
+    @param func The function called for each trigger found, as
+                void(id_type id, std::size_t offset), offset being where
+                the literal starts.
+    @return The number of triggers found.
+*/
+    template< typename Func >
+    std::size_t scan( boost::string_view text, Func func );
+/** Builds the automaton now, instead of on the next scan. */
+    void compile();
+/** @return The number of triggers. */
+    std::size_t size() const { return m_size; }
+/** @return @true if there are no triggers. */
+    bool empty() const { return m_size == 0; }
+
+private:
+    struct pattern
+    {
+        std::string                 literal;
+        trigger_options             opts;
+        std::shared_ptr<std::regex> regex;
+        std::uint32_t               stamp; // Last scan which reported it
+        bool                        used;
+    };
+
+    static unsigned char fold( unsigned char ch )
+    {
+        return ch >= 'A' && ch <= 'Z' ? static_cast<unsigned char>( ch + 32 ) : ch;
+    }
+
+    static bool word_char( unsigned char ch )
+    {
+        return ( ch >= '0' && ch <= '9' ) || ( ch >= 'a' && ch <= 'z' ) ||
+               ( ch >= 'A' && ch <= 'Z' ) || ch == '_' || ch >= 0x80;
+    }
+
+    // Options, regex and once per scan, false if the hit must be ignored
+    bool accept( id_type id, boost::string_view text, std::size_t start );
+
+    std::vector<pattern>       m_patterns;
+    std::vector<id_type>       m_free,
+                               m_always;   // Regex only triggers
+    std::size_t                m_size;
+    bool                       m_dirty;
+    std::uint32_t              m_stamp;
+
+    unsigned char              m_class[256];
+    std::size_t                m_classes;
+    // Transitions hold the next state's row in m_delta, or'ed with
+    // output_flag when patterns end there, so the scan loop multiplies
+    // nothing and skips m_out for most characters
+    static const std::uint32_t output_flag = 0x80000000;
+
+    std::vector<std::uint32_t> m_delta,    // states * m_classes, complete
+                               m_out_begin,// Per state, in m_out
+                               m_out;      // Patterns ending at each state
+};
+
+template< typename Func >
+std::size_t trigger_set::scan( boost::string_view text, Func func )
+{
+    if( m_dirty )
+        compile();
+
+    if( !m_size )
+        return 0;
+
+    if( ++m_stamp == 0 )
+    {
+        for( pattern &p : m_patterns )
+            p.stamp = 0;
+        m_stamp = 1;
+    }
+
+    std::size_t   found = 0;
+    std::uint32_t row   = 0;
+    for( std::size_t i = 0; i < text.size(); ++i )
+    {
+        std::uint32_t next = m_delta[ row + m_class[ static_cast<unsigned char>( text[i] ) ] ];
+        row = next & ~output_flag;
+        if( !( next & output_flag ) )
+            continue;
+
+        std::size_t state = row / m_classes;
+        for( std::uint32_t o = m_out_begin[state]; o < m_out_begin[state + 1]; ++o )
+        {
+            id_type     id    = m_out[o];
+            std::size_t start = i + 1 - m_patterns[id].literal.size();
+            if( accept( id, text, start ) )
+            {
+                ++found;
+                func( id, start );
+            }
+        }
+    }
+
+    for( std::size_t i = 0; i < m_always.size(); ++i )
+    {
+        if( accept( m_always[i], text, 0 ) )
+        {
+            ++found;
+            func( m_always[i], 0 );
+        }
+    }
+    return found;
+}
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/trigger.ipp"
+#endif
+
+#endif // IRC_TRIGGER_HPP
@@ -0,0 +1,239 @@
+/*
+    Name:        irc/uring.hpp
+    Purpose:     Linux io_uring transport shared by many clients
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_URING_HPP
+#define IRC_URING_HPP
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+#include <boost/core/noncopyable.hpp>
+#include <boost/system/error_code.hpp>
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+struct io_uring_buf;
+
+namespace irc {
+
+/** uring_service sizes. */
+struct uring_options
+{
+    uring_options()
+    :   entries(4096),
+        buffers(1024),
+        buffer_size(4096)
+    {}
+
+    unsigned    entries;     /**< Submission queue entries, the completion queue has four times. */
+    unsigned    buffers;     /**< Receive buffers shared by all the connections,
+                                  a power of two up to 32768. */
+    std::size_t buffer_size; /**< Bytes per receive buffer. */
+};
+
+/** uring_service counters. */
+struct uring_stats
+{
+    uring_stats()
+    :   enters(0),
+        submitted(0),
+        completions(0),
+        received(0),
+        sent(0),
+        rearms(0)
+    {}
+
+    std::uint64_t enters,      /**< io_uring_enter calls, each one submits a batch. */
+                  submitted,   /**< Operations submitted. */
+                  completions, /**< Completions handled. */
+                  received,    /**< Bytes received. */
+                  sent,        /**< Bytes sent. */
+                  rearms;      /**< Receives started again after the buffers ran out. */
+};
+
+/** What a connection of a uring_service is told. */
+class uring_connection
+{
+public:
+/**
+    Bytes received, in a buffer given back to the ring on return.
+    @param data The bytes.
+    @param size The byte count.
+*/
+    virtual void uring_received( const char *data, std::size_t size ) = 0;
+/**
+    A send() completed.
+    @param ec    The error, if any.
+    @param bytes The bytes written.
+*/
+    virtual void uring_sent( const boost::system::error_code &ec, std::size_t bytes ) = 0;
+/**
+    Receiving ended, on end of file or on error.
+    @param ec The reason.
+*/
+    virtual void uring_closed( const boost::system::error_code &ec ) = 0;
+
+protected:
+    ~uring_connection() {}
+};
+/**
+    @class uring_service
+
+    Reads and writes sockets through one Linux io_uring, for processes with
+    many connections. Each connection has a multishot receive taking its
+    buffers from a ring shared by all of them, so idle connections hold no
+    receive buffer, and the operations queued while handling an event are
+    submitted together by one io_uring_enter, after it. Completions are
+    signalled to the io_context through an eventfd and handled on its
+    thread, as the ones of any other asio object.
+
+    Needs Linux 6.0 or later and building with IRC_CLIENT_HAS_IO_URING.
+    Not thread safe: used from the io_context thread only.
+*/
+class uring_service : public std::enable_shared_from_this< uring_service >
+                    , private boost::noncopyable
+{
+public:
+/** Shared uring service pointer */
+    typedef std::shared_ptr< uring_service > ptr;
+/** Connection identifier */
+    typedef std::uint32_t id_type;
+
+/** Invalid connection identifier. */
+    static const id_type npos = 0xffffffff;
+/**
+    Constructor, sets up the ring.
+    @param io   The io_context signalled of completions.
+    @param opts The ring sizes.
+    @throw boost::system::system_error If the kernel lacks io_uring or its features.
+*/
+    uring_service( boost::asio::io_context &io, const uring_options &opts );
+/** Destructor. */
+    ~uring_service();
+/**
+    Static constructor.
+    @param io   The io_context signalled of completions.
+    @param opts The ring sizes.
+    @return Shared pointer to a new uring service.
+*/
+    static ptr create( boost::asio::io_context &io, const uring_options &opts = uring_options() );
+/**
+    Adds a connected socket, which must be in blocking mode.
+    @param fd   The socket.
+    @param conn Told of its events until detach().
+    @return The connection identifier.
+*/
+    id_type attach( int fd, uring_connection *conn );
+/**
+    Removes a connection, cancelling its operations. The socket can be
+    closed right away, the connection is not told of anything more.
+    @param id The connection identifier.
+*/
+    void detach( id_type id );
+/**
+    Receives until stop_receive(), detach() or the end of the connection.
+    @param id The connection identifier.
+*/
+    void receive( id_type id );
+/**
+    Stops receiving, bytes already in flight may still be received.
+    @param id The connection identifier.
+*/
+    void stop_receive( id_type id );
+/**
+    Sends bytes, one send at a time per connection.
+    @param id   The connection identifier.
+    @param data The bytes, kept until uring_sent() or detach().
+    @param size The byte count.
+*/
+    void send( id_type id, const char *data, std::size_t size );
+/** @return The counters. */
+    const uring_stats &stats() const { return m_stats; }
+/** @return The attached connections. */
+    std::size_t connections() const { return m_channels.size() - m_free.size(); }
+
+private:
+    enum operation : std::uint64_t { op_receive = 0, op_send = 1, op_cancel = 2 };
+
+    struct channel
+    {
+        uring_connection *conn;
+        int               fd;
+        std::uint32_t     generation;
+        bool              receiving, // Operations in the kernel
+                          sending,
+                          wanted;    // Receiving is wanted
+        const char       *data;
+        std::size_t       left,
+                          done;
+    };
+
+    static std::uint64_t tag( id_type id, std::uint32_t generation, operation op )
+    {
+        return static_cast<std::uint64_t>( generation ) << 32 | std::uint64_t( id ) << 2 | op;
+    }
+
+    void shutdown();
+    io_uring_sqe *next_sqe();
+    void submit_receive( id_type id );
+    void submit_send( id_type id );
+    void cancel( std::uint64_t target );
+    void schedule_flush();
+    void flush();
+    void wait_completions();
+    void reap();
+    void complete( std::uint64_t user_data, int res, unsigned flags );
+    void recycle( unsigned bid );
+    void release( id_type id );
+
+    int                                   m_fd,
+                                          m_event;
+    boost::asio::io_context              &m_io;
+    boost::asio::posix::stream_descriptor m_notify;
+
+    void          *m_sq_ring,
+                  *m_cq_ring;
+    std::size_t    m_sq_size,
+                   m_cq_size;
+    io_uring_sqe  *m_sqes;
+    unsigned      *m_sq_head,
+                  *m_sq_tail,
+                  *m_sq_array,
+                  *m_cq_head,
+                  *m_cq_tail;
+    unsigned       m_sq_mask,
+                   m_sq_entries,
+                   m_cq_mask,
+                   m_sq_local,   // Tail of the queued entries
+                   m_sq_flushed; // Tail of the submitted ones
+    io_uring_cqe  *m_cqes;
+
+    io_uring_buf      *m_buf_ring;      // Its tail overlays the first entry
+    std::size_t        m_buf_ring_size;
+    std::unique_ptr<char[]> m_buffers;
+    uring_options      m_options;
+    unsigned           m_buf_tail;
+
+    std::vector<channel> m_channels;
+    std::vector<id_type> m_free;
+    uring_stats          m_stats;
+    std::size_t          m_pending;      // Operations without their last completion
+    bool                 m_flush_posted,
+                         m_waiting;
+};
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/uring.ipp"
+#endif
+
+#endif // IRC_URING_HPP
@@ -0,0 +1,159 @@
+/*
+    Name:        irc/worker_pool.hpp
+    Purpose:     Thread pool running callbacks in order per key
+    Author:      Andrea Zanellato
+    Modified by:
+    Created:     2026/10/18
+    Licence:     Boost Software License, Version 1.0
+*/
+#ifndef IRC_WORKER_POOL_HPP
+#define IRC_WORKER_POOL_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include <boost/core/noncopyable.hpp>
+
+namespace irc {
+
+/** Counters of a worker_pool key. */
+struct worker_key_stats
+{
+    typedef std::chrono::steady_clock clock;
+
+    worker_key_stats()
+    :   depth(0),
+        handled(0),
+        failed(0),
+        waited(clock::duration::zero()),
+        busy(clock::duration::zero()),
+        max_latency(clock::duration::zero())
+    {}
+
+    std::size_t     depth;       /**< Tasks queued or running. */
+    std::uint64_t   handled,     /**< Tasks run. */
+                    failed;      /**< Tasks which threw, the exception is dropped. */
+    clock::duration waited,      /**< Time spent queued by the tasks run. */
+                    busy,        /**< Time spent running them, busy / handled is
+                                      the mean handler latency. */
+                    max_latency; /**< Longest queued plus running time. */
+};
+/**
+    @class worker_pool
+
+    Runs tasks on a pool of threads, in order for each key and in parallel
+    for different keys. Each key is a serial queue: the first task posted
+    to an idle key schedules the queue on the pool, which runs one task and
+    schedules the queue again while it has more, so the busy keys take
+    turns on the threads and a slow key only holds one thread.
+
+    Keys are kept with their counters once used, until clear_idle().
+    All the members are thread safe.
+*/
+class worker_pool : private boost::noncopyable
+{
+public:
+/** Shared worker pool pointer */
+    typedef std::shared_ptr< worker_pool > ptr;
+/** Steady clock used by the counters */
+    typedef worker_key_stats::clock clock;
+/**
+    Constructor, starts the threads.
+    @param threads The number of threads, the hardware ones if 0.
+*/
+    explicit worker_pool( std::size_t threads = 0 );
+/** Destructor, waits for the queued tasks. */
+    ~worker_pool();
+/**
+    Static constructor.
+    @param threads The number of threads, the hardware ones if 0.
+    @return Shared pointer to a new worker pool.
+*/
+    static ptr create( std::size_t threads = 0 )
+    {
+        return std::make_shared< worker_pool >( threads );
+    }
+/**
+    Queues a task after the other tasks of its key.
+    @param key  The ordering key, a channel or a conversation.
+    @param task The task.
+*/
+    void post( const std::string &key, std::function<void()> task );
+/**
+    Returns the counters of a key.
+    @param key The ordering key.
+    @return The counters, all zero for an unknown key.
+*/
+    worker_key_stats stats( const std::string &key ) const;
+/**
+    Calls a function for the counters of every key, under the pool lock:
+    func must not post tasks.
+    @param func The function, as void(const std::string &, const worker_key_stats &).
+*/
+    template< typename Func >
+    void for_each( Func func ) const;
+/** @return The tasks queued or running, all keys together. */
+    std::size_t depth() const;
+/** Forgets the keys without queued tasks, with their counters. */
+    void clear_idle();
+/**
+    Waits for the queued tasks and stops the threads. Meanwhile tasks are
+    only taken for the keys still running, posting is ignored afterwards.
+*/
+    void join();
+/** @return The number of threads. */
+    std::size_t threads() const { return m_threads; }
+
+private:
+    struct task_entry
+    {
+        std::function<void()> task;
+        clock::time_point     queued;
+    };
+
+    struct serial_queue
+    {
+        serial_queue() : running(false) {}
+
+        std::deque<task_entry> tasks;
+        bool                   running;
+        worker_key_stats       stats;
+    };
+
+    typedef std::unordered_map< std::string, std::shared_ptr<serial_queue> > queue_map;
+
+    // Runs the first task of a queue, then schedules it again if needed
+    void run( std::shared_ptr<serial_queue> queue );
+
+    std::size_t              m_threads;
+    boost::asio::thread_pool m_pool;
+    mutable std::mutex       m_mutex;
+    queue_map                m_queues;
+    std::size_t              m_depth;
+    bool                     m_joining; // Set once join() starts
+};
+
+template< typename Func >
+void worker_pool::for_each( Func func ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    for( const queue_map::value_type &entry : m_queues )
+        func( entry.first, entry.second->stats );
+}
+
+} // namespace irc
+
+#ifdef IRC_CLIENT_HEADER_ONLY
+    #include "irc/impl/worker_pool.ipp"
+#endif
+
+#endif // IRC_WORKER_POOL_HPP